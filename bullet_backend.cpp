@@ -0,0 +1,100 @@
+#include "bullet_backend.h"
+
+// Ближайшее попадание только по динамическим телам: стены коробки пропускаются
+struct DynamicRayCallback : public btCollisionWorld::ClosestRayResultCallback {
+    DynamicRayCallback(const btVector3& from, const btVector3& to)
+        : btCollisionWorld::ClosestRayResultCallback(from, to) {
+    }
+
+    bool needsCollision(btBroadphaseProxy* proxy) const override {
+        const btCollisionObject* object = static_cast<const btCollisionObject*>(proxy->m_clientObject);
+        if (object->isStaticOrKinematicObject()) return false;
+        return btCollisionWorld::ClosestRayResultCallback::needsCollision(proxy);
+    }
+};
+
+BulletBackend::BulletBackend(const PhysicsWorldConfig& config) {
+    world.init(config);
+    world.createBoundaryWalls();
+}
+
+BulletBackend::~BulletBackend() {
+    world.removeObjects(objects, true);
+}
+
+void BulletBackend::spawnBody(int type, const glm::vec3& position, const PhysicsSettings& settings) {
+    PhysicsObject obj = world.createPhysicsObject(type, btVector3(position.x, position.y, position.z), settings);
+    world.addObject(obj, objects);
+}
+
+size_t BulletBackend::spawnBatch(int type, size_t count, const PhysicsSettings& settings) {
+    return world.spawnBatch(type, count, PhysicsWorld::boundaryRegion(0.0f), settings, objects);
+}
+
+void BulletBackend::clear(bool releaseMemory) {
+    world.removeObjects(objects, releaseMemory);
+    objects.clear();
+    if (releaseMemory) {
+        objects.shrink_to_fit();
+    }
+}
+
+void BulletBackend::step(float stepTime, const PhysicsSettings& settings) {
+    // Те же настройки, что PhysicsThread передает миру перед каждым шагом
+    world.setSleeping(settings.sleepingEnabled, settings.sleepLinearThreshold, settings.sleepAngularThreshold);
+    world.setCcdPolicy(settings.adaptiveCcd, settings.ccdMotionFraction);
+    world.setSolverSettings(settings);
+    world.setContactEvents(settings.contactEvents, settings.contactImpulseThreshold);
+    world.stepSimulation(stepTime);
+}
+
+void BulletBackend::readTransforms(float* positions, float* rotations, int* types) const {
+    for (size_t i = 0; i < objects.size(); ++i) {
+        const btTransform& transform = objects[i].rigidBody->getWorldTransform();
+        if (positions) {
+            const btVector3& origin = transform.getOrigin();
+            positions[i * 3 + 0] = origin.x();
+            positions[i * 3 + 1] = origin.y();
+            positions[i * 3 + 2] = origin.z();
+        }
+        if (rotations) {
+            btQuaternion rotation = transform.getRotation();
+            rotations[i * 4 + 0] = rotation.x();
+            rotations[i * 4 + 1] = rotation.y();
+            rotations[i * 4 + 2] = rotation.z();
+            rotations[i * 4 + 3] = rotation.w();
+        }
+        if (types) {
+            types[i] = objects[i].type;
+        }
+    }
+}
+
+void BulletBackend::applyImpulse(size_t body, const glm::vec3& impulse) {
+    if (body >= objects.size()) return;
+    btRigidBody* rigidBody = objects[body].rigidBody;
+    rigidBody->activate(true);
+    rigidBody->applyCentralImpulse(btVector3(impulse.x, impulse.y, impulse.z));
+}
+
+void BulletBackend::applyShake(const glm::vec2& windowVelocity, const PhysicsSettings& settings) {
+    world.applyForceToAll(objects.data(), objects.size(), windowVelocity, settings);
+}
+
+bool BulletBackend::raycast(const glm::vec3& from, const glm::vec3& to, RayHit& hit) const {
+    btVector3 rayFrom(from.x, from.y, from.z);
+    btVector3 rayTo(to.x, to.y, to.z);
+    DynamicRayCallback callback(rayFrom, rayTo);
+    world.rayTest(rayFrom, rayTo, callback);
+    if (!callback.hasHit()) return false;
+
+    hit.body = static_cast<size_t>(callback.m_collisionObject->getUserIndex());
+    hit.fraction = callback.m_closestHitFraction;
+    hit.point = glm::vec3(callback.m_hitPointWorld.x(), callback.m_hitPointWorld.y(), callback.m_hitPointWorld.z());
+    hit.normal = glm::vec3(callback.m_hitNormalWorld.x(), callback.m_hitNormalWorld.y(), callback.m_hitNormalWorld.z());
+    return true;
+}
+
+size_t BulletBackend::getMemoryUsage() const {
+    return world.getMemoryUsage() + objects.capacity() * sizeof(PhysicsObject);
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "physics.h"
+#include "physics_backend.h"
+#include <vector>
+
+// Bullet за общим интерфейсом: мир со всеми оптимизациями и список его объектов.
+// Приложение шагает его в PhysicsThread, консольные прогоны - напрямую
+class BulletBackend : public PhysicsBackend {
+public:
+    explicit BulletBackend(const PhysicsWorldConfig& config = PhysicsWorldConfig());
+    ~BulletBackend() override;
+
+    const char* getName() const override { return "bullet"; }
+
+    void spawnBody(int type, const glm::vec3& position, const PhysicsSettings& settings) override;
+    size_t spawnBatch(int type, size_t count, const PhysicsSettings& settings) override;
+    void clear(bool releaseMemory) override;
+    void step(float stepTime, const PhysicsSettings& settings) override;
+
+    size_t getBodyCount() const override { return objects.size(); }
+    void readTransforms(float* positions, float* rotations, int* types) const override;
+
+    void applyImpulse(size_t body, const glm::vec3& impulse) override;
+    void applyShake(const glm::vec2& windowVelocity, const PhysicsSettings& settings) override;
+    void wakeAll() override { world.wakeAll(); }
+
+    bool raycast(const glm::vec3& from, const glm::vec3& to, RayHit& hit) const override;
+
+    size_t getMemoryUsage() const override;
+
+    PhysicsWorld& getWorld() { return world; }
+    // Объекты мира для команд PhysicsThread, которым нужен сам Bullet
+    std::vector<PhysicsObject>& getObjects() { return objects; }
+
+private:
+    PhysicsWorld world;
+    // userIndex тела - его индекс здесь, по нему луч находит тело
+    std::vector<PhysicsObject> objects;
+};
\ No newline at end of file
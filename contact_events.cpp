@@ -0,0 +1,229 @@
+#include "contact_events.h"
+#include <bullet/btBulletCollisionCommon.h>
+#include <algorithm>
+#include <functional>
+
+ContactEventRing::ContactEventRing()
+    : mask(0)
+    , head(0)
+    , tail(0)
+    , dropped(0) {
+}
+
+void ContactEventRing::init(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) size <<= 1;
+    buffer.assign(size, ContactEvent());
+    mask = size - 1;
+    head = tail = 0;
+    dropped = 0;
+}
+
+void ContactEventRing::push(const ContactEvent& event) {
+    if (buffer.empty()) {
+        ++dropped;
+        return;
+    }
+    buffer[head & mask] = event;
+    ++head;
+    if (head - tail > buffer.size()) {
+        ++tail;
+        ++dropped;
+    }
+}
+
+size_t ContactEventRing::read(std::vector<ContactEvent>& events) {
+    size_t count = size();
+    events.resize(count);
+    // Непрочитанное лежит не больше чем двумя кусками: до конца буфера и с начала
+    size_t first = static_cast<size_t>(tail & mask);
+    size_t firstPart = std::min(count, buffer.size() - first);
+    std::copy(buffer.begin() + first, buffer.begin() + first + firstPart, events.begin());
+    std::copy(buffer.begin(), buffer.begin() + (count - firstPart), events.begin() + firstPart);
+    tail = head;
+    return count;
+}
+
+// Ручка по индексу в плотном списке; у стен индекс -1
+static BodyHandle bodyHandle(const btCollisionObject* body, const SlotMap<btRigidBody*>& bodies) {
+    int index = body->getUserIndex2();
+    if (index < 0 || index >= static_cast<int>(bodies.size())) return BodyHandle();
+    return bodies.handleAt(static_cast<size_t>(index));
+}
+
+static bool pairLess(const btCollisionObject* a0, const btCollisionObject* b0,
+    const btCollisionObject* a1, const btCollisionObject* b1) {
+    return a0 != a1 ? std::less<const btCollisionObject*>()(a0, a1) : std::less<const btCollisionObject*>()(b0, b1);
+}
+
+void ContactTracker::update(btDispatcher* dispatcher, float impulseThreshold, const SlotMap<btRigidBody*>& bodies,
+    ContactEventRing& ring) {
+    stats = ContactEventStats();
+    if (!removed.empty()) {
+        endRemovedPairs(bodies, ring);
+    }
+
+    // Касающиеся пары этого шага: импульс и самая нагруженная точка манифолда
+    current.clear();
+    const int manifoldCount = dispatcher->getNumManifolds();
+    for (int m = 0; m < manifoldCount; ++m) {
+        const btPersistentManifold* manifold = dispatcher->getManifoldByIndexInternal(m);
+        const int points = manifold->getNumContacts();
+        if (points == 0) continue;
+
+        TrackedPair pair;
+        const btCollisionObject* body0 = manifold->getBody0();
+        const btCollisionObject* body1 = manifold->getBody1();
+        const bool swapped = std::less<const btCollisionObject*>()(body1, body0);
+        pair.first = swapped ? body1 : body0;
+        pair.second = swapped ? body0 : body1;
+        pair.impulse = 0.0f;
+        pair.maxPointImpulse = -1.0f;
+        pair.reported = false;
+        for (int p = 0; p < points; ++p) {
+            const btManifoldPoint& point = manifold->getContactPoint(p);
+            pair.impulse += point.getAppliedImpulse();
+            if (point.getAppliedImpulse() > pair.maxPointImpulse) {
+                pair.maxPointImpulse = point.getAppliedImpulse();
+                // Нормаль манифолда направлена от body1 к body0; точку берем
+                // на том теле, которое в паре стоит вторым
+                const btVector3& position = swapped ? point.getPositionWorldOnA() : point.getPositionWorldOnB();
+                btVector3 normal = swapped ? -point.m_normalWorldOnB : point.m_normalWorldOnB;
+                for (int k = 0; k < 3; ++k) {
+                    pair.point[k] = position[k];
+                    pair.normal[k] = normal[k];
+                }
+            }
+        }
+        current.push_back(pair);
+    }
+
+    std::sort(current.begin(), current.end(), [](const TrackedPair& a, const TrackedPair& b) {
+        return pairLess(a.first, a.second, b.first, b.second);
+    });
+
+    // У тела против границы манифолд на каждую стену: сливаем в одну пару
+    size_t merged = 0;
+    for (size_t i = 0; i < current.size(); ++i) {
+        if (merged > 0 && current[merged - 1].first == current[i].first && current[merged - 1].second == current[i].second) {
+            TrackedPair& target = current[merged - 1];
+            target.impulse += current[i].impulse;
+            if (current[i].maxPointImpulse > target.maxPointImpulse) {
+                target.maxPointImpulse = current[i].maxPointImpulse;
+                std::copy(current[i].point, current[i].point + 3, target.point);
+                std::copy(current[i].normal, current[i].normal + 3, target.normal);
+            }
+        } else {
+            current[merged++] = current[i];
+        }
+    }
+    current.resize(merged);
+    stats.touchingPairs = static_cast<int>(merged);
+
+    // Слияние двух отсортированных списков: только в новом - начало касания,
+    // в обоих - продолжение, только в старом - конец
+    size_t p = 0;
+    for (TrackedPair& pair : current) {
+        while (p < previous.size() && pairLess(previous[p].first, previous[p].second, pair.first, pair.second)) {
+            if (previous[p].reported) emit(ContactEventType::End, previous[p], bodies, ring);
+            ++p;
+        }
+        if (p < previous.size() && previous[p].first == pair.first && previous[p].second == pair.second) {
+            pair.reported = previous[p].reported;
+            ++p;
+        }
+        // Пара из двух спящих тел (или спящего тела и стены) заморожена
+        const bool sleeping = !pair.first->isActive() && !pair.second->isActive();
+        if (pair.impulse >= impulseThreshold && !sleeping) {
+            emit(pair.reported ? ContactEventType::Persist : ContactEventType::Begin, pair, bodies, ring);
+            pair.reported = true;
+        }
+    }
+    for (; p < previous.size(); ++p) {
+        if (previous[p].reported) emit(ContactEventType::End, previous[p], bodies, ring);
+    }
+
+    previous.swap(current);
+}
+
+void ContactTracker::forgetBody(const btCollisionObject* body, BodyHandle handle) {
+    removed.push_back(std::make_pair(body, handle));
+}
+
+void ContactTracker::endAll(const SlotMap<btRigidBody*>& bodies, ContactEventRing& ring) {
+    if (!removed.empty()) {
+        endRemovedPairs(bodies, ring);
+    }
+    for (const TrackedPair& pair : previous) {
+        if (pair.reported) emit(ContactEventType::End, pair, bodies, ring);
+    }
+    reset();
+}
+
+void ContactTracker::reset() {
+    previous.clear();
+    current.clear();
+    removed.clear();
+    stats = ContactEventStats();
+}
+
+void ContactTracker::endRemovedPairs(const SlotMap<btRigidBody*>& bodies, ContactEventRing& ring) {
+    typedef std::pair<const btCollisionObject*, BodyHandle> RemovedBody;
+    std::sort(removed.begin(), removed.end(), [](const RemovedBody& a, const RemovedBody& b) {
+        return std::less<const btCollisionObject*>()(a.first, b.first);
+    });
+    // Ручка удаленного тела, если адрес в списке удаленных
+    auto findRemoved = [this](const btCollisionObject* body, BodyHandle& handle) {
+        auto it = std::lower_bound(removed.begin(), removed.end(), body, [](const RemovedBody& entry, const btCollisionObject* key) {
+            return std::less<const btCollisionObject*>()(entry.first, key);
+        });
+        if (it == removed.end() || it->first != body) return false;
+        handle = it->second;
+        return true;
+    };
+
+    // Удаленное тело уже не читаем - в событии его ручка, сохраненная при удалении
+    size_t kept = 0;
+    for (size_t i = 0; i < previous.size(); ++i) {
+        const TrackedPair& pair = previous[i];
+        BodyHandle firstHandle;
+        BodyHandle secondHandle;
+        bool firstRemoved = findRemoved(pair.first, firstHandle);
+        bool secondRemoved = findRemoved(pair.second, secondHandle);
+        if (!firstRemoved && !secondRemoved) {
+            previous[kept++] = pair;
+            continue;
+        }
+        if (pair.reported) {
+            ContactEvent event = {};
+            event.type = ContactEventType::End;
+            event.bodyA = firstRemoved ? firstHandle : bodyHandle(pair.first, bodies);
+            event.bodyB = secondRemoved ? secondHandle : bodyHandle(pair.second, bodies);
+            ring.push(event);
+            ++stats.ends;
+        }
+    }
+    previous.resize(kept);
+    removed.clear();
+}
+
+void ContactTracker::emit(ContactEventType type, const TrackedPair& pair, const SlotMap<btRigidBody*>& bodies,
+    ContactEventRing& ring) {
+    ContactEvent event;
+    event.type = type;
+    event.bodyA = bodyHandle(pair.first, bodies);
+    event.bodyB = bodyHandle(pair.second, bodies);
+    if (type == ContactEventType::End) {
+        event.impulse = 0.0f;
+        std::fill(event.point, event.point + 3, 0.0f);
+        std::fill(event.normal, event.normal + 3, 0.0f);
+        ++stats.ends;
+    } else {
+        event.impulse = pair.impulse;
+        std::copy(pair.point, pair.point + 3, event.point);
+        std::copy(pair.normal, pair.normal + 3, event.normal);
+        if (type == ContactEventType::Begin) ++stats.begins;
+        else ++stats.persists;
+    }
+    ring.push(event);
+}
\ No newline at end of file
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "slot_map.h"
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+class btDispatcher;
+class btCollisionObject;
+class btRigidBody;
+
+enum class ContactEventType : uint8_t {
+    Begin,   // пара впервые коснулась с импульсом не меньше порога
+    Persist, // касание продолжается и импульс снова не меньше порога
+    End      // касание, о начале которого было событие, закончилось
+};
+
+// Событие контакта пары тел за шаг. У стен ручка недействительна, у удаленного
+// тела в End - его последняя, уже устаревшая ручка
+struct ContactEvent {
+    ContactEventType type;
+    BodyHandle bodyA;
+    BodyHandle bodyB;
+    float impulse;   // сумма нормальных импульсов по всем точкам пары, у End - 0
+    float point[3];  // точка с наибольшим импульсом на теле B
+    float normal[3]; // нормаль от B к A
+};
+
+// Число событий и касающихся пар на последнем шаге
+struct ContactEventStats {
+    int touchingPairs = 0;
+    int begins = 0;
+    int persists = 0;
+    int ends = 0;
+};
+
+// Кольцо событий фиксированной емкости: память выделяется один раз, при
+// переполнении самые старые непрочитанные события перезаписываются
+class ContactEventRing {
+public:
+    ContactEventRing();
+
+    // Емкость округляется вверх до степени двойки; непрочитанное теряется
+    void init(size_t capacity);
+    void push(const ContactEvent& event);
+    // Все непрочитанные события одним пакетом, от старых к новым
+    size_t read(std::vector<ContactEvent>& events);
+    void clear() { tail = head; }
+
+    size_t size() const { return static_cast<size_t>(head - tail); }
+    size_t capacity() const { return buffer.size(); }
+    // Сколько событий перезаписано, не будучи прочитанными
+    uint64_t getDropped() const { return dropped; }
+
+private:
+    std::vector<ContactEvent> buffer;
+    uint64_t mask;
+    uint64_t head; // номер следующей записи
+    uint64_t tail; // номер первого непрочитанного события
+    uint64_t dropped;
+};
+
+// Сравнивает касающиеся пары из манифолдов диспетчера с прошлым шагом и пишет
+// в кольцо события начала, продолжения и конца касания. Пары хранятся
+// отсортированными по адресам тел в двух переиспользуемых массивах, поэтому
+// после разогрева шаг не выделяет память. Манифолды уснувших пар остаются с
+// последними импульсами - такие пары не дают событий, пока одно из тел не проснется.
+class ContactTracker {
+public:
+    // bodies - плотный список динамических тел мира, индекс тела в нем - userIndex2
+    void update(btDispatcher* dispatcher, float impulseThreshold, const SlotMap<btRigidBody*>& bodies,
+        ContactEventRing& ring);
+    // Тело удалено из мира: его пары закончатся на следующем update,
+    // а адрес может достаться новому телу
+    void forgetBody(const btCollisionObject* body, BodyHandle handle);
+    // Все тела удаляются разом: о каждой отслеженной паре, о которой было
+    // событие начала, - событие конца. Вызывается до удаления тел
+    void endAll(const SlotMap<btRigidBody*>& bodies, ContactEventRing& ring);
+    // Забыть все пары без событий конца - например, после выключения событий
+    void reset();
+
+    ContactEventStats getStats() const { return stats; }
+
+private:
+    struct TrackedPair {
+        const btCollisionObject* first;  // меньший адрес пары
+        const btCollisionObject* second;
+        float impulse;
+        float maxPointImpulse;
+        float point[3];
+        float normal[3]; // от second к first
+        bool reported;   // о начале касания было событие
+    };
+
+    void endRemovedPairs(const SlotMap<btRigidBody*>& bodies, ContactEventRing& ring);
+    void emit(ContactEventType type, const TrackedPair& pair, const SlotMap<btRigidBody*>& bodies,
+        ContactEventRing& ring);
+
+    std::vector<TrackedPair> previous;
+    std::vector<TrackedPair> current;
+    std::vector<std::pair<const btCollisionObject*, BodyHandle>> removed;
+    ContactEventStats stats;
+};
\ No newline at end of file
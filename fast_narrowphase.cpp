@@ -0,0 +1,322 @@
+#include "fast_narrowphase.h"
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+#include <new>
+
+// Наклон опорного направления к стене: у цилиндров и конусов опорная точка
+// по нормали неоднозначна, наклоненные направления дают точки обода
+static const btScalar SUPPORT_TILT = 0.2f;
+
+BoundaryConvexAlgorithm::BoundaryConvexAlgorithm(const btCollisionAlgorithmConstructionInfo& ci,
+    const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap, bool swapped, btScalar innerExtent)
+    : btActivatingCollisionAlgorithm(ci, body0Wrap, body1Wrap)
+    , swapped(swapped)
+    , innerExtent(innerExtent) {
+    const btCollisionObjectWrapper* convexWrap = swapped ? body1Wrap : body0Wrap;
+    const btCollisionShape* shape = convexWrap->getCollisionShape();
+    // Форма тела не меняется за время жизни пары - границы считаем один раз
+    shape->getBoundingSphere(boundingCenter, boundingRadius);
+    breakingThreshold = shape->getContactBreakingThreshold(gContactBreakingThreshold);
+    for (int i = 0; i < WALL_COUNT; ++i) {
+        manifolds[i] = nullptr;
+    }
+}
+
+BoundaryConvexAlgorithm::~BoundaryConvexAlgorithm() {
+    for (int i = 0; i < WALL_COUNT; ++i) {
+        if (manifolds[i]) {
+            m_dispatcher->releaseManifold(manifolds[i]);
+        }
+    }
+}
+
+void BoundaryConvexAlgorithm::processCollision(const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap,
+    const btDispatcherInfo& dispatchInfo, btManifoldResult* resultOut) {
+    (void)dispatchInfo;
+    const btCollisionObjectWrapper* convexWrap = swapped ? body1Wrap : body0Wrap;
+    const btCollisionObjectWrapper* boundaryWrap = swapped ? body0Wrap : body1Wrap;
+    const btConvexShape* convex = static_cast<const btConvexShape*>(convexWrap->getCollisionShape());
+
+    // Все считаем в системе координат коробки, где стены - плоскости по осям
+    const btTransform& boundaryTrans = boundaryWrap->getWorldTransform();
+    btTransform relative = boundaryTrans.inverseTimes(convexWrap->getWorldTransform());
+    btVector3 center = relative(boundingCenter);
+
+    for (int wall = 0; wall < WALL_COUNT; ++wall) {
+        int axis = wall / 2;
+        // Стена +x имеет нормаль внутрь -x, стена -x - нормаль +x
+        btScalar sign = (wall % 2 == 0) ? -1.0f : 1.0f;
+        btPersistentManifold*& manifold = manifolds[wall];
+
+        // Расстояние описанной сферы до стены. Далеко - только сбрасываем старые точки
+        btScalar sphereDistance = sign * center[axis] + innerExtent - boundingRadius;
+        if (sphereDistance > breakingThreshold) {
+            if (manifold && manifold->getNumContacts() > 0) {
+                manifold->clearManifold();
+            }
+            continue;
+        }
+
+        if (!manifold) {
+            manifold = m_dispatcher->getNewManifold(convexWrap->getCollisionObject(), boundaryWrap->getCollisionObject());
+        }
+        resultOut->setPersistentManifold(manifold);
+        // Индекс стены как индекс дочерней формы compound
+        if (swapped) {
+            resultOut->setShapeIdentifiersA(-1, wall);
+        } else {
+            resultOut->setShapeIdentifiersB(-1, wall);
+        }
+
+        btVector3 normal(0, 0, 0);
+        normal[axis] = sign;
+        btVector3 worldNormal = boundaryTrans.getBasis() * normal;
+
+        // Точка тела p в координатах коробки превращается в контакт с глубиной
+        // n.p + innerExtent и точкой на стене, смещенной от p вдоль нормали
+        auto addPoint = [&](const btVector3& p) {
+            btScalar distance = sign * p[axis] + innerExtent;
+            resultOut->addContactPoint(worldNormal, boundaryTrans(p - normal * distance), distance);
+        };
+
+        switch (convex->getShapeType()) {
+            case SPHERE_SHAPE_PROXYTYPE: {
+                btScalar radius = static_cast<const btSphereShape*>(convex)->getRadius();
+                addPoint(relative.getOrigin() - normal * radius);
+                break;
+            }
+            case BOX_SHAPE_PROXYTYPE: {
+                btVector3 halfExtents = static_cast<const btBoxShape*>(convex)->getHalfExtentsWithMargin();
+                for (int corner = 0; corner < 8; ++corner) {
+                    btVector3 local(
+                        (corner & 1) ? halfExtents.x() : -halfExtents.x(),
+                        (corner & 2) ? halfExtents.y() : -halfExtents.y(),
+                        (corner & 4) ? halfExtents.z() : -halfExtents.z());
+                    btVector3 p = relative(local);
+                    if (sign * p[axis] + innerExtent <= breakingThreshold) {
+                        addPoint(p);
+                    }
+                }
+                break;
+            }
+            default: {
+                // Опорная точка к стене и четыре наклоненных вокруг нормали
+                btVector3 tangent0, tangent1;
+                btPlaneSpace1(normal, tangent0, tangent1);
+                const btVector3 directions[5] = {
+                    -normal,
+                    -normal + tangent0 * SUPPORT_TILT,
+                    -normal - tangent0 * SUPPORT_TILT,
+                    -normal + tangent1 * SUPPORT_TILT,
+                    -normal - tangent1 * SUPPORT_TILT
+                };
+                for (const btVector3& direction : directions) {
+                    btVector3 local = convex->localGetSupportingVertex(direction * relative.getBasis());
+                    addPoint(relative(local));
+                }
+                break;
+            }
+        }
+        resultOut->refreshContactPoints();
+    }
+}
+
+btScalar BoundaryConvexAlgorithm::calculateTimeOfImpact(btCollisionObject* body0, btCollisionObject* body1,
+    const btDispatcherInfo& dispatchInfo, btManifoldResult* resultOut) {
+    (void)body0;
+    (void)body1;
+    (void)dispatchInfo;
+    (void)resultOut;
+    // CCD со стенами выполняет свип тела в integrateTransforms мира
+    return 1.0f;
+}
+
+void BoundaryConvexAlgorithm::getAllContactManifolds(btManifoldArray& manifoldArray) {
+    for (int i = 0; i < WALL_COUNT; ++i) {
+        if (manifolds[i]) {
+            manifoldArray.push_back(manifolds[i]);
+        }
+    }
+}
+
+// Ближайшая к p точка поверхности коробки в ее локальных координатах.
+// Возвращает расстояние со знаком (внутри - отрицательное) и нормаль наружу
+static btScalar closestOnBox(const btVector3& halfExtents, const btVector3& p, btVector3& surface, btVector3& normal) {
+    btVector3 clamped(
+        std::clamp(p.x(), -halfExtents.x(), halfExtents.x()),
+        std::clamp(p.y(), -halfExtents.y(), halfExtents.y()),
+        std::clamp(p.z(), -halfExtents.z(), halfExtents.z()));
+    btVector3 delta = p - clamped;
+    btScalar length2 = delta.length2();
+    if (length2 > SIMD_EPSILON * SIMD_EPSILON) {
+        btScalar length = btSqrt(length2);
+        normal = delta / length;
+        surface = clamped;
+        return length;
+    }
+
+    // Центр внутри: выталкиваем через ближайшую грань
+    int axis = 0;
+    btScalar depth = halfExtents[0] - btFabs(p[0]);
+    for (int i = 1; i < 3; ++i) {
+        btScalar faceDepth = halfExtents[i] - btFabs(p[i]);
+        if (faceDepth < depth) {
+            depth = faceDepth;
+            axis = i;
+        }
+    }
+    normal.setZero();
+    normal[axis] = p[axis] < 0 ? -1.0f : 1.0f;
+    surface = p;
+    surface[axis] = normal[axis] * halfExtents[axis];
+    return -depth;
+}
+
+// То же для цилиндра с осью upAxis, радиусом radius и полувысотой halfHeight
+static btScalar closestOnCylinder(int upAxis, btScalar radius, btScalar halfHeight, const btVector3& p,
+    btVector3& surface, btVector3& normal) {
+    int axisA = (upAxis + 1) % 3;
+    int axisB = (upAxis + 2) % 3;
+    btScalar radialLength = btSqrt(p[axisA] * p[axisA] + p[axisB] * p[axisB]);
+    btScalar height = p[upAxis];
+
+    if (radialLength > radius || btFabs(height) > halfHeight) {
+        btScalar radialScale = radialLength > radius ? radius / radialLength : 1.0f;
+        surface[axisA] = p[axisA] * radialScale;
+        surface[axisB] = p[axisB] * radialScale;
+        surface[upAxis] = std::clamp(height, -halfHeight, halfHeight);
+        btVector3 delta = p - surface;
+        btScalar length = delta.length();
+        normal = length > SIMD_EPSILON ? delta / length : btVector3(0, 0, 0);
+        if (length <= SIMD_EPSILON) {
+            normal[upAxis] = height < 0 ? -1.0f : 1.0f;
+        }
+        return length;
+    }
+
+    btScalar capDepth = halfHeight - btFabs(height);
+    btScalar sideDepth = radius - radialLength;
+    normal.setZero();
+    surface = p;
+    if (capDepth < sideDepth || radialLength <= SIMD_EPSILON) {
+        normal[upAxis] = height < 0 ? -1.0f : 1.0f;
+        surface[upAxis] = normal[upAxis] * halfHeight;
+        return -capDepth;
+    }
+    normal[axisA] = p[axisA] / radialLength;
+    normal[axisB] = p[axisB] / radialLength;
+    surface[axisA] = normal[axisA] * radius;
+    surface[axisB] = normal[axisB] * radius;
+    return -sideDepth;
+}
+
+SphereConvexAlgorithm::SphereConvexAlgorithm(const btCollisionAlgorithmConstructionInfo& ci,
+    const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap, bool swapped)
+    : btActivatingCollisionAlgorithm(ci, body0Wrap, body1Wrap)
+    , swapped(swapped) {
+    const btCollisionObjectWrapper* sphereWrap = swapped ? body1Wrap : body0Wrap;
+    const btCollisionObjectWrapper* otherWrap = swapped ? body0Wrap : body1Wrap;
+    manifold = m_dispatcher->getNewManifold(sphereWrap->getCollisionObject(), otherWrap->getCollisionObject());
+}
+
+SphereConvexAlgorithm::~SphereConvexAlgorithm() {
+    if (manifold) {
+        m_dispatcher->releaseManifold(manifold);
+    }
+}
+
+void SphereConvexAlgorithm::processCollision(const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap,
+    const btDispatcherInfo& dispatchInfo, btManifoldResult* resultOut) {
+    (void)dispatchInfo;
+    const btCollisionObjectWrapper* sphereWrap = swapped ? body1Wrap : body0Wrap;
+    const btCollisionObjectWrapper* otherWrap = swapped ? body0Wrap : body1Wrap;
+    resultOut->setPersistentManifold(manifold);
+
+    btScalar radius = static_cast<const btSphereShape*>(sphereWrap->getCollisionShape())->getRadius();
+    const btTransform& otherTrans = otherWrap->getWorldTransform();
+    btVector3 center = otherTrans.invXform(sphereWrap->getWorldTransform().getOrigin());
+
+    btVector3 surface;
+    btVector3 normal;
+    btScalar distance;
+    const btCollisionShape* other = otherWrap->getCollisionShape();
+    if (other->getShapeType() == BOX_SHAPE_PROXYTYPE) {
+        btVector3 halfExtents = static_cast<const btBoxShape*>(other)->getHalfExtentsWithMargin();
+        distance = closestOnBox(halfExtents, center, surface, normal);
+    } else {
+        const btCylinderShape* cylinder = static_cast<const btCylinderShape*>(other);
+        int upAxis = cylinder->getUpAxis();
+        btScalar halfHeight = cylinder->getHalfExtentsWithMargin()[upAxis];
+        distance = closestOnCylinder(upAxis, cylinder->getRadius(), halfHeight, center, surface, normal);
+    }
+
+    // Нормаль от второго тела manifold (коробки или цилиндра) к сфере
+    resultOut->addContactPoint(otherTrans.getBasis() * normal, otherTrans(surface), distance - radius);
+    resultOut->refreshContactPoints();
+}
+
+btScalar SphereConvexAlgorithm::calculateTimeOfImpact(btCollisionObject* body0, btCollisionObject* body1,
+    const btDispatcherInfo& dispatchInfo, btManifoldResult* resultOut) {
+    (void)body0;
+    (void)body1;
+    (void)dispatchInfo;
+    (void)resultOut;
+    return 1.0f;
+}
+
+void SphereConvexAlgorithm::getAllContactManifolds(btManifoldArray& manifoldArray) {
+    if (manifold) {
+        manifoldArray.push_back(manifold);
+    }
+}
+
+FastNarrowphase::FastNarrowphase() {
+    swappedSphereCreateFunc.m_swapped = true;
+    swappedBoundaryCreateFunc.m_swapped = true;
+}
+
+int FastNarrowphase::getMaxAlgorithmSize() {
+    return static_cast<int>(std::max(sizeof(BoundaryConvexAlgorithm), sizeof(SphereConvexAlgorithm)));
+}
+
+btCollisionAlgorithm* FastNarrowphase::SphereCreateFunc::CreateCollisionAlgorithm(btCollisionAlgorithmConstructionInfo& ci,
+    const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap) {
+    void* memory = ci.m_dispatcher1->allocateCollisionAlgorithm(sizeof(SphereConvexAlgorithm));
+    return new (memory) SphereConvexAlgorithm(ci, body0Wrap, body1Wrap, m_swapped);
+}
+
+btCollisionAlgorithm* FastNarrowphase::BoundaryCreateFunc::CreateCollisionAlgorithm(btCollisionAlgorithmConstructionInfo& ci,
+    const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap) {
+    const btCollisionObjectWrapper* compoundWrap = m_swapped ? body0Wrap : body1Wrap;
+    if (compoundWrap->getCollisionShape() != boundaryShape) {
+        // Обычный compound - стандартный алгоритм для этой пары типов
+        btCollisionAlgorithmCreateFunc* fallback = configuration->getCollisionAlgorithmCreateFunc(
+            body0Wrap->getCollisionShape()->getShapeType(), body1Wrap->getCollisionShape()->getShapeType());
+        return fallback->CreateCollisionAlgorithm(ci, body0Wrap, body1Wrap);
+    }
+    void* memory = ci.m_dispatcher1->allocateCollisionAlgorithm(sizeof(BoundaryConvexAlgorithm));
+    return new (memory) BoundaryConvexAlgorithm(ci, body0Wrap, body1Wrap, m_swapped, innerExtent);
+}
+
+void FastNarrowphase::registerSphereAlgorithms(btCollisionDispatcher* dispatcher) {
+    // Сфера-сфера и коробка-коробка в Bullet уже аналитические; через GJK идут
+    // пары сферы с коробкой и цилиндром
+    dispatcher->registerCollisionCreateFunc(SPHERE_SHAPE_PROXYTYPE, BOX_SHAPE_PROXYTYPE, &sphereCreateFunc);
+    dispatcher->registerCollisionCreateFunc(BOX_SHAPE_PROXYTYPE, SPHERE_SHAPE_PROXYTYPE, &swappedSphereCreateFunc);
+    dispatcher->registerCollisionCreateFunc(SPHERE_SHAPE_PROXYTYPE, CYLINDER_SHAPE_PROXYTYPE, &sphereCreateFunc);
+    dispatcher->registerCollisionCreateFunc(CYLINDER_SHAPE_PROXYTYPE, SPHERE_SHAPE_PROXYTYPE, &swappedSphereCreateFunc);
+}
+
+void FastNarrowphase::registerBoundaryAlgorithms(btCollisionDispatcher* dispatcher, btCollisionConfiguration* configuration,
+    const btCollisionShape* boundaryShape, btScalar innerExtent) {
+    for (BoundaryCreateFunc* createFunc : { &boundaryCreateFunc, &swappedBoundaryCreateFunc }) {
+        createFunc->configuration = configuration;
+        createFunc->boundaryShape = boundaryShape;
+        createFunc->innerExtent = innerExtent;
+    }
+    for (int type = 0; type < CONCAVE_SHAPES_START_HERE; ++type) {
+        dispatcher->registerCollisionCreateFunc(type, COMPOUND_SHAPE_PROXYTYPE, &boundaryCreateFunc);
+        dispatcher->registerCollisionCreateFunc(COMPOUND_SHAPE_PROXYTYPE, type, &swappedBoundaryCreateFunc);
+    }
+}
\ No newline at end of file
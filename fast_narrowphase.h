@@ -0,0 +1,90 @@
+#pragma once
+
+#include <bullet/btBulletCollisionCommon.h>
+#include <bullet/BulletCollision/CollisionDispatch/btActivatingCollisionAlgorithm.h>
+#include <bullet/BulletCollision/CollisionDispatch/btCollisionCreateFunc.h>
+#include <bullet/BulletCollision/CollisionDispatch/btCollisionObjectWrapper.h>
+#include <bullet/BulletCollision/CollisionDispatch/btManifoldResult.h>
+
+// Тело против коробки-границы. Вместо обхода шести дочерних коробок compound
+// и GJK с каждой стена считается полупространством: сфера - по центру, коробка -
+// по восьми углам, остальные выпуклые формы - по опорным точкам к стене.
+// На каждую стену свой manifold, как у дочерних алгоритмов compound.
+class BoundaryConvexAlgorithm : public btActivatingCollisionAlgorithm {
+public:
+    BoundaryConvexAlgorithm(const btCollisionAlgorithmConstructionInfo& ci, const btCollisionObjectWrapper* body0Wrap,
+        const btCollisionObjectWrapper* body1Wrap, bool swapped, btScalar innerExtent);
+    ~BoundaryConvexAlgorithm() override;
+
+    void processCollision(const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap,
+        const btDispatcherInfo& dispatchInfo, btManifoldResult* resultOut) override;
+    btScalar calculateTimeOfImpact(btCollisionObject* body0, btCollisionObject* body1,
+        const btDispatcherInfo& dispatchInfo, btManifoldResult* resultOut) override;
+    void getAllContactManifolds(btManifoldArray& manifoldArray) override;
+
+    // Порядок стен совпадает с дочерними формами createBoundaryWalls: +x, -x, +y, -y, +z, -z
+    static const int WALL_COUNT = 6;
+
+private:
+    bool swapped;          // граница - первое тело пары
+    btScalar innerExtent;  // расстояние от центра коробки до внутренней грани стены
+    btScalar breakingThreshold;
+    btVector3 boundingCenter;
+    btScalar boundingRadius;
+    btPersistentManifold* manifolds[WALL_COUNT];
+};
+
+// Сфера против коробки или цилиндра: ближайшая точка поверхности считается
+// аналитически вместо GJK/EPA общего выпуклого алгоритма
+class SphereConvexAlgorithm : public btActivatingCollisionAlgorithm {
+public:
+    SphereConvexAlgorithm(const btCollisionAlgorithmConstructionInfo& ci, const btCollisionObjectWrapper* body0Wrap,
+        const btCollisionObjectWrapper* body1Wrap, bool swapped);
+    ~SphereConvexAlgorithm() override;
+
+    void processCollision(const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap,
+        const btDispatcherInfo& dispatchInfo, btManifoldResult* resultOut) override;
+    btScalar calculateTimeOfImpact(btCollisionObject* body0, btCollisionObject* body1,
+        const btDispatcherInfo& dispatchInfo, btManifoldResult* resultOut) override;
+    void getAllContactManifolds(btManifoldArray& manifoldArray) override;
+
+private:
+    bool swapped; // сфера - второе тело пары
+    btPersistentManifold* manifold;
+};
+
+// Владеет функциями создания быстрых алгоритмов и регистрирует их в диспетчере.
+// Должен жить дольше диспетчера, в котором зарегистрирован.
+class FastNarrowphase {
+public:
+    FastNarrowphase();
+
+    // Размер самого большого алгоритма - для пула алгоритмов конфигурации
+    static int getMaxAlgorithmSize();
+
+    void registerSphereAlgorithms(btCollisionDispatcher* dispatcher);
+    // Пары выпуклых тел с boundaryShape получают BoundaryConvexAlgorithm,
+    // пары с другими compound-формами - алгоритм конфигурации по умолчанию
+    void registerBoundaryAlgorithms(btCollisionDispatcher* dispatcher, btCollisionConfiguration* configuration,
+        const btCollisionShape* boundaryShape, btScalar innerExtent);
+
+private:
+    struct SphereCreateFunc : public btCollisionAlgorithmCreateFunc {
+        btCollisionAlgorithm* CreateCollisionAlgorithm(btCollisionAlgorithmConstructionInfo& ci,
+            const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap) override;
+    };
+
+    struct BoundaryCreateFunc : public btCollisionAlgorithmCreateFunc {
+        btCollisionConfiguration* configuration = nullptr;
+        const btCollisionShape* boundaryShape = nullptr;
+        btScalar innerExtent = 0;
+
+        btCollisionAlgorithm* CreateCollisionAlgorithm(btCollisionAlgorithmConstructionInfo& ci,
+            const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap) override;
+    };
+
+    SphereCreateFunc sphereCreateFunc;
+    SphereCreateFunc swappedSphereCreateFunc;
+    BoundaryCreateFunc boundaryCreateFunc;
+    BoundaryCreateFunc swappedBoundaryCreateFunc;
+};
\ No newline at end of file
@@ -1,8 +1,10 @@
 #include "gui.h"
 
 #include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <cstdint>
 
-GUI::GUI() : initialized(false) {}
+GUI::GUI() : initialized(false), batchType(0), batchCount(1000), profilerPaused(false), profilerFrames(240) {}
 
 GUI::~GUI() {
     cleanup();
@@ -62,15 +64,64 @@ void GUI::renderSettings(PhysicsSettings& settings) {
         ImGui::SliderFloat("Air Resistance", &settings.damping, 0.0f, 1.0f, "%.2f");
     }
     
+    if (ImGui::CollapsingHeader("Simulation")) {
+        ImGui::SliderFloat("Tick Rate", &settings.tickRate, 30.0f, 240.0f, "%.0f Hz");
+        ImGui::SliderInt("Max Catch-up Steps", &settings.maxCatchUpSteps, 1, 10);
+        ImGui::Checkbox("Adaptive CCD", &settings.adaptiveCcd);
+        ImGui::SliderFloat("CCD Motion Fraction", &settings.ccdMotionFraction, 0.1f, 1.0f, "%.2f");
+        ImGui::Checkbox("Contact Events", &settings.contactEvents);
+        ImGui::SliderFloat("Contact Impulse Threshold", &settings.contactImpulseThreshold, 0.0f, 10.0f, "%.2f");
+    }
+    
+    if (ImGui::CollapsingHeader("Solver")) {
+        const char* solvers[] = { "Sequential Impulse", "NNCG" };
+        ImGui::Combo("Solver Type", &settings.solverType, solvers, 2);
+        ImGui::Checkbox("Adaptive Iterations", &settings.adaptiveSolver);
+        ImGui::SliderInt("Min Iterations", &settings.minSolverIterations, 1, 50);
+        ImGui::SliderInt("Max Iterations", &settings.maxSolverIterations, 1, 50);
+        ImGui::SliderFloat("Solver Budget", &settings.solverBudgetMs, 0.5f, 16.0f, "%.1f ms");
+        ImGui::SliderFloat("Residual Threshold", &settings.solverResidualThreshold, 0.0f, 0.01f, "%.4f");
+        if (settings.adaptiveSolver && settings.solverResidualThreshold > 0.0f) {
+            ImGui::Text("Early exit on: fixed Max Iterations");
+        }
+    }
+    
+    if (ImGui::CollapsingHeader("Sleeping")) {
+        ImGui::Checkbox("Enable Sleeping", &settings.sleepingEnabled);
+        ImGui::SliderFloat("Linear Threshold", &settings.sleepLinearThreshold, 0.0f, 2.0f, "%.2f");
+        ImGui::SliderFloat("Angular Threshold", &settings.sleepAngularThreshold, 0.0f, 2.0f, "%.2f");
+    }
+    
     if (ImGui::CollapsingHeader("Object Properties")) {
         ImGui::ColorEdit3("Cube Color", glm::value_ptr(settings.cubeColor));
         ImGui::SliderFloat("Mass Scale", &settings.massScale, 0.1f, 2.0f);
+        ImGui::Checkbox("Release Memory On Clear", &settings.releaseMemoryOnClear);
     }
     
     ImGui::End();
 }
 
-void GUI::renderControls(std::function<void(int)> spawnCallback, std::function<void()> clearCallback) {
+void GUI::renderStats(const PhysicsStats& stats) {
+    ImGui::Begin("Statistics");
+    
+    ImGui::Text("Active Bodies: %d", stats.activeBodies);
+    ImGui::Text("Sleeping Bodies: %d", stats.sleepingBodies);
+    ImGui::Text("CCD Armed: %d", stats.ccdArmed);
+    ImGui::Text("Solver: %s, %d iterations, %.2f ms", stats.solverType == 1 ? "NNCG" : "Sequential Impulse",
+        stats.solverIterations, stats.solveMs);
+    ImGui::Text("Contact Events (total): %llu begin, %llu persist, %llu end",
+        static_cast<unsigned long long>(stats.contactBegins),
+        static_cast<unsigned long long>(stats.contactPersists),
+        static_cast<unsigned long long>(stats.contactEnds));
+    if (stats.particles > 0) {
+        ImGui::Text("Particles: %d, %d contacts, %.2f ms", stats.particles, stats.particleContacts, stats.particleStepMs);
+    }
+    
+    ImGui::End();
+}
+
+void GUI::renderControls(std::function<void(int)> spawnCallback, std::function<void(int, int)> spawnBatchCallback,
+    std::function<void()> clearCallback) {
     ImGui::Begin("Controls");
     
     if (ImGui::Button("Spawn Cube")) {
@@ -87,9 +138,130 @@ void GUI::renderControls(std::function<void(int)> spawnCallback, std::function<v
         spawnCallback(2);
     }
 
+    // Пакет тел раскладывается по свободным местам коробки без пересечений
+    const char* types[] = { "Cube", "Sphere", "Cylinder" };
+    ImGui::Combo("Batch Type", &batchType, types, 3);
+    ImGui::InputInt("Batch Count", &batchCount, 100, 1000);
+    batchCount = std::max(1, std::min(batchCount, 100000));
+    if (ImGui::Button("Spawn N")) {
+        spawnBatchCallback(batchType, batchCount);
+    }
+
     if (ImGui::Button("Clear All Objects")) {
         clearCallback();
     }
     
+    ImGui::End();
+}
+
+// Цвет зоны по хешу имени: одна и та же зона одного цвета во всех кадрах
+static ImU32 zoneColor(const char* name) {
+    uint32_t hash = 2166136261u;
+    for (const char* c = name; *c; ++c) {
+        hash = (hash ^ static_cast<uint8_t>(*c)) * 16777619u;
+    }
+    return ImColor::HSV((hash % 360) / 360.0f, 0.55f, 0.75f);
+}
+
+// Полоса в стиле flame graph: корневые зоны идут подряд, дети лежат под
+// родителем, ширина пропорциональна времени. scaleMs - время на всю ширину
+static void renderFlameBar(const char* id, const std::vector<ProfileZone>& zones, float scaleMs) {
+    const float rowHeight = ImGui::GetTextLineHeight() + 4.0f;
+    int maxDepth = 0;
+    for (const ProfileZone& zone : zones) {
+        maxDepth = std::max(maxDepth, zone.depth);
+    }
+    ImVec2 origin = ImGui::GetCursorScreenPos();
+    ImVec2 size(ImGui::GetContentRegionAvail().x, rowHeight * (maxDepth + 1));
+    ImGui::InvisibleButton(id, size);
+    if (zones.empty() || scaleMs <= 0.0f) return;
+
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    drawList->PushClipRect(origin, ImVec2(origin.x + size.x, origin.y + size.y), true);
+    const float pixelsPerMs = size.x / scaleMs;
+    std::vector<float> cursor(zones.size());
+    float rootCursor = 0.0f;
+    for (size_t i = 0; i < zones.size(); ++i) {
+        const ProfileZone& zone = zones[i];
+        // Родитель всегда раньше в массиве, дети занимают его полосу слева направо
+        float& parentCursor = zone.parent >= 0 ? cursor[zone.parent] : rootCursor;
+        float start = parentCursor;
+        cursor[i] = start;
+        parentCursor += zone.ms;
+
+        ImVec2 min(origin.x + start * pixelsPerMs, origin.y + zone.depth * rowHeight);
+        ImVec2 max(min.x + zone.ms * pixelsPerMs, min.y + rowHeight - 1.0f);
+        if (max.x - min.x < 1.0f) continue;
+        drawList->AddRectFilled(min, max, zoneColor(zone.name));
+        if (ImGui::CalcTextSize(zone.name).x + 4.0f < max.x - min.x) {
+            drawList->AddText(ImVec2(min.x + 2.0f, min.y + 2.0f), IM_COL32(0, 0, 0, 255), zone.name);
+        }
+        // Дети рисуются позже родителей, поэтому подсказка у самой глубокой зоны
+        if (ImGui::IsMouseHoveringRect(min, max)) {
+            ImGui::SetTooltip("%s: %.3f ms", zone.name, zone.ms);
+        }
+    }
+    drawList->PopClipRect();
+}
+
+static void renderProfileSection(const char* title, const ProfileHistory& history, std::vector<ProfileZoneStats>& stats) {
+    if (!ImGui::CollapsingHeader(title, ImGuiTreeNodeFlags_DefaultOpen)) return;
+    if (history.getFrameCount() == 0) {
+        ImGui::Text("No frames yet");
+        return;
+    }
+    ImGui::PushID(title);
+
+    // Обе полосы в одном масштабе - по самому долгому кадру окна
+    const std::vector<ProfileZone>& last = history.getLastFrame();
+    const std::vector<ProfileZone>& worst = history.getWorstFrame();
+    float worstMs = ProfileHistory::frameTime(worst);
+    ImGui::Text("Last frame: %.3f ms", ProfileHistory::frameTime(last));
+    renderFlameBar("last", last, worstMs);
+    ImGui::Text("Worst of %zu frames: %.3f ms", history.getFrameCount(), worstMs);
+    renderFlameBar("worst", worst, worstMs);
+
+    history.computeStats(stats);
+    if (ImGui::BeginTable("zones", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV)) {
+        ImGui::TableSetupColumn("Zone", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableSetupColumn("Last", ImGuiTableColumnFlags_WidthFixed);
+        ImGui::TableSetupColumn("Min", ImGuiTableColumnFlags_WidthFixed);
+        ImGui::TableSetupColumn("Avg", ImGuiTableColumnFlags_WidthFixed);
+        ImGui::TableSetupColumn("P99", ImGuiTableColumnFlags_WidthFixed);
+        ImGui::TableHeadersRow();
+        for (const ProfileZoneStats& zone : stats) {
+            ImGui::TableNextRow();
+            ImGui::TableSetColumnIndex(0);
+            ImGui::Text("%*s%s", zone.depth * 2, "", zone.name);
+            ImGui::TableSetColumnIndex(1);
+            ImGui::Text("%.3f", zone.last);
+            ImGui::TableSetColumnIndex(2);
+            ImGui::Text("%.3f", zone.min);
+            ImGui::TableSetColumnIndex(3);
+            ImGui::Text("%.3f", zone.avg);
+            ImGui::TableSetColumnIndex(4);
+            ImGui::Text("%.3f", zone.p99);
+        }
+        ImGui::EndTable();
+    }
+    ImGui::PopID();
+}
+
+void GUI::renderProfiler(ProfileHistory& physics, ProfileHistory& render) {
+    ImGui::Begin("Profiler");
+
+    ImGui::Checkbox("Pause", &profilerPaused);
+    ImGui::SameLine();
+    ImGui::SliderInt("Frames", &profilerFrames, 30, 1000);
+    // Окно меняется после отпускания ползунка, а не на каждом его шаге
+    if (ImGui::IsItemDeactivatedAfterEdit()) {
+        physics.setWindow(static_cast<size_t>(profilerFrames));
+        render.setWindow(static_cast<size_t>(profilerFrames));
+    }
+    ImGui::Text("Times in ms: last frame, min, avg and p99 over the window");
+
+    renderProfileSection("Physics Thread", physics, profileStats);
+    renderProfileSection("Render Thread", render, profileStats);
+
     ImGui::End();
 }
\ No newline at end of file
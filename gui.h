@@ -1,11 +1,14 @@
 #pragma once
 
 #include "types.h"
+#include "snapshot.h"
+#include "profiler.h"
 #include <GLFW/glfw3.h>
 #include <imgui.h>
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
 #include <functional>
+#include <vector>
 
 class GUI {
 public:
@@ -17,8 +20,19 @@ public:
     void beginFrame();
     void endFrame();
     void renderSettings(PhysicsSettings& settings);
-    void renderControls(std::function<void(int)> spawnCallback, std::function<void()> clearCallback);
+    void renderStats(const PhysicsStats& stats);
+    void renderControls(std::function<void(int)> spawnCallback, std::function<void(int, int)> spawnBatchCallback,
+        std::function<void()> clearCallback);
+    // Окно профайлера: зоны потока физики и кадра рендера за последние кадры
+    void renderProfiler(ProfileHistory& physics, ProfileHistory& render);
+    // На паузе новые кадры не добавляются, чтобы разглядеть плохой кадр
+    bool isProfilerPaused() const { return profilerPaused; }
 
 private:
     bool initialized;
+    int batchType;
+    int batchCount;
+    bool profilerPaused;
+    int profilerFrames;
+    std::vector<ProfileZoneStats> profileStats;
 };
\ No newline at end of file
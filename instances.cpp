@@ -0,0 +1,72 @@
+#include "instances.h"
+#include <glm/gtc/quaternion.hpp>
+#include <algorithm>
+
+void buildInstances(const PhysicsSnapshot& snapshot, float alpha, InstanceData& instances) {
+    const size_t count = snapshot.bodies.size();
+    instances.positions.resize(count * 3);
+    instances.rotations.resize(count * 4);
+    instances.colors.resize(count * 3);
+
+    // Сортировка подсчетом по типу: каждый тип рисуется одним вызовом
+    const int typeCount = 3;
+    size_t first[typeCount] = {};
+    for (const auto& body : snapshot.bodies) {
+        int type = body.type >= 0 && body.type < typeCount ? body.type : 0;
+        for (int t = type + 1; t < typeCount; ++t) ++first[t];
+    }
+    size_t cursor[typeCount];
+    std::copy(first, first + typeCount, cursor);
+
+    for (const auto& body : snapshot.bodies) {
+        int type = body.type >= 0 && body.type < typeCount ? body.type : 0;
+        size_t k = cursor[type]++;
+
+        // Интерполируем между двумя последними шагами физики
+        glm::quat previousRotation(body.previousRotation.w, body.previousRotation.x, body.previousRotation.y, body.previousRotation.z);
+        glm::quat rotation(body.rotation.w, body.rotation.x, body.rotation.y, body.rotation.z);
+        glm::vec3 position = glm::mix(body.previousPosition, body.position, alpha);
+        glm::quat interpolated = glm::slerp(previousRotation, rotation, alpha);
+
+        instances.positions[k * 3 + 0] = position.x;
+        instances.positions[k * 3 + 1] = position.y;
+        instances.positions[k * 3 + 2] = position.z;
+        instances.rotations[k * 4 + 0] = interpolated.x;
+        instances.rotations[k * 4 + 1] = interpolated.y;
+        instances.rotations[k * 4 + 2] = interpolated.z;
+        instances.rotations[k * 4 + 3] = interpolated.w;
+        instances.colors[k * 3 + 0] = body.color.x;
+        instances.colors[k * 3 + 1] = body.color.y;
+        instances.colors[k * 3 + 2] = body.color.z;
+    }
+
+    instances.ranges.clear();
+    for (int t = 0; t < typeCount; ++t) {
+        size_t rangeCount = cursor[t] - first[t];
+        if (rangeCount > 0) {
+            instances.ranges.push_back({ t, first[t], rangeCount });
+        }
+    }
+}
+
+void buildParticleInstances(const ParticleWorld& particles, float alpha, InstanceData& instances) {
+    const size_t count = particles.size();
+    particles.writePositions(alpha, instances.positions);
+
+    // Сферы не вращаются - единичные кватернионы
+    instances.rotations.resize(count * 4);
+    for (size_t k = 0; k < count; ++k) {
+        instances.rotations[k * 4 + 0] = 0.0f;
+        instances.rotations[k * 4 + 1] = 0.0f;
+        instances.rotations[k * 4 + 2] = 0.0f;
+        instances.rotations[k * 4 + 3] = 1.0f;
+    }
+
+    // Меш сферы радиуса 0.5: масштаб равен диаметру частицы
+    instances.ranges.clear();
+    if (count > 0) {
+        InstanceRange range = { 1, 0, count };
+        range.scale = particles.getRadius() * 2.0f;
+        instances.ranges.push_back(range);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "snapshot.h"
+#include "particle_world.h"
+#include <cstddef>
+#include <vector>
+
+// Непрерывный диапазон экземпляров одного типа объекта
+struct InstanceRange {
+    int type;
+    size_t first;
+    size_t count;
+    float scale = 1.0f; // равномерный масштаб меша, например диаметр частиц
+};
+
+// Массивы экземпляров в той же раскладке, что и в файле сцены:
+// позиции float[3 * N], кватернионы float[4 * N], цвета float[3 * N]
+struct InstanceData {
+    std::vector<float> positions;
+    std::vector<float> rotations;
+    std::vector<float> colors;
+    std::vector<InstanceRange> ranges;
+};
+
+// Интерполирует тела снимка и раскладывает их по типам. Только CPU, без
+// вызовов OpenGL, поэтому подготовку кадра можно замерить и без окна
+void buildInstances(const PhysicsSnapshot& snapshot, float alpha, InstanceData& instances);
+// Позиции частиц и один диапазон сфер с масштабом под их диаметр; цвета
+// загружаются прямо из мира частиц
+void buildParticleInstances(const ParticleWorld& particles, float alpha, InstanceData& instances);
\ No newline at end of file
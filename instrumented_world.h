@@ -0,0 +1,122 @@
+#pragma once
+
+#include "trace.h"
+#include <bullet/btBulletDynamicsCommon.h>
+#include <chrono>
+#include <utility>
+
+// Замеры фаз последнего шага мира, которые Bullet сам не отдает
+struct WorldTimings {
+    double aabbMs = 0.0;        // обновление AABB тел в broadphase
+    double pairMs = 0.0;        // поиск пар broadphase
+    double narrowphaseMs = 0.0; // контакты найденных пар
+    double solveMs = 0.0;       // решение ограничений и контактов
+    double integrateMs = 0.0;   // предсказание и интегрирование трансформ, вместе с CCD
+    double syncMs = 0.0;        // запись трансформ в состояния движения
+};
+
+inline double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Длительность фазы в мс; пока идет запись трассы, фаза пишется и в нее
+inline double finishStage(const char* name, std::chrono::steady_clock::time_point start) {
+    auto end = std::chrono::steady_clock::now();
+    if (Trace::isEnabled()) {
+        Trace::record(name, start, end);
+    }
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Мир Bullet, замеряющий свои фазы через виртуальные методы btCollisionWorld.
+// Шаблон, чтобы одинаково оборачивать и однопоточный, и многопоточный мир.
+template <typename World>
+class InstrumentedWorld : public World {
+public:
+    template <typename... Args>
+    explicit InstrumentedWorld(WorldTimings* timings, Args&&... args)
+        : World(std::forward<Args>(args)...)
+        , timings(timings) {
+    }
+
+    // Узкая фаза - все обнаружение столкновений за вычетом AABB и поиска пар
+    void performDiscreteCollisionDetection() override {
+        auto start = std::chrono::steady_clock::now();
+        World::performDiscreteCollisionDetection();
+        timings->narrowphaseMs = finishStage("collisionDetection", start) - timings->aabbMs - timings->pairMs;
+    }
+
+    void updateAabbs() override {
+        auto start = std::chrono::steady_clock::now();
+        World::updateAabbs();
+        timings->aabbMs = finishStage("updateAabbs", start);
+    }
+
+    void computeOverlappingPairs() override {
+        auto start = std::chrono::steady_clock::now();
+        World::computeOverlappingPairs();
+        timings->pairMs = finishStage("computeOverlappingPairs", start);
+    }
+
+    void synchronizeMotionStates() override {
+        auto start = std::chrono::steady_clock::now();
+        World::synchronizeMotionStates();
+        timings->syncMs = finishStage("synchronizeMotionStates", start);
+    }
+
+    // Bullet ищет тело в m_nonStaticRigidBodies линейным поиском. У тел мира
+    // физики userIndex2 - индекс в этом массиве, поэтому удаление идет
+    // перестановкой с последним. Пары тела чистит сам destroyProxy, лишний
+    // проход cleanProxyFromPairs по всему кэшу пар не нужен.
+    void removeRigidBody(btRigidBody* body) override {
+        int index = body->getUserIndex2();
+        btAlignedObjectArray<btRigidBody*>& bodies = this->m_nonStaticRigidBodies;
+        if (index < 0 || index >= bodies.size() || bodies[index] != body) {
+            World::removeRigidBody(body);
+            return;
+        }
+        bodies.swap(index, bodies.size() - 1);
+        bodies.pop_back();
+
+        btBroadphaseProxy* proxy = body->getBroadphaseHandle();
+        if (proxy) {
+            this->getBroadphase()->destroyProxy(proxy, this->getDispatcher());
+            body->setBroadphaseHandle(nullptr);
+        }
+        btCollisionObjectArray& objects = this->m_collisionObjects;
+        int objectIndex = body->getWorldArrayIndex();
+        if (objectIndex >= 0 && objectIndex < objects.size()) {
+            objects.swap(objectIndex, objects.size() - 1);
+            objects.pop_back();
+            if (objectIndex < objects.size()) {
+                objects[objectIndex]->setWorldArrayIndex(objectIndex);
+            }
+        } else {
+            objects.remove(body);
+        }
+        body->setWorldArrayIndex(-1);
+    }
+
+protected:
+    void solveConstraints(btContactSolverInfo& solverInfo) override {
+        auto start = std::chrono::steady_clock::now();
+        World::solveConstraints(solverInfo);
+        timings->solveMs = finishStage("solveConstraints", start);
+    }
+
+    // Предсказание идет первым в шаге и сбрасывает замер интегрирования
+    void predictUnconstraintMotion(btScalar timeStep) override {
+        auto start = std::chrono::steady_clock::now();
+        World::predictUnconstraintMotion(timeStep);
+        timings->integrateMs = finishStage("predictUnconstraintMotion", start);
+    }
+
+    void integrateTransforms(btScalar timeStep) override {
+        auto start = std::chrono::steady_clock::now();
+        World::integrateTransforms(timeStep);
+        timings->integrateMs += finishStage("integrateTransforms", start);
+    }
+
+private:
+    WorldTimings* timings;
+};
\ No newline at end of file
@@ -0,0 +1,322 @@
+#include "kernels.h"
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define WCP_KERNELS_SSE 1
+#endif
+
+static inline float clampScale(float x, float y, float z, float stopSq, float maxSpeed, float maxSq) {
+    float lengthSq = x * x + y * y + z * z;
+    if (lengthSq < stopSq) return 0.0f;
+    if (lengthSq > maxSq) return maxSpeed / std::sqrt(lengthSq);
+    return 1.0f;
+}
+
+void computeClampScales(VectorBatch& batch, float stopSpeed, float maxSpeed) {
+    const size_t count = batch.size();
+    const float stopSq = stopSpeed * stopSpeed;
+    const float maxSq = maxSpeed * maxSpeed;
+    const float* x = batch.x.data();
+    const float* y = batch.y.data();
+    const float* z = batch.z.data();
+    float* scale = batch.scale.data();
+
+    size_t i = 0;
+#ifdef WCP_KERNELS_SSE
+    const __m128 stop4 = _mm_set1_ps(stopSq);
+    const __m128 maxSq4 = _mm_set1_ps(maxSq);
+    const __m128 maxSpeed4 = _mm_set1_ps(maxSpeed);
+    const __m128 one4 = _mm_set1_ps(1.0f);
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 vx = _mm_loadu_ps(x + i);
+        __m128 vy = _mm_loadu_ps(y + i);
+        __m128 vz = _mm_loadu_ps(z + i);
+        __m128 lengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz));
+
+        __m128 tooSlow = _mm_cmplt_ps(lengthSq, stop4);
+        __m128 tooFast = _mm_cmpgt_ps(lengthSq, maxSq4);
+
+        // Деление считается для всех четырех дорожек, но берется только там, где нужно;
+        // для медленных дорожек защищаемся от деления на ноль единицей
+        __m128 safeLengthSq = _mm_or_ps(_mm_and_ps(tooFast, lengthSq), _mm_andnot_ps(tooFast, one4));
+        __m128 limited = _mm_div_ps(maxSpeed4, _mm_sqrt_ps(safeLengthSq));
+
+        __m128 result = _mm_or_ps(_mm_and_ps(tooFast, limited), _mm_andnot_ps(tooFast, one4));
+        result = _mm_andnot_ps(tooSlow, result);
+        _mm_storeu_ps(scale + i, result);
+    }
+#endif
+
+    for (; i < count; ++i) {
+        scale[i] = clampScale(x[i], y[i], z[i], stopSq, maxSpeed, maxSq);
+    }
+}
+
+void computeShakeImpulses(ImpulseBatch& batch, const float impulse[3], const float torque[3]) {
+    const size_t count = batch.size();
+    const float* inverseMass = batch.inverseMass.data();
+    const float* torqueScale = batch.torqueScale.data();
+    const float* m[9];
+    for (int k = 0; k < 9; ++k) m[k] = batch.invInertia[k].data();
+    const float* jx = batch.jitter.x.data();
+    const float* jy = batch.jitter.y.data();
+    const float* jz = batch.jitter.z.data();
+    float* lx = batch.linear.x.data();
+    float* ly = batch.linear.y.data();
+    float* lz = batch.linear.z.data();
+    float* ax = batch.angular.x.data();
+    float* ay = batch.angular.y.data();
+    float* az = batch.angular.z.data();
+
+    size_t i = 0;
+#ifdef WCP_KERNELS_SSE
+    const __m128 ix = _mm_set1_ps(impulse[0]);
+    const __m128 iy = _mm_set1_ps(impulse[1]);
+    const __m128 iz = _mm_set1_ps(impulse[2]);
+    const __m128 tx = _mm_set1_ps(torque[0]);
+    const __m128 ty = _mm_set1_ps(torque[1]);
+    const __m128 tz = _mm_set1_ps(torque[2]);
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 invMass = _mm_loadu_ps(inverseMass + i);
+        _mm_storeu_ps(lx + i, _mm_mul_ps(ix, invMass));
+        _mm_storeu_ps(ly + i, _mm_mul_ps(iy, invMass));
+        _mm_storeu_ps(lz + i, _mm_mul_ps(iz, invMass));
+
+        __m128 scale = _mm_loadu_ps(torqueScale + i);
+        __m128 bx = _mm_add_ps(_mm_mul_ps(tx, scale), _mm_loadu_ps(jx + i));
+        __m128 by = _mm_add_ps(_mm_mul_ps(ty, scale), _mm_loadu_ps(jy + i));
+        __m128 bz = _mm_add_ps(_mm_mul_ps(tz, scale), _mm_loadu_ps(jz + i));
+
+        __m128 rx = _mm_add_ps(_mm_add_ps(
+            _mm_mul_ps(_mm_loadu_ps(m[0] + i), bx),
+            _mm_mul_ps(_mm_loadu_ps(m[1] + i), by)),
+            _mm_mul_ps(_mm_loadu_ps(m[2] + i), bz));
+        __m128 ry = _mm_add_ps(_mm_add_ps(
+            _mm_mul_ps(_mm_loadu_ps(m[3] + i), bx),
+            _mm_mul_ps(_mm_loadu_ps(m[4] + i), by)),
+            _mm_mul_ps(_mm_loadu_ps(m[5] + i), bz));
+        __m128 rz = _mm_add_ps(_mm_add_ps(
+            _mm_mul_ps(_mm_loadu_ps(m[6] + i), bx),
+            _mm_mul_ps(_mm_loadu_ps(m[7] + i), by)),
+            _mm_mul_ps(_mm_loadu_ps(m[8] + i), bz));
+        _mm_storeu_ps(ax + i, rx);
+        _mm_storeu_ps(ay + i, ry);
+        _mm_storeu_ps(az + i, rz);
+    }
+#endif
+
+    for (; i < count; ++i) {
+        lx[i] = impulse[0] * inverseMass[i];
+        ly[i] = impulse[1] * inverseMass[i];
+        lz[i] = impulse[2] * inverseMass[i];
+
+        float bx = torque[0] * torqueScale[i] + jx[i];
+        float by = torque[1] * torqueScale[i] + jy[i];
+        float bz = torque[2] * torqueScale[i] + jz[i];
+        ax[i] = m[0][i] * bx + m[1][i] * by + m[2][i] * bz;
+        ay[i] = m[3][i] * bx + m[4][i] * by + m[5][i] * bz;
+        az[i] = m[6][i] * bx + m[7][i] * by + m[8][i] * bz;
+    }
+}
+
+void integrateParticles(VectorBatch& position, VectorBatch& previous, VectorBatch& velocity,
+    float gravityY, float damping, float h) {
+    const size_t count = position.size();
+    float* x[3] = { position.x.data(), position.y.data(), position.z.data() };
+    float* p[3] = { previous.x.data(), previous.y.data(), previous.z.data() };
+    float* v[3] = { velocity.x.data(), velocity.y.data(), velocity.z.data() };
+    const float* scale = velocity.scale.data();
+    const float gravityStep = gravityY * h;
+
+    size_t i = 0;
+#ifdef WCP_KERNELS_SSE
+    const __m128 damping4 = _mm_set1_ps(damping);
+    const __m128 h4 = _mm_set1_ps(h);
+    const __m128 gravity4 = _mm_set1_ps(gravityStep);
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 factor = _mm_mul_ps(_mm_loadu_ps(scale + i), damping4);
+        for (int axis = 0; axis < 3; ++axis) {
+            __m128 vel = _mm_mul_ps(_mm_loadu_ps(v[axis] + i), factor);
+            if (axis == 1) vel = _mm_add_ps(vel, gravity4);
+            __m128 pos = _mm_loadu_ps(x[axis] + i);
+            _mm_storeu_ps(p[axis] + i, pos);
+            _mm_storeu_ps(x[axis] + i, _mm_add_ps(pos, _mm_mul_ps(vel, h4)));
+            _mm_storeu_ps(v[axis] + i, vel);
+        }
+    }
+#endif
+
+    for (; i < count; ++i) {
+        float factor = scale[i] * damping;
+        for (int axis = 0; axis < 3; ++axis) {
+            float vel = v[axis][i] * factor + (axis == 1 ? gravityStep : 0.0f);
+            p[axis][i] = x[axis][i];
+            x[axis][i] += vel * h;
+            v[axis][i] = vel;
+        }
+    }
+}
+
+// Квадрат расстояния, ниже которого направление между частицами не определено
+static const float COINCIDENT_DISTANCE_SQ = 1e-12f;
+
+// Совпадающие частицы расталкиваются по вертикали, направление - по порядку индексов,
+// чтобы пара получила противоположные сдвиги
+static inline void pushCoincident(size_t self, size_t other, float diameter, float sum[3]) {
+    sum[1] += other > self ? -0.5f * diameter : 0.5f * diameter;
+}
+
+int accumulateSphereContacts(const VectorBatch& position, size_t begin, size_t end, size_t self,
+    const float center[3], float diameter, float delta[3]) {
+    const float* x = position.x.data();
+    const float* y = position.y.data();
+    const float* z = position.z.data();
+    const float diameterSq = diameter * diameter;
+    float sum[3] = { 0.0f, 0.0f, 0.0f };
+    int contacts = 0;
+
+    size_t j = begin;
+#ifdef WCP_KERNELS_SSE
+    const __m128 cx = _mm_set1_ps(center[0]);
+    const __m128 cy = _mm_set1_ps(center[1]);
+    const __m128 cz = _mm_set1_ps(center[2]);
+    const __m128 diameter4 = _mm_set1_ps(diameter);
+    const __m128 diameterSq4 = _mm_set1_ps(diameterSq);
+    const __m128 coincident4 = _mm_set1_ps(COINCIDENT_DISTANCE_SQ);
+    const __m128 half4 = _mm_set1_ps(0.5f);
+    const __m128 one4 = _mm_set1_ps(1.0f);
+    const __m128 three4 = _mm_set1_ps(3.0f);
+    __m128 sumX = _mm_setzero_ps();
+    __m128 sumY = _mm_setzero_ps();
+    __m128 sumZ = _mm_setzero_ps();
+
+    for (; j + 4 <= end; j += 4) {
+        __m128 dx = _mm_sub_ps(cx, _mm_loadu_ps(x + j));
+        __m128 dy = _mm_sub_ps(cy, _mm_loadu_ps(y + j));
+        __m128 dz = _mm_sub_ps(cz, _mm_loadu_ps(z + j));
+        __m128 distanceSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+        int mask = _mm_movemask_ps(_mm_cmplt_ps(distanceSq, diameterSq4));
+        if (self - j < 4) mask &= ~(1 << (self - j));
+        if (mask == 0) continue;
+
+        // Совпадающие пары редки - их разбираем скалярно и убираем из векторной части
+        int coincident = mask & _mm_movemask_ps(_mm_cmple_ps(distanceSq, coincident4));
+        for (int lane = 0; lane < 4; ++lane) {
+            if (coincident & (1 << lane)) pushCoincident(self, j + lane, diameter, sum);
+        }
+        contacts += (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1);
+
+        // push = 0.5 * (d - dist) / dist = 0.5 * (d / dist - 1): обратный корень с одним
+        // шагом Ньютона вместо корня и деления. Сама частица и совпадающие отсекаются
+        // порогом совпадения, для них берем безопасный квадрат - результат обнуляется
+        __m128 touching = _mm_and_ps(_mm_cmplt_ps(distanceSq, diameterSq4), _mm_cmpgt_ps(distanceSq, coincident4));
+        __m128 safeSq = _mm_max_ps(distanceSq, coincident4);
+        __m128 invDistance = _mm_rsqrt_ps(safeSq);
+        invDistance = _mm_mul_ps(_mm_mul_ps(half4, invDistance),
+            _mm_sub_ps(three4, _mm_mul_ps(safeSq, _mm_mul_ps(invDistance, invDistance))));
+        __m128 push = _mm_mul_ps(half4, _mm_sub_ps(_mm_mul_ps(diameter4, invDistance), one4));
+        push = _mm_and_ps(touching, push);
+        sumX = _mm_add_ps(sumX, _mm_mul_ps(dx, push));
+        sumY = _mm_add_ps(sumY, _mm_mul_ps(dy, push));
+        sumZ = _mm_add_ps(sumZ, _mm_mul_ps(dz, push));
+    }
+
+    float lanes[4];
+    _mm_storeu_ps(lanes, sumX);
+    sum[0] += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    _mm_storeu_ps(lanes, sumY);
+    sum[1] += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    _mm_storeu_ps(lanes, sumZ);
+    sum[2] += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+
+    for (; j < end; ++j) {
+        if (j == self) continue;
+        float dx = center[0] - x[j];
+        float dy = center[1] - y[j];
+        float dz = center[2] - z[j];
+        float distanceSq = dx * dx + dy * dy + dz * dz;
+        if (distanceSq >= diameterSq) continue;
+        ++contacts;
+        if (distanceSq <= COINCIDENT_DISTANCE_SQ) {
+            pushCoincident(self, j, diameter, sum);
+            continue;
+        }
+        float distance = std::sqrt(distanceSq);
+        float push = 0.5f * (diameter - distance) / distance;
+        sum[0] += dx * push;
+        sum[1] += dy * push;
+        sum[2] += dz * push;
+    }
+
+    delta[0] += sum[0];
+    delta[1] += sum[1];
+    delta[2] += sum[2];
+    return contacts;
+}
+
+void constrainParticles(VectorBatch& position, float low, float high) {
+    const size_t count = position.size();
+    float* x[3] = { position.x.data(), position.y.data(), position.z.data() };
+
+    for (int axis = 0; axis < 3; ++axis) {
+        float* values = x[axis];
+        size_t i = 0;
+#ifdef WCP_KERNELS_SSE
+        const __m128 low4 = _mm_set1_ps(low);
+        const __m128 high4 = _mm_set1_ps(high);
+        for (; i + 4 <= count; i += 4) {
+            _mm_storeu_ps(values + i, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(values + i), low4), high4));
+        }
+#endif
+        for (; i < count; ++i) {
+            values[i] = std::fmin(std::fmax(values[i], low), high);
+        }
+    }
+}
+
+static inline float wallVelocity(float position, float previousVelocity, float velocity,
+    float low, float high, float restitution) {
+    if ((position <= low && previousVelocity < 0.0f) || (position >= high && previousVelocity > 0.0f)) {
+        return -restitution * previousVelocity;
+    }
+    return velocity;
+}
+
+void updateParticleVelocities(const VectorBatch& position, const VectorBatch& previous, VectorBatch& velocity,
+    float invH, float low, float high, float restitution) {
+    const size_t count = position.size();
+    const float* x[3] = { position.x.data(), position.y.data(), position.z.data() };
+    const float* p[3] = { previous.x.data(), previous.y.data(), previous.z.data() };
+    float* v[3] = { velocity.x.data(), velocity.y.data(), velocity.z.data() };
+
+    for (int axis = 0; axis < 3; ++axis) {
+        size_t i = 0;
+#ifdef WCP_KERNELS_SSE
+        const __m128 invH4 = _mm_set1_ps(invH);
+        const __m128 low4 = _mm_set1_ps(low);
+        const __m128 high4 = _mm_set1_ps(high);
+        const __m128 bounce4 = _mm_set1_ps(-restitution);
+        const __m128 zero4 = _mm_setzero_ps();
+        for (; i + 4 <= count; i += 4) {
+            __m128 pos = _mm_loadu_ps(x[axis] + i);
+            __m128 before = _mm_loadu_ps(v[axis] + i);
+            __m128 after = _mm_mul_ps(_mm_sub_ps(pos, _mm_loadu_ps(p[axis] + i)), invH4);
+
+            __m128 hitLow = _mm_and_ps(_mm_cmple_ps(pos, low4), _mm_cmplt_ps(before, zero4));
+            __m128 hitHigh = _mm_and_ps(_mm_cmpge_ps(pos, high4), _mm_cmpgt_ps(before, zero4));
+            __m128 hit = _mm_or_ps(hitLow, hitHigh);
+            __m128 bounced = _mm_mul_ps(before, bounce4);
+            _mm_storeu_ps(v[axis] + i, _mm_or_ps(_mm_and_ps(hit, bounced), _mm_andnot_ps(hit, after)));
+        }
+#endif
+        for (; i < count; ++i) {
+            float after = (x[axis][i] - p[axis][i]) * invH;
+            v[axis][i] = wallVelocity(x[axis][i], v[axis][i], after, low, high, restitution);
+        }
+    }
+}
\ No newline at end of file
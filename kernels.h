@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Пакет трехмерных векторов в виде структуры массивов для SIMD-ядер
+struct VectorBatch {
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+    std::vector<float> scale; // результат ядра: множитель для каждого вектора
+
+    void resize(size_t count) {
+        x.resize(count);
+        y.resize(count);
+        z.resize(count);
+        scale.resize(count);
+    }
+    size_t size() const { return x.size(); }
+};
+
+// Для каждого вектора считает множитель: 0, если длина меньше stopSpeed,
+// maxSpeed / длина, если длина больше maxSpeed, иначе 1. Сравнения идут
+// по квадратам длин, корень берется только для векторов сверх предела.
+void computeClampScales(VectorBatch& batch, float stopSpeed, float maxSpeed);
+
+// Пакет тел для применения общего импульса встряски окна
+struct ImpulseBatch {
+    std::vector<float> inverseMass;
+    std::vector<float> torqueScale;   // множитель базового момента с учетом массы и предела
+    std::vector<float> invInertia[9]; // обратный тензор инерции в мировых осях, по строкам
+    VectorBatch jitter;               // детерминированное возмущение момента
+    VectorBatch linear;               // результат: приращение линейной скорости
+    VectorBatch angular;              // результат: приращение угловой скорости
+
+    void resize(size_t count) {
+        inverseMass.resize(count);
+        torqueScale.resize(count);
+        for (auto& row : invInertia) row.resize(count);
+        jitter.resize(count);
+        linear.resize(count);
+        angular.resize(count);
+    }
+    size_t size() const { return inverseMass.size(); }
+};
+
+// dv = impulse / m, dw = I^-1 * (torque * torqueScale + jitter) за один проход
+void computeShakeImpulses(ImpulseBatch& batch, const float impulse[3], const float torque[3]);
+
+// Ядра частиц одного радиуса. Позиции, скорости и позиции начала подшага
+// лежат в отдельных VectorBatch; scale у скоростей - множитель из computeClampScales.
+
+// v = v * scale * damping + (0, gravityY, 0) * h; previous = position; position += v * h
+void integrateParticles(VectorBatch& position, VectorBatch& previous, VectorBatch& velocity,
+    float gravityY, float damping, float h);
+
+// Суммирует в delta выталкивание частицы center из частиц [begin, end): каждая
+// пересекающаяся пара раздвигается на половину глубины, совпадающие - по вертикали.
+// Частица с индексом self (сама центральная) пропускается. Возвращает число контактов.
+int accumulateSphereContacts(const VectorBatch& position, size_t begin, size_t end, size_t self,
+    const float center[3], float diameter, float delta[3]);
+
+// Стены коробки: центры частиц зажимаются в [low, high] по каждой оси
+void constrainParticles(VectorBatch& position, float low, float high);
+
+// v = (position - previous) / h. У стены нормальная составляющая прежней
+// скорости, направленная в стену, отражается с коэффициентом restitution
+void updateParticleVelocities(const VectorBatch& position, const VectorBatch& previous, VectorBatch& velocity,
+    float invH, float low, float high, float restitution);
\ No newline at end of file
@@ -5,31 +5,38 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <vector>
 #include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include <memory>
 
 #include "types.h"
 #include "render.h"
 #include "camera.h"
 #include "physics.h"
+#include "bullet_backend.h"
+#include "particle_backend.h"
+#include "timestep.h"
 #include "gui.h"
 #include "shaders.h"
+#include "physics_thread.h"
+#include "scene_input.h"
+#include "recording.h"
+#include "trace.h"
 
 // Глобальные переменные
-std::vector<PhysicsObject> physicsObjects;
 PhysicsSettings physicsSettings;
 Camera camera;
-glm::dvec2 lastWindowPos(0.0, 0.0);
-glm::dvec2 windowVelocity(0.0, 0.0);
-bool firstMove = true;
+SceneInput* sceneInput = nullptr;
+bool replaying = false;
 bool cursorEnabled = true;
 
 // Callback для перемещения окна
 void window_pos_callback(GLFWwindow* window, int xpos, int ypos) {
-    if (!physicsObjects.empty()) {
-        if (!firstMove) {
-            windowVelocity = glm::dvec2(xpos - lastWindowPos.x, ypos - lastWindowPos.y);
-        }
-        lastWindowPos = glm::dvec2(xpos, ypos);
-        firstMove = false;
+    // При воспроизведении движение окна берется только из записи
+    if (sceneInput && !replaying) {
+        sceneInput->onWindowPos(glfwGetTime(), xpos, ypos);
     }
 }
 
@@ -37,51 +44,87 @@ void error_callback(int error, const char* description) {
     fprintf(stderr, "Error: %s\n", description);
 }
 
-PhysicsObject createPhysicsObject(int type, const btVector3& position) {
-    PhysicsObject obj;
-    obj.type = type;
-    
-    // Создаем форму в зависимости от типа
-    switch(type) {
-        case 0: // куб
-            obj.shape = new btBoxShape(btVector3(0.5f, 0.5f, 0.5f));
-            obj.color = physicsSettings.cubeColor;
-            break;
-        case 1: // сфера
-            obj.shape = new btSphereShape(0.5f);
-            obj.color = glm::vec3(0.2f, 0.8f, 0.3f);
-            break;
-        case 2: // цилиндр
-            obj.shape = new btCylinderShape(btVector3(0.5f, 0.5f, 0.5f));
-            obj.color = glm::vec3(0.3f, 0.2f, 0.8f);
-            break;
+// Луч из камеры через курсор: от ближней плоскости отсечения до дальней
+void cursorRay(GLFWwindow* window, const glm::mat4& view, const glm::mat4& projection, glm::vec3& from, glm::vec3& to) {
+    double x, y;
+    int width, height;
+    glfwGetCursorPos(window, &x, &y);
+    glfwGetWindowSize(window, &width, &height);
+    glm::vec2 ndc(2.0 * x / width - 1.0, 1.0 - 2.0 * y / height);
+    glm::mat4 inverse = glm::inverse(projection * view);
+    glm::vec4 nearPoint = inverse * glm::vec4(ndc, -1.0f, 1.0f);
+    glm::vec4 farPoint = inverse * glm::vec4(ndc, 1.0f, 1.0f);
+    from = glm::vec3(nearPoint) / nearPoint.w;
+    to = glm::vec3(farPoint) / farPoint.w;
+}
+
+int main(int argc, char** argv) {
+    // Параметры командной строки
+    PhysicsWorldConfig physicsConfig;
+    std::string recordPath;
+    std::string replayPath;
+    std::string timingsPath;
+    std::string snapshotPath;
+    std::string scenePath;
+    std::string tracePath = "trace.json";
+    bool traceFromStart = false;
+    size_t particleCount = 0;
+    float particleRadius = 0.0f;
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--threads") == 0 && hasValue) {
+            physicsConfig.numThreads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--record") == 0 && hasValue) {
+            recordPath = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0 && hasValue) {
+            replayPath = argv[++i];
+        } else if (strcmp(argv[i], "--timings") == 0 && hasValue) {
+            timingsPath = argv[++i];
+        } else if (strcmp(argv[i], "--load") == 0 && hasValue) {
+            snapshotPath = argv[++i];
+        } else if (strcmp(argv[i], "--broadphase") == 0 && hasValue) {
+            if (!parseBroadphaseType(argv[++i], physicsConfig.broadphase)) {
+                fprintf(stderr, "Unknown broadphase: %s\n", argv[i]);
+            }
+        } else if (strcmp(argv[i], "--generic-narrowphase") == 0) {
+            physicsConfig.fastNarrowphase = false;
+        } else if (strcmp(argv[i], "--scene") == 0 && hasValue) {
+            scenePath = argv[++i];
+        } else if (strcmp(argv[i], "--particles") == 0 && hasValue) {
+            particleCount = static_cast<size_t>(atol(argv[++i]));
+        } else if (strcmp(argv[i], "--particle-radius") == 0 && hasValue) {
+            particleRadius = static_cast<float>(atof(argv[++i]));
+        } else if (strcmp(argv[i], "--trace") == 0 && hasValue) {
+            tracePath = argv[++i];
+            traceFromStart = true;
+        }
     }
 
-    btScalar mass = 1.0f;
-    btVector3 inertia(0, 0, 0);
-    obj.shape->calculateLocalInertia(mass, inertia);
-
-    btTransform transform;
-    transform.setIdentity();
-    transform.setOrigin(position);
-    
-    obj.motionState = new btDefaultMotionState(transform);
-    btRigidBody::btRigidBodyConstructionInfo rbInfo(mass, obj.motionState, obj.shape, inertia);
-    
-    // Настройка физических параметров
-    rbInfo.m_restitution = physicsSettings.restitution;
-    rbInfo.m_friction = physicsSettings.friction;
-    
-    obj.rigidBody = new btRigidBody(rbInfo);
-    obj.rigidBody->setRollingFriction(physicsSettings.rollingFriction);
-    obj.rigidBody->setSpinningFriction(physicsSettings.spinningFriction);
-    obj.rigidBody->setDamping(physicsSettings.damping, physicsSettings.damping);
-    obj.rigidBody->setActivationState(DISABLE_DEACTIVATION);
-    
-    return obj;
-}
+    // Трасса пишется с запуска, если задан --trace, иначе с первого нажатия F9
+    Trace::setThreadName("main");
+    if (traceFromStart) {
+        Trace::start();
+    }
+
+    // Воспроизведение записанного ввода с фиксированным шагом
+    InputReplay replay;
+    FrameTimingLog timings;
+    replaying = !replayPath.empty();
+    const bool particleMode = particleCount > 0;
+    if (particleMode && replaying) {
+        fprintf(stderr, "--particles cannot be combined with --replay\n");
+        return -1;
+    }
+    if (replaying) {
+        if (!replay.load(replayPath)) {
+            return -1;
+        }
+        physicsSettings = replay.getInitialSettings();
+        if (!timingsPath.empty() && !timings.open(timingsPath)) {
+            return -1;
+        }
+    }
 
-int main() {
     // Инициализация GLFW
     if (!glfwInit()) {
         return -1;
@@ -107,11 +150,62 @@ int main() {
     // Создание шейдеров
     GLuint shaderProgram = Renderer::createShaderProgram(vertexShaderSource, fragmentShaderSource);
     GLuint skyboxShader = Renderer::createShaderProgram(skyboxVertexShaderSource, skyboxFragmentShaderSource);
+    GLuint instancedShader = Renderer::createShaderProgram(instancedVertexShaderSource, instancedFragmentShaderSource);
+
+    // Буферы экземпляров для всех тел сцены
+    InstanceBuffers instanceBuffers;
+    Renderer::createInstanceBuffers(instanceBuffers);
+    InstanceData instanceData;
+
+    // Инициализация физики: мир Bullet со стенами за интерфейсом движка
+    BulletBackend bulletBackend(physicsConfig);
+
+    // Физика шагает в своем потоке, рендер читает только опубликованные снимки.
+    // При воспроизведении поток не запускается: каждый кадр - ровно один шаг.
+    PhysicsThread physicsThread(bulletBackend);
+    physicsThread.setSettings(physicsSettings);
+    if (!snapshotPath.empty() && !replaying && !particleMode) {
+        physicsThread.loadSnapshot(snapshotPath, physicsSettings);
+    }
+
+    // Сцена из отображенного файла: тела создаются прямо из массивов файла,
+    // те же массивы сразу уходят в буферы экземпляров для первого кадра
+    std::vector<InstanceRange> sceneRanges;
+    if (!scenePath.empty() && !replaying && !particleMode) {
+        MappedScene mappedScene;
+        if (mappedScene.open(scenePath) && physicsThread.loadSceneMap(mappedScene)) {
+            Renderer::uploadInstances(instanceBuffers, mappedScene.getPositions(), mappedScene.getRotations(),
+                mappedScene.getColors(), mappedScene.getBodyCount());
+            const SceneMapArchetype* archetypes = mappedScene.getArchetypes();
+            for (uint32_t a = 0; a < mappedScene.getArchetypeCount(); ++a) {
+                sceneRanges.push_back({ archetypes[a].type, archetypes[a].firstBody, archetypes[a].bodyCount });
+            }
+        }
+    }
+    // Режим частиц: сцена только из сфер одного радиуса, ее шагает ParticleWorld
+    // прямо на главном потоке, поток физики Bullet не запускается
+    std::unique_ptr<ParticleBackend> particleBackend;
+    FixedTimestep particleTimestep;
+    if (particleMode) {
+        ParticleConfig particleConfig;
+        if (particleRadius > 0.0f) {
+            particleConfig.radius = particleRadius;
+        }
+        particleBackend.reset(new ParticleBackend(particleConfig));
+        particleBackend->spawnBatch(1, particleCount, physicsSettings);
+    } else if (!replaying) {
+        physicsThread.start();
+    }
 
-    // Инициализация физики
-    PhysicsWorld physicsWorld;
-    physicsWorld.init();
-    physicsWorld.createBoundaryWalls();
+    // В режиме частиц ввод идет прямо в движок частиц, иначе - в поток физики
+    SceneInput input = particleMode ? SceneInput(*particleBackend) : SceneInput(physicsThread);
+    sceneInput = &input;
+    InputRecorder recorder;
+    if (!recordPath.empty() && !replaying) {
+        if (recorder.open(recordPath)) {
+            input.setRecorder(&recorder);
+        }
+    }
 
     // Инициализация GUI
     GUI gui;
@@ -187,21 +281,87 @@ int main() {
     meshes.sphere = Renderer::createSphere(32, 32);
     meshes.cylinder = Renderer::createCylinder(32);
 
+    // Профиль кадра рендера и история кадров обоих потоков для окна профайлера
+    FrameProfile renderProfile;
+    std::vector<ProfileZone> renderZones;
+    ProfileHistory physicsHistory;
+    ProfileHistory renderHistory;
+    std::vector<std::vector<ProfileZone>> physicsFrames;
+
     // Основной цикл
+    using Clock = std::chrono::steady_clock;
+    const float replayStep = 1.0f / physicsSettings.tickRate;
+    int replayFrame = 0;
     float lastTime = glfwGetTime();
+    bool traceKeyDown = false;
+    bool dragging = false;
     while (!glfwWindowShouldClose(window)) {
+        TraceScope frameScope("frame");
         float currentTime = glfwGetTime();
         float deltaTime = currentTime - lastTime;
         lastTime = currentTime;
 
-        // Обновление физики
-        physicsWorld.stepSimulation(deltaTime);
+        double physicsMs = 0.0;
+        if (replaying) {
+            double replayTime = replayFrame * static_cast<double>(replayStep);
+            if (replay.finished(replayTime)) {
+                break;
+            }
+            replay.feed(replayTime, input, physicsSettings);
+            input.flush(replayTime, physicsSettings);
+
+            Clock::time_point physicsStart = Clock::now();
+            physicsThread.stepSynchronous(replayStep);
+            physicsMs = std::chrono::duration<double, std::milli>(Clock::now() - physicsStart).count();
+        } else if (particleMode) {
+            ProfileScope scope(renderProfile, "particleStep");
+            int steps = particleTimestep.advance(deltaTime, physicsSettings);
+            for (int i = 0; i < steps; ++i) {
+                particleBackend->step(particleTimestep.getStepTime(), physicsSettings);
+            }
+        }
+        Clock::time_point renderStart = Clock::now();
+
+        // Последний готовый снимок физики и доля шага для интерполяции
+        const PhysicsSnapshot& snapshot = physicsThread.acquireSnapshot();
+        input.setObjectCount(particleMode ? particleBackend->getBodyCount() : snapshot.bodies.size());
+        float alpha = replaying ? 1.0f : PhysicsThread::interpolationAlpha(snapshot);
+        // В историю попадает каждый кадр потока физики, в том числе кадры
+        // снимков, которые рендер пропустил
+        physicsThread.readProfileFrames(physicsFrames);
+        if (!gui.isProfilerPaused()) {
+            for (const std::vector<ProfileZone>& frame : physicsFrames) {
+                physicsHistory.addFrame(frame);
+            }
+        }
 
         // Обработка камеры
         CameraController::processCamera(window, camera, deltaTime);
         glm::mat4 view = CameraController::getViewMatrix(camera);
         glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f/600.0f, 0.1f, 100.0f);
 
+        // Левая кнопка захватывает тело под курсором и тянет его пружиной за
+        // курсором. Клик по окну ImGui до сцены не доходит
+        if (!replaying && !particleMode) {
+            bool mouseDown = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+            if (mouseDown && (dragging || !ImGui::GetIO().WantCaptureMouse)) {
+                glm::vec3 rayFrom, rayTo;
+                cursorRay(window, view, projection, rayFrom, rayTo);
+                if (dragging) {
+                    input.updateDrag(rayFrom, rayTo);
+                } else {
+                    input.beginDrag(rayFrom, rayTo);
+                    dragging = true;
+                }
+            } else if (!mouseDown && dragging) {
+                input.endDrag();
+                dragging = false;
+            }
+        }
+
+        // Время рендера - это время отправки команд GL на CPU, GPU работает асинхронно
+        renderProfile.begin("renderScene");
+
         // Очистка буфера
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
@@ -210,53 +370,134 @@ int main() {
         glUseProgram(skyboxShader);
         Renderer::renderSkybox(skyboxVAO, skyboxShader, view, projection);
 
-        // Затем рендерим объекты
-        glUseProgram(shaderProgram);
-        for(const auto& obj : physicsObjects) {
-            Renderer::renderPhysicsObject(obj, shaderProgram, meshes, view, projection, camera);
+        // Затем рендерим объекты; пока физика не опубликовала ни одного снимка,
+        // рисуем загруженную сцену прямо из буферов, заполненных при загрузке
+        if (particleMode) {
+            const ParticleWorld& particleWorld = particleBackend->getWorld();
+            renderProfile.begin("buildInstances");
+            buildParticleInstances(particleWorld, particleTimestep.getAlpha(), instanceData);
+            renderProfile.end();
+            renderProfile.begin("uploadInstances");
+            Renderer::uploadInstances(instanceBuffers, instanceData.positions.data(), instanceData.rotations.data(),
+                particleWorld.getColors(), particleWorld.size());
+            renderProfile.end();
+            Renderer::renderInstances(instanceBuffers, instanceData.ranges, instancedShader, meshes, view, projection, camera);
+        } else if (snapshot.tick == 0 && !sceneRanges.empty()) {
+            Renderer::renderInstances(instanceBuffers, sceneRanges, instancedShader, meshes, view, projection, camera);
+        } else {
+            renderProfile.begin("buildInstances");
+            buildInstances(snapshot, alpha, instanceData);
+            renderProfile.end();
+            renderProfile.begin("uploadInstances");
+            Renderer::uploadInstances(instanceBuffers, instanceData.positions.data(), instanceData.rotations.data(),
+                instanceData.colors.data(), snapshot.bodies.size());
+            renderProfile.end();
+            Renderer::renderInstances(instanceBuffers, instanceData.ranges, instancedShader, meshes, view, projection, camera);
         }
 
         // Рендеринг каркаса границ
+        Renderer::setSceneUniforms(shaderProgram, view, projection, camera);
+        glUniform3fv(glGetUniformLocation(shaderProgram, "cubeColor"), 1, glm::value_ptr(glm::vec3(1.0f)));
         Renderer::renderWireframeBox(shaderProgram, cubeMesh, BOUNDARY_SIZE);
+        renderProfile.end();
 
         // Рендеринг GUI
+        renderProfile.begin("imgui");
         gui.beginFrame();
 
         gui.renderSettings(physicsSettings);
+        if (particleMode) {
+            PhysicsStats particleStats;
+            ParticleStats stats = particleBackend->getWorld().getStats();
+            particleStats.activeBodies = static_cast<int>(stats.particles);
+            particleStats.particles = static_cast<int>(stats.particles);
+            particleStats.particleContacts = stats.contacts;
+            particleStats.particleStepMs = static_cast<float>(stats.stepMs);
+            gui.renderStats(particleStats);
+        } else {
+            gui.renderStats(snapshot.stats);
+        }
+        gui.renderProfiler(physicsHistory, renderHistory);
+        // При воспроизведении действия берутся только из записи. В режиме
+        // частиц любой тип создает сферы-частицы
         gui.renderControls(
             [&](int type) {
-                PhysicsObject obj = createPhysicsObject(type, btVector3(0, 2, 0));
-                physicsWorld.addObject(obj);
-                physicsObjects.push_back(obj);
+                if (!replaying) input.spawn(glfwGetTime(), type, physicsSettings);
+            },
+            [&](int type, int count) {
+                if (!replaying) input.spawnBatch(glfwGetTime(), type, count, physicsSettings);
             },
             [&]() {
-                for(auto& obj : physicsObjects) {
-                    physicsWorld.removeObject(obj);
-                }
-                physicsObjects.clear();
+                if (!replaying) input.clear(glfwGetTime(), physicsSettings.releaseMemoryOnClear);
             }
         );
 
-        // Применение сил к объектам
-        if (!physicsObjects.empty() && glm::length(windowVelocity) > 0.1) {
-            for(auto& obj : physicsObjects) {
-                physicsWorld.applyForceToObject(obj, glm::vec2(windowVelocity), physicsSettings);
-            }
-            windowVelocity = glm::dvec2(0.0, 0.0); // Сбрасываем скорость после применения
+        // Встряска тел и передача настроек физике
+        if (!replaying) {
+            input.flush(glfwGetTime(), physicsSettings);
         }
 
         gui.endFrame();
+        renderProfile.end();
+
+        if (replaying) {
+            // Ждем GPU, чтобы время рендера не уходило в следующий кадр
+            glFinish();
+            double renderMs = std::chrono::duration<double, std::milli>(Clock::now() - renderStart).count();
+            timings.add(replayFrame, physicsMs, renderMs);
+            ++replayFrame;
+        }
 
         // Обмен буферов
+        renderProfile.begin("swapBuffers");
         glfwSwapBuffers(window);
+        renderProfile.end();
+        renderProfile.begin("pollEvents");
         glfwPollEvents();
+        renderProfile.end();
+
+        renderProfile.read(renderZones);
+        if (!gui.isProfilerPaused()) {
+            renderHistory.addFrame(renderZones);
+        }
+
+        // F9 начинает запись трассы, повторное нажатие сохраняет ее в файл
+        bool traceKeyPressed = glfwGetKey(window, GLFW_KEY_F9) == GLFW_PRESS;
+        if (traceKeyPressed && !traceKeyDown) {
+            if (!Trace::isEnabled()) {
+                Trace::start();
+                printf("trace: recording\n");
+            } else {
+                Trace::stop();
+                if (Trace::write(tracePath)) {
+                    printf("trace: %s\n", tracePath.c_str());
+                }
+            }
+        }
+        traceKeyDown = traceKeyPressed;
     }
 
     // Очистка
+    if (replaying) {
+        printf("replay frames: %d, physics ms/frame: %.4f, render ms/frame: %.4f\n",
+            timings.getFrameCount(), timings.getAveragePhysicsMs(), timings.getAverageRenderMs());
+        timings.close();
+    }
+    recorder.close(glfwGetTime());
+    sceneInput = nullptr;
+    physicsThread.stop();
+    if (Trace::isEnabled()) {
+        Trace::stop();
+        if (Trace::write(tracePath)) {
+            printf("trace: %s\n", tracePath.c_str());
+        }
+    }
     gui.cleanup();
-    physicsWorld.cleanup();
+    bulletBackend.clear(true);
     glDeleteProgram(shaderProgram);
     glDeleteProgram(skyboxShader);
+    glDeleteProgram(instancedShader);
+    Renderer::deleteInstanceBuffers(instanceBuffers);
     glDeleteVertexArrays(1, &cubeMesh.VAO);
     glDeleteBuffers(1, &cubeMesh.VBO);
     glDeleteBuffers(1, &cubeMesh.EBO);
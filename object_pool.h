@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Пул блоков фиксированного размера для объектов одного типа. Память берется
+// крупными непрерывными чанками, освобожденные блоки переиспользуются через
+// список свободных, а reset() разом делает свободными все блоки за O(1).
+template <typename T, size_t BlocksPerChunk = 1024>
+class ObjectPool {
+public:
+    ObjectPool() : freeList(nullptr), chunkIndex(0), blockIndex(0), liveCount(0) {}
+    ~ObjectPool() { release(); }
+
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+    template <typename... Args>
+    T* create(Args&&... args) {
+        return new (allocate()) T(std::forward<Args>(args)...);
+    }
+
+    void destroy(T* object) {
+        if (!object) return;
+        object->~T();
+        Block* block = reinterpret_cast<Block*>(object);
+        block->next = freeList;
+        freeList = block;
+        --liveCount;
+    }
+
+    // Все блоки снова свободны, чанки остаются для следующих объектов.
+    // Деструкторы живых объектов к этому моменту должны быть уже вызваны.
+    void reset() {
+        freeList = nullptr;
+        chunkIndex = 0;
+        blockIndex = 0;
+        liveCount = 0;
+    }
+
+    // Сброс с возвратом памяти системе
+    void release() {
+        for (Block* chunk : chunks) {
+            delete[] chunk;
+        }
+        chunks.clear();
+        reset();
+    }
+
+    // Заранее выделяет чанки под count объектов, чтобы массовое создание
+    // не перемежалось выделениями памяти
+    void reserve(size_t count) {
+        size_t needed = (count + BlocksPerChunk - 1) / BlocksPerChunk;
+        while (chunks.size() < needed) {
+            chunks.push_back(new Block[BlocksPerChunk]);
+        }
+    }
+
+    size_t size() const { return liveCount; }
+    size_t capacity() const { return chunks.size() * BlocksPerChunk; }
+
+private:
+    union Block {
+        Block* next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    void* allocate() {
+        ++liveCount;
+        if (freeList) {
+            Block* block = freeList;
+            freeList = block->next;
+            return block->storage;
+        }
+
+        // Блоки выдаются подряд из текущего чанка, чтобы тела лежали плотно
+        if (blockIndex == BlocksPerChunk) {
+            ++chunkIndex;
+            blockIndex = 0;
+        }
+        if (chunkIndex == chunks.size()) {
+            chunks.push_back(new Block[BlocksPerChunk]);
+        }
+        return chunks[chunkIndex][blockIndex++].storage;
+    }
+
+    std::vector<Block*> chunks;
+    Block* freeList;
+    size_t chunkIndex;
+    size_t blockIndex;
+    size_t liveCount;
+};
\ No newline at end of file
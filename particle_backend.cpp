@@ -0,0 +1,49 @@
+#include "particle_backend.h"
+#include <cmath>
+
+ParticleBackend::ParticleBackend(const ParticleConfig& config) {
+    world.init(config);
+}
+
+void ParticleBackend::spawnBody(int, const glm::vec3& position, const PhysicsSettings&) {
+    world.addParticle(position);
+}
+
+size_t ParticleBackend::spawnBatch(int, size_t count, const PhysicsSettings&) {
+    return world.spawn(count);
+}
+
+void ParticleBackend::readTransforms(float* positions, float* rotations, int* types) const {
+    const VectorBatch& position = world.getPositions();
+    for (size_t i = 0; i < world.size(); ++i) {
+        if (positions) {
+            positions[i * 3 + 0] = position.x[i];
+            positions[i * 3 + 1] = position.y[i];
+            positions[i * 3 + 2] = position.z[i];
+        }
+        if (rotations) {
+            rotations[i * 4 + 0] = 0.0f;
+            rotations[i * 4 + 1] = 0.0f;
+            rotations[i * 4 + 2] = 0.0f;
+            rotations[i * 4 + 3] = 1.0f;
+        }
+        if (types) {
+            types[i] = 1; // сфера
+        }
+    }
+}
+
+bool ParticleBackend::raycast(const glm::vec3& from, const glm::vec3& to, RayHit& hit) const {
+    size_t index = 0;
+    float fraction = 1.0f;
+    if (!world.raycast(from, to, index, fraction)) return false;
+
+    const VectorBatch& position = world.getPositions();
+    hit.body = index;
+    hit.fraction = fraction;
+    hit.point = from + (to - from) * fraction;
+    glm::vec3 outward = hit.point - glm::vec3(position.x[index], position.y[index], position.z[index]);
+    float length = glm::length(outward);
+    hit.normal = length > 0.0f ? outward / length : glm::vec3(0.0f, 1.0f, 0.0f);
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "physics_backend.h"
+#include "particle_world.h"
+
+// ParticleWorld за общим интерфейсом. Любой тип тела становится сферой
+// радиуса из конфигурации, вращений у частиц нет
+class ParticleBackend : public PhysicsBackend {
+public:
+    explicit ParticleBackend(const ParticleConfig& config = ParticleConfig());
+
+    const char* getName() const override { return "particles"; }
+
+    void spawnBody(int type, const glm::vec3& position, const PhysicsSettings& settings) override;
+    size_t spawnBatch(int type, size_t count, const PhysicsSettings& settings) override;
+    void clear(bool releaseMemory) override { world.clear(releaseMemory); }
+    void step(float stepTime, const PhysicsSettings& settings) override { world.stepSimulation(stepTime, settings); }
+
+    size_t getBodyCount() const override { return world.size(); }
+    void readTransforms(float* positions, float* rotations, int* types) const override;
+
+    void applyImpulse(size_t body, const glm::vec3& impulse) override { world.applyImpulse(body, impulse); }
+    void applyShake(const glm::vec2& windowVelocity, const PhysicsSettings& settings) override {
+        world.applyShake(windowVelocity, settings);
+    }
+
+    bool raycast(const glm::vec3& from, const glm::vec3& to, RayHit& hit) const override;
+
+    size_t getMemoryUsage() const override { return world.getMemoryUsage(); }
+
+    ParticleWorld& getWorld() { return world; }
+    const ParticleWorld& getWorld() const { return world; }
+
+private:
+    ParticleWorld world;
+};
\ No newline at end of file
@@ -0,0 +1,416 @@
+#include "particle_world.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+// Масса и цвет сферы такие же, как у сферы Bullet, созданной из интерфейса
+static const float SPHERE_MASS = 1.0f;
+static const float SPHERE_COLOR[3] = { 0.2f, 0.8f, 0.3f };
+static const float GRAVITY = -9.81f;
+// Пороги скоростей те же, что и у тел Bullet
+static const float STOP_SPEED = 0.01f;
+static const float MAX_LINEAR_SPEED = 30.0f;
+// Ограничение сетки по каждой оси: при очень мелких частицах ячейка растет
+static const int MAX_CELLS_PER_AXIS = 128;
+// Выталкивания прохода Якоби усредняются по контактам частицы и домножаются
+// на коэффициент верхней релаксации, иначе плотная куча сходится медленно
+static const float JACOBI_RELAXATION = 1.5f;
+// Запас пакета соседей под копирование четверками и дополнение
+static const size_t GATHER_SLACK = 8;
+// Позиция дополнения пакета соседей: никогда не пересекается с частицами
+static const float FAR_AWAY = 1e6f;
+
+static float nextJitter(uint32_t& state) {
+    state = state * 1664525u + 1013904223u;
+    return static_cast<float>(state >> 8) / 16777216.0f - 0.5f;
+}
+
+ParticleWorld::ParticleWorld()
+    : low(0.0f)
+    , high(0.0f)
+    , cellSize(1.0f)
+    , cellsPerAxis(1)
+    , spawnCount(0) {
+}
+
+void ParticleWorld::init(const ParticleConfig& config) {
+    this->config = config;
+    this->config.substeps = std::max(1, config.substeps);
+    this->config.contactIterations = std::max(1, config.contactIterations);
+
+    high = BOUNDARY_INNER - config.radius;
+    low = -high;
+
+    // Ячейка не меньше диаметра: все соседи частицы лежат в 27 ячейках вокруг нее
+    float extent = high - low;
+    cellSize = std::max(config.radius * 2.0f, extent / MAX_CELLS_PER_AXIS);
+    cellsPerAxis = std::max(1, static_cast<int>(std::ceil(extent / cellSize)));
+    cellStart.assign(static_cast<size_t>(cellsPerAxis) * cellsPerAxis * cellsPerAxis + 1, 0);
+
+    clear(true);
+}
+
+size_t ParticleWorld::spawn(size_t count) {
+    if (count == 0) return 0;
+
+    // Существующие частицы раскладываем по сетке, чтобы проверять места решетки
+    sortByCell();
+
+    const float spacing = config.radius * (2.0f + SPAWN_GAP);
+    const float jitter = config.radius * SPAWN_GAP * 0.5f;
+    const float extent = high - low;
+    const int sites = std::max(1, static_cast<int>(extent / spacing) + 1);
+    const float origin = low + (extent - (sites - 1) * spacing) * 0.5f;
+    const size_t existing = size();
+    const int n = cellsPerAxis;
+
+    std::vector<float> sites3;
+    sites3.reserve(std::min(count, static_cast<size_t>(sites) * sites * sites) * 3);
+
+    // Заполняем снизу вверх, чтобы частицы сразу лежали кучей
+    uint32_t state = 0x9E3779B9u ^ ++spawnCount;
+    size_t added = 0;
+    for (int y = 0; y < sites && added < count; ++y) {
+        for (int z = 0; z < sites && added < count; ++z) {
+            for (int x = 0; x < sites && added < count; ++x) {
+                float site[3] = {
+                    origin + x * spacing + nextJitter(state) * jitter * 2.0f,
+                    origin + y * spacing + nextJitter(state) * jitter * 2.0f,
+                    origin + z * spacing + nextJitter(state) * jitter * 2.0f
+                };
+
+                if (existing > 0) {
+                    int cx = std::min(n - 1, std::max(0, static_cast<int>((site[0] - low) / cellSize)));
+                    int cy = std::min(n - 1, std::max(0, static_cast<int>((site[1] - low) / cellSize)));
+                    int cz = std::min(n - 1, std::max(0, static_cast<int>((site[2] - low) / cellSize)));
+                    float unused[3] = { 0.0f, 0.0f, 0.0f };
+                    int overlaps = 0;
+                    for (int gy = std::max(0, cy - 1); gy <= std::min(n - 1, cy + 1) && overlaps == 0; ++gy) {
+                        for (int gz = std::max(0, cz - 1); gz <= std::min(n - 1, cz + 1) && overlaps == 0; ++gz) {
+                            size_t row = (static_cast<size_t>(gy) * n + gz) * n;
+                            overlaps += accumulateSphereContacts(position, cellStart[row + std::max(0, cx - 1)],
+                                cellStart[row + std::min(n - 1, cx + 1) + 1], SIZE_MAX, site, spacing, unused);
+                        }
+                    }
+                    if (overlaps > 0) continue;
+                }
+
+                sites3.insert(sites3.end(), site, site + 3);
+                ++added;
+            }
+        }
+    }
+
+    const size_t total = existing + added;
+    position.resize(total);
+    previous.resize(total);
+    velocity.resize(total);
+    renderPrevious.resize(total);
+    colors.resize(total * 3);
+    for (size_t k = 0; k < added; ++k) {
+        size_t i = existing + k;
+        position.x[i] = renderPrevious.x[i] = previous.x[i] = sites3[k * 3 + 0];
+        position.y[i] = renderPrevious.y[i] = previous.y[i] = sites3[k * 3 + 1];
+        position.z[i] = renderPrevious.z[i] = previous.z[i] = sites3[k * 3 + 2];
+        velocity.x[i] = velocity.y[i] = velocity.z[i] = 0.0f;
+
+        // Небольшой разброс яркости, чтобы в плотной куче были видны отдельные сферы
+        float shade = 1.0f + nextJitter(state) * 0.4f;
+        for (int c = 0; c < 3; ++c) {
+            colors[i * 3 + c] = SPHERE_COLOR[c] * shade;
+        }
+    }
+    stats.particles = total;
+    return added;
+}
+
+void ParticleWorld::addParticle(const glm::vec3& point) {
+    const size_t i = size();
+    const size_t total = i + 1;
+    position.resize(total);
+    previous.resize(total);
+    velocity.resize(total);
+    renderPrevious.resize(total);
+    position.x[i] = renderPrevious.x[i] = previous.x[i] = std::min(high, std::max(low, point.x));
+    position.y[i] = renderPrevious.y[i] = previous.y[i] = std::min(high, std::max(low, point.y));
+    position.z[i] = renderPrevious.z[i] = previous.z[i] = std::min(high, std::max(low, point.z));
+    velocity.x[i] = velocity.y[i] = velocity.z[i] = 0.0f;
+    colors.insert(colors.end(), SPHERE_COLOR, SPHERE_COLOR + 3);
+    stats.particles = total;
+}
+
+void ParticleWorld::clear(bool releaseMemory) {
+    VectorBatch* batches[] = { &position, &previous, &velocity, &renderPrevious, &delta, &neighbors };
+    for (VectorBatch* batch : batches) {
+        batch->resize(0);
+        if (releaseMemory) {
+            batch->x.shrink_to_fit();
+            batch->y.shrink_to_fit();
+            batch->z.shrink_to_fit();
+            batch->scale.shrink_to_fit();
+        }
+    }
+    colors.clear();
+    particleCell.clear();
+    sortedIndex.clear();
+    scratch.clear();
+    if (releaseMemory) {
+        colors.shrink_to_fit();
+        particleCell.shrink_to_fit();
+        sortedIndex.shrink_to_fit();
+        scratch.shrink_to_fit();
+    }
+    stats = ParticleStats();
+}
+
+void ParticleWorld::applyShake(const glm::vec2& windowVelocity, const PhysicsSettings& settings) {
+    // Импульс тот же, что в PhysicsWorld::applyForceToAll; у сферы нет
+    // вращения, поэтому момент не нужен
+    const float scale = settings.forceScale * 300.0f / SPHERE_MASS;
+    const float dv[3] = {
+        windowVelocity.x * settings.horizontalScale * scale,
+        -windowVelocity.y * settings.verticalScale * scale,
+        windowVelocity.y * settings.zScale * scale
+    };
+
+    const size_t count = size();
+    for (size_t i = 0; i < count; ++i) velocity.x[i] += dv[0];
+    for (size_t i = 0; i < count; ++i) velocity.y[i] += dv[1];
+    for (size_t i = 0; i < count; ++i) velocity.z[i] += dv[2];
+}
+
+void ParticleWorld::applyImpulse(size_t index, const glm::vec3& impulse) {
+    if (index >= size()) return;
+    velocity.x[index] += impulse.x / SPHERE_MASS;
+    velocity.y[index] += impulse.y / SPHERE_MASS;
+    velocity.z[index] += impulse.z / SPHERE_MASS;
+}
+
+void ParticleWorld::stepSimulation(float stepTime, const PhysicsSettings& settings) {
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point start = Clock::now();
+
+    const size_t count = size();
+    renderPrevious.x.assign(position.x.begin(), position.x.end());
+    renderPrevious.y.assign(position.y.begin(), position.y.end());
+    renderPrevious.z.assign(position.z.begin(), position.z.end());
+
+    const float h = stepTime / config.substeps;
+    // Линейное затухание в той же форме, что у Bullet: v *= (1 - damping)^dt
+    const float damping = std::pow(std::max(0.0f, 1.0f - settings.damping), h);
+
+    int contacts = 0;
+    if (count > 0) {
+        for (int substep = 0; substep < config.substeps; ++substep) {
+            computeClampScales(velocity, STOP_SPEED, MAX_LINEAR_SPEED);
+            integrateParticles(position, previous, velocity, GRAVITY, damping, h);
+            sortByCell();
+            for (int iteration = 0; iteration < config.contactIterations; ++iteration) {
+                contacts = solveContacts();
+                constrainParticles(position, low, high);
+            }
+            updateParticleVelocities(position, previous, velocity, 1.0f / h, low, high, settings.restitution);
+        }
+    }
+
+    stats.particles = count;
+    stats.contacts = contacts;
+    stats.stepMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+void ParticleWorld::writePositions(float alpha, std::vector<float>& positions) const {
+    const size_t count = size();
+    positions.resize(count * 3);
+    for (size_t i = 0; i < count; ++i) {
+        positions[i * 3 + 0] = renderPrevious.x[i] + (position.x[i] - renderPrevious.x[i]) * alpha;
+        positions[i * 3 + 1] = renderPrevious.y[i] + (position.y[i] - renderPrevious.y[i]) * alpha;
+        positions[i * 3 + 2] = renderPrevious.z[i] + (position.z[i] - renderPrevious.z[i]) * alpha;
+    }
+}
+
+bool ParticleWorld::raycast(const glm::vec3& from, const glm::vec3& to, size_t& index, float& fraction) const {
+    const float d[3] = { to.x - from.x, to.y - from.y, to.z - from.z };
+    const float a = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+    if (a <= 0.0f) return false;
+    const float radiusSq = config.radius * config.radius;
+
+    // |from + t * d - center|^2 = r^2: меньший корень квадратного уравнения по t
+    bool found = false;
+    float best = 1.0f;
+    const size_t count = size();
+    for (size_t i = 0; i < count; ++i) {
+        const float m[3] = { from.x - position.x[i], from.y - position.y[i], from.z - position.z[i] };
+        const float b = m[0] * d[0] + m[1] * d[1] + m[2] * d[2];
+        const float c = m[0] * m[0] + m[1] * m[1] + m[2] * m[2] - radiusSq;
+        if (c > 0.0f && b > 0.0f) continue; // начало снаружи и луч уходит от частицы
+        const float discriminant = b * b - a * c;
+        if (discriminant < 0.0f) continue;
+        const float t = std::max(0.0f, (-b - std::sqrt(discriminant)) / a);
+        if (t <= best) {
+            best = t;
+            index = i;
+            found = true;
+        }
+    }
+    if (found) fraction = best;
+    return found;
+}
+
+size_t ParticleWorld::getMemoryUsage() const {
+    size_t floats = colors.capacity() + scratch.capacity();
+    const VectorBatch* batches[] = { &position, &previous, &velocity, &renderPrevious, &delta, &neighbors };
+    for (const VectorBatch* batch : batches) {
+        floats += batch->x.capacity() + batch->y.capacity() + batch->z.capacity() + batch->scale.capacity();
+    }
+    size_t indices = cellStart.capacity() + particleCell.capacity() + sortedIndex.capacity();
+    return floats * sizeof(float) + indices * sizeof(uint32_t);
+}
+
+// Переставляет окно [first, last) массива по новому порядку; stride - число
+// float на частицу. Порядок вне окна тождественный и не трогается
+static void permute(std::vector<float>& values, const std::vector<uint32_t>& order, size_t first, size_t last,
+    size_t stride, std::vector<float>& scratch) {
+    scratch.resize((last - first) * stride);
+    for (size_t k = first; k < last; ++k) {
+        const float* from = &values[order[k] * stride];
+        std::copy(from, from + stride, &scratch[(k - first) * stride]);
+    }
+    std::copy(scratch.begin(), scratch.end(), values.begin() + first * stride);
+}
+
+void ParticleWorld::sortByCell() {
+    const size_t count = size();
+    const int n = cellsPerAxis;
+    const float invCell = 1.0f / cellSize;
+    particleCell.resize(count);
+    sortedIndex.resize(count);
+
+    // Подсчет частиц по ячейкам, включающие префиксные суммы дают концы ячеек
+    std::fill(cellStart.begin(), cellStart.end(), 0);
+    for (size_t i = 0; i < count; ++i) {
+        int cx = std::min(n - 1, std::max(0, static_cast<int>((position.x[i] - low) * invCell)));
+        int cy = std::min(n - 1, std::max(0, static_cast<int>((position.y[i] - low) * invCell)));
+        int cz = std::min(n - 1, std::max(0, static_cast<int>((position.z[i] - low) * invCell)));
+        uint32_t cell = static_cast<uint32_t>((cy * n + cz) * n + cx);
+        particleCell[i] = cell;
+        ++cellStart[cell];
+    }
+    for (size_t c = 1; c < cellStart.size(); ++c) {
+        cellStart[c] += cellStart[c - 1];
+    }
+
+    // Раскладка с конца: порядок внутри ячейки сохраняется, а cellStart[c]
+    // после нее указывает на начало ячейки c
+    for (size_t i = count; i-- > 0;) {
+        sortedIndex[--cellStart[particleCell[i]]] = static_cast<uint32_t>(i);
+    }
+    cellStart.back() = static_cast<uint32_t>(count);
+
+    // Между подшагами ячейку меняет малая доля частиц: переставляем только окно
+    // от первой до последней сдвинувшейся, а в покоящейся куче - ничего
+    size_t first = 0;
+    while (first < count && sortedIndex[first] == first) ++first;
+    if (first == count) return;
+    size_t last = count;
+    while (sortedIndex[last - 1] == last - 1) --last;
+
+    VectorBatch* batches[] = { &position, &previous, &velocity, &renderPrevious };
+    for (VectorBatch* batch : batches) {
+        permute(batch->x, sortedIndex, first, last, 1, scratch);
+        permute(batch->y, sortedIndex, first, last, 1, scratch);
+        permute(batch->z, sortedIndex, first, last, 1, scratch);
+    }
+    permute(colors, sortedIndex, first, last, 3, scratch);
+}
+
+// Копирует позиции [begin, end) в пакет соседей с позиции at. Копия идет
+// четверками с запасом за концом диапазона: лишнее перезапишет следующий
+// диапазон или дополнение, а короткие диапазоны не дают непредсказуемых ветвлений
+static void gatherRange(const VectorBatch& source, uint32_t begin, uint32_t end, VectorBatch& target, size_t at) {
+    const float* sx = source.x.data();
+    const float* sy = source.y.data();
+    const float* sz = source.z.data();
+    float* tx = target.x.data() + at;
+    float* ty = target.y.data() + at;
+    float* tz = target.z.data() + at;
+    const size_t available = source.size();
+    uint32_t j = begin;
+    for (; j < end && j + 4 <= available; j += 4, tx += 4, ty += 4, tz += 4) {
+        std::copy(sx + j, sx + j + 4, tx);
+        std::copy(sy + j, sy + j + 4, ty);
+        std::copy(sz + j, sz + j + 4, tz);
+    }
+    for (; j < end; ++j) {
+        *tx++ = sx[j];
+        *ty++ = sy[j];
+        *tz++ = sz[j];
+    }
+}
+
+int ParticleWorld::solveContacts() {
+    const size_t count = size();
+    const int n = cellsPerAxis;
+    const float diameter = config.radius * 2.0f;
+    const uint32_t* start = cellStart.data();
+    delta.resize(count);
+
+    // Якоби: все выталкивания считаются по позициям начала прохода. Сетка
+    // от начала подшага: за проход частицы смещаются на доли радиуса.
+    int contacts = 0;
+    for (int cy = 0; cy < n; ++cy) {
+        for (int cz = 0; cz < n; ++cz) {
+            const size_t rowStart = (static_cast<size_t>(cy) * n + cz) * n;
+            if (start[rowStart] == start[rowStart + n]) continue;
+
+            for (int cx = 0; cx < n; ++cx) {
+                const size_t cell = rowStart + cx;
+                if (start[cell] == start[cell + 1]) continue;
+                const int x0 = std::max(0, cx - 1);
+                const int x1 = std::min(n - 1, cx + 1);
+
+                // Соседние ячейки одной строки лежат подряд: 9 непрерывных диапазонов
+                // копируются в один плотный пакет, общий для всех частиц ячейки
+                size_t gathered = 0;
+                size_t selfOffset = 0; // частица i лежит в пакете по индексу i - selfOffset
+                for (int gy = std::max(0, cy - 1); gy <= std::min(n - 1, cy + 1); ++gy) {
+                    for (int gz = std::max(0, cz - 1); gz <= std::min(n - 1, cz + 1); ++gz) {
+                        size_t row = (static_cast<size_t>(gy) * n + gz) * n;
+                        uint32_t begin = start[row + x0];
+                        uint32_t end = start[row + x1 + 1];
+                        if (gathered + (end - begin) + GATHER_SLACK > neighbors.size()) {
+                            neighbors.resize((gathered + (end - begin)) * 2 + GATHER_SLACK);
+                        }
+                        if (gy == cy && gz == cz) selfOffset = begin - gathered;
+                        gatherRange(position, begin, end, neighbors, gathered);
+                        gathered += end - begin;
+                    }
+                }
+
+                // Дополняем пакет далекими частицами до кратного четырем - ядро идет без хвоста
+                for (; gathered & 3; ++gathered) {
+                    neighbors.x[gathered] = neighbors.y[gathered] = neighbors.z[gathered] = FAR_AWAY;
+                }
+
+                for (uint32_t i = start[cell]; i < start[cell + 1]; ++i) {
+                    float center[3] = { position.x[i], position.y[i], position.z[i] };
+                    float push[3] = { 0.0f, 0.0f, 0.0f };
+                    int particleContacts = accumulateSphereContacts(neighbors, 0, gathered, i - selfOffset,
+                        center, diameter, push);
+
+                    float scale = particleContacts > 0 ? JACOBI_RELAXATION / particleContacts : 0.0f;
+                    delta.x[i] = push[0] * scale;
+                    delta.y[i] = push[1] * scale;
+                    delta.z[i] = push[2] * scale;
+                    contacts += particleContacts;
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < count; ++i) position.x[i] += delta.x[i];
+    for (size_t i = 0; i < count; ++i) position.y[i] += delta.y[i];
+    for (size_t i = 0; i < count; ++i) position.z[i] += delta.z[i];
+
+    // Каждая пара посчитана с обеих сторон
+    return contacts / 2;
+}
\ No newline at end of file
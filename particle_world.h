@@ -0,0 +1,87 @@
+#pragma once
+
+#include "physics_types.h"
+#include "kernels.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Параметры мира частиц
+struct ParticleConfig {
+    float radius = 0.05f;
+    int substeps = 1;          // подшагов на один шаг физики
+    int contactIterations = 2; // проходов разрешения контактов на подшаг
+};
+
+// Счетчики последнего шага
+struct ParticleStats {
+    size_t particles = 0;
+    int contacts = 0;
+    double stepMs = 0.0;
+};
+
+// Второй движок для сцен только из сфер одного радиуса внутри коробки.
+// Частицы хранятся структурой массивов и шагают позиционной схемой:
+// интегрирование, сортировка подсчетом по равномерной сетке, проходы
+// Якоби по соседним ячейкам и аналитические стены. Bullet не используется.
+class ParticleWorld {
+public:
+    ParticleWorld();
+
+    void init(const ParticleConfig& config = ParticleConfig());
+    // Раскладывает частицы по решетке снизу вверх со случайным сдвигом, пропуская
+    // места, занятые уже существующими. Возвращает число добавленных частиц.
+    size_t spawn(size_t count);
+    // Одна частица в точке, зажатой в коробку; пересечения разведут контакты
+    void addParticle(const glm::vec3& point);
+    void clear(bool releaseMemory);
+
+    // Та же встряска окна, что и у тел Bullet: импульс сферы, деленный на ее массу
+    void applyShake(const glm::vec2& windowVelocity, const PhysicsSettings& settings);
+    void applyImpulse(size_t index, const glm::vec3& impulse);
+    void stepSimulation(float stepTime, const PhysicsSettings& settings);
+
+    // Ближайшая частица на отрезке from-to перебором. fraction - доля отрезка
+    // до точки входа, для начала луча внутри частицы - 0
+    bool raycast(const glm::vec3& from, const glm::vec3& to, size_t& index, float& fraction) const;
+
+    // Позиции, интерполированные между двумя последними шагами, float[3 * N]
+    void writePositions(float alpha, std::vector<float>& positions) const;
+    // Цвета частиц в том же порядке, float[3 * N]
+    const float* getColors() const { return colors.data(); }
+    // Позиции после последнего шага; порядок частиц меняется при сортировке по сетке
+    const VectorBatch& getPositions() const { return position; }
+
+    size_t size() const { return position.size(); }
+    float getRadius() const { return config.radius; }
+    ParticleStats getStats() const { return stats; }
+    // Память всех массивов частиц и сетки в байтах
+    size_t getMemoryUsage() const;
+
+private:
+    void sortByCell();
+    int solveContacts();
+
+    ParticleConfig config;
+    float low;  // границы центров частиц по каждой оси
+    float high;
+
+    VectorBatch position;
+    VectorBatch previous;       // позиция в начале подшага
+    VectorBatch velocity;
+    VectorBatch renderPrevious; // позиция в начале шага, для интерполяции рендера
+    VectorBatch delta;          // накопленные выталкивания прохода Якоби
+    VectorBatch neighbors;      // позиции соседей текущей ячейки подряд
+    std::vector<float> colors;
+
+    // Сетка: ячейки по строкам вдоль x, частицы отсортированы по ячейкам
+    float cellSize;
+    int cellsPerAxis;
+    std::vector<uint32_t> cellStart; // первая частица ячейки, последний элемент - N
+    std::vector<uint32_t> particleCell;
+    std::vector<uint32_t> sortedIndex;
+    std::vector<float> scratch; // буфер перестановки окна массива
+
+    uint32_t spawnCount;
+    ParticleStats stats;
+};
\ No newline at end of file
@@ -1,31 +1,228 @@
 #include "physics.h"
+#include "uniform_grid_broadphase.h"
+#include <bullet/BulletDynamics/ConstraintSolver/btNNCGConstraintSolver.h>
+#include <cstring>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <unordered_set>
+
+// Пороги скоростей: ниже STOP_SPEED тело останавливается, выше максимума - ограничивается
+static const float STOP_SPEED = 0.01f;
+static const float MAX_LINEAR_SPEED = 30.0f;
+static const float MAX_ANGULAR_SPEED = 15.0f;
+
+// Порог CCD без адаптивной политики: свип на любом движении
+static const float ALWAYS_CCD_THRESHOLD = 1e-7f;
+
+// Пружина перетаскивания: собственная частота точки захвата в Гц и
+// критическое затухание. Ускорение ограничено, чтобы рывок мыши не швырял тело
+static const float DRAG_FREQUENCY = 3.0f;
+static const float DRAG_DAMPING_RATIO = 1.0f;
+static const float DRAG_MAX_ACCELERATION = 200.0f;
+
+// Запросов на одну задачу при параллельном пакете
+static const int QUERY_GRAIN = 256;
+
+// Шаг решетки spawnLattice для тел единичного размера: описанная сфера самого
+// крупного из них (куба) с зазором
+static const float LATTICE_SPACING = 1.8f;
+
+InterpolatedMotionState::InterpolatedMotionState(const btTransform& startTrans, const unsigned int* tickCounter)
+    : previous(startTrans)
+    , current(startTrans)
+    , tickCounter(tickCounter)
+    , updatedTick(*tickCounter) {
+}
+
+void InterpolatedMotionState::getWorldTransform(btTransform& worldTrans) const {
+    worldTrans = current;
+}
+
+void InterpolatedMotionState::setWorldTransform(const btTransform& worldTrans) {
+    previous = current;
+    current = worldTrans;
+    updatedTick = *tickCounter;
+}
+
+void InterpolatedMotionState::reset(const btTransform& trans) {
+    previous = trans;
+    current = trans;
+    updatedTick = *tickCounter;
+}
+
+void InterpolatedMotionState::getStepTransforms(btTransform& previousTrans, btTransform& currentTrans) const {
+    // Тело не обновлялось на последнем шаге - оно стоит на месте
+    previousTrans = updatedTick == *tickCounter ? previous : current;
+    currentTrans = current;
+}
 
 PhysicsWorld::PhysicsWorld() 
     : collisionConfiguration(nullptr)
     , dispatcher(nullptr)
     , overlappingPairCache(nullptr)
     , solver(nullptr)
-    , dynamicsWorld(nullptr) {
+    , dynamicsWorld(nullptr)
+    , numThreads(1)
+    , broadphaseType(BroadphaseType::Dbvt)
+    , fastNarrowphaseEnabled(false)
+    , shakeCount(0)
+    , sleepingEnabled(true)
+    , sleepLinearThreshold(0.8f)
+    , sleepAngularThreshold(1.0f)
+    , adaptiveCcd(true)
+    , ccdMotionFraction(0.5f)
+    , ccdArmedCount(0)
+    , solverType(SolverType::SequentialImpulse)
+    , contactEventsEnabled(true)
+    , contactImpulseThreshold(1.0f)
+    , querySnapshotValid(false)
+    , dragPivot(0, 0, 0)
+    , dragTarget(0, 0, 0)
+    , dragDistance(0.0f)
+    , tickCount(0) {
 }
 
 PhysicsWorld::~PhysicsWorld() {
     cleanup();
 }
 
-void PhysicsWorld::init() {
-    collisionConfiguration = new btDefaultCollisionConfiguration();
-    dispatcher = new btCollisionDispatcher(collisionConfiguration);
-    overlappingPairCache = new btDbvtBroadphase();
-    solver = new btSequentialImpulseConstraintSolver;
-    dynamicsWorld = new btDiscreteDynamicsWorld(dispatcher, overlappingPairCache, solver, collisionConfiguration);
+#ifdef WCP_BULLET_MT
+// Планировщик задач Bullet глобальный, создаем его один раз на процесс
+static btITaskScheduler* getTaskScheduler() {
+    static btITaskScheduler* scheduler = btCreateDefaultTaskScheduler();
+    return scheduler;
+}
+#endif
+
+bool PhysicsWorld::isMultithreadingAvailable() {
+#ifdef WCP_BULLET_MT
+    return getTaskScheduler() != nullptr;
+#else
+    return false;
+#endif
+}
+
+const char* broadphaseName(BroadphaseType type) {
+    switch (type) {
+        case BroadphaseType::Dbvt: return "dbvt";
+        case BroadphaseType::AxisSweep3: return "sap";
+        case BroadphaseType::AxisSweep3_32: return "sap32";
+        case BroadphaseType::UniformGrid: return "grid";
+    }
+    return "unknown";
+}
+
+bool parseBroadphaseType(const char* name, BroadphaseType& type) {
+    const BroadphaseType types[] = {
+        BroadphaseType::Dbvt, BroadphaseType::AxisSweep3, BroadphaseType::AxisSweep3_32, BroadphaseType::UniformGrid
+    };
+    for (BroadphaseType candidate : types) {
+        if (strcmp(name, broadphaseName(candidate)) == 0) {
+            type = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* solverName(SolverType type) {
+    switch (type) {
+        case SolverType::SequentialImpulse: return "si";
+        case SolverType::NNCG: return "nncg";
+    }
+    return "unknown";
+}
+
+bool parseSolverType(const char* name, SolverType& type) {
+    for (SolverType candidate : { SolverType::SequentialImpulse, SolverType::NNCG }) {
+        if (strcmp(name, solverName(candidate)) == 0) {
+            type = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+static btSequentialImpulseConstraintSolver* createSolver(SolverType type) {
+    if (type == SolverType::NNCG) {
+        return new btNNCGConstraintSolver();
+    }
+    return new btSequentialImpulseConstraintSolver();
+}
+
+static btBroadphaseInterface* createBroadphase(const PhysicsWorldConfig& config) {
+    // Границы мира: стены коробки с запасом на их толщину и вылет тел
+    btVector3 worldMin(-BOUNDARY_SIZE - 1.0f, -BOUNDARY_SIZE - 1.0f, -BOUNDARY_SIZE - 1.0f);
+    btVector3 worldMax(BOUNDARY_SIZE + 1.0f, BOUNDARY_SIZE + 1.0f, BOUNDARY_SIZE + 1.0f);
+
+    switch (config.broadphase) {
+        case BroadphaseType::AxisSweep3:
+            return new btAxisSweep3(worldMin, worldMax, AXIS_SWEEP_MAX_HANDLES);
+        case BroadphaseType::AxisSweep3_32:
+            return new bt32BitAxisSweep3(worldMin, worldMax);
+        case BroadphaseType::UniformGrid:
+            return new UniformGridBroadphase(worldMin, worldMax, config.gridCellSize);
+        case BroadphaseType::Dbvt:
+        default:
+            return new btDbvtBroadphase();
+    }
+}
+
+void PhysicsWorld::init(const PhysicsWorldConfig& config) {
+    // Пул алгоритмов конфигурации должен вмещать и собственные алгоритмы
+    btDefaultCollisionConstructionInfo constructionInfo;
+    constructionInfo.m_customCollisionAlgorithmMaxElementSize = FastNarrowphase::getMaxAlgorithmSize();
+    collisionConfiguration = new btDefaultCollisionConfiguration(constructionInfo);
+    overlappingPairCache = createBroadphase(config);
+    broadphaseType = config.broadphase;
+    fastNarrowphaseEnabled = config.fastNarrowphase;
+    solverType = SolverType::SequentialImpulse;
+    solverController.reset();
+    contactTracker.reset();
+    contactEvents.init(config.contactEventCapacity);
+    numThreads = 1;
+    bool multithreaded = false;
+
+#ifdef WCP_BULLET_MT
+    btITaskScheduler* scheduler = config.numThreads != 1 ? getTaskScheduler() : nullptr;
+    if (scheduler) {
+        int threads = config.numThreads > 0 ? config.numThreads : static_cast<int>(std::thread::hardware_concurrency());
+        numThreads = std::clamp(threads, 1, scheduler->getMaxNumThreads());
+        scheduler->setNumThreads(numThreads);
+        btSetTaskScheduler(scheduler);
+
+        multithreaded = true;
+        dispatcher = new btCollisionDispatcherMt(collisionConfiguration, 40);
+        btConstraintSolverPoolMt* solverPool = new btConstraintSolverPoolMt(numThreads);
+        solver = solverPool;
+        dynamicsWorld = new InstrumentedWorld<btDiscreteDynamicsWorldMt>(&timings,
+            dispatcher, overlappingPairCache, solverPool, nullptr, collisionConfiguration);
+    }
+#endif
+
+    if (!multithreaded) {
+        dispatcher = new btCollisionDispatcher(collisionConfiguration);
+        solver = new btSequentialImpulseConstraintSolver;
+        dynamicsWorld = new InstrumentedWorld<btDiscreteDynamicsWorld>(&timings,
+            dispatcher, overlappingPairCache, solver, collisionConfiguration);
+    }
+
+    if (fastNarrowphaseEnabled) {
+        fastNarrowphase.registerSphereAlgorithms(dispatcher);
+    }
     
+    dynamicsWorld->setInternalTickCallback(&PhysicsWorld::preTickCallback, this, true);
+
     // Нормальная земная гравитация
     dynamicsWorld->setGravity(btVector3(0, -9.81f, 0));
     
     // Улучшенные настройки симуляции
     dynamicsWorld->getSolverInfo().m_solverMode |= SOLVER_ENABLE_FRICTION_DIRECTION_CACHING;
-    dynamicsWorld->getSolverInfo().m_numIterations = 10;
-    dynamicsWorld->getDispatchInfo().m_allowedCcdPenetration = 0.0001f;
+    dynamicsWorld->getSolverInfo().m_numIterations = solverSettings.maxSolverIterations;
+    // Значение Bullet по умолчанию: при меньшем свип останавливает тела уже на касании
+    dynamicsWorld->getDispatchInfo().m_allowedCcdPenetration = 0.04f;
     
     // Настройки стабильности
     dynamicsWorld->getSolverInfo().m_splitImpulse = true;
@@ -46,40 +243,362 @@ void PhysicsWorld::cleanup() {
     overlappingPairCache = nullptr;
     dispatcher = nullptr;
     collisionConfiguration = nullptr;
+    querySnapshot.clear();
+    querySnapshotValid = false;
+    dragBody = BodyHandle();
 }
 
-void PhysicsWorld::stepSimulation(float deltaTime) {
-    for (int i = 0; i < dynamicsWorld->getNumCollisionObjects(); i++) {
-        btCollisionObject* obj = dynamicsWorld->getCollisionObjectArray()[i];
-        btRigidBody* body = btRigidBody::upcast(obj);
-        if (body && !body->isStaticObject()) {
-            btVector3 velocity = body->getLinearVelocity();
-            btVector3 angVel = body->getAngularVelocity();
-            
-            // Остановка при малых скоростях
-            if (velocity.length() < 0.01f) {
-                body->setLinearVelocity(btVector3(0,0,0));
-            }
-            if (angVel.length() < 0.01f) {
-                body->setAngularVelocity(btVector3(0,0,0));
-            }
-            
-            // Ограничение максимальных скоростей
-            if (velocity.length() > 30.0f) {
-                velocity = velocity.normalized() * 30.0f;
-                body->setLinearVelocity(velocity);
+BroadphaseStats PhysicsWorld::getBroadphaseStats() const {
+    BroadphaseStats stats;
+    stats.pairMs = timings.pairMs;
+    stats.overlappingPairs = overlappingPairCache->getOverlappingPairCache()->getNumOverlappingPairs();
+    return stats;
+}
+
+void PhysicsWorld::rayTest(const btVector3& from, const btVector3& to, btCollisionWorld::RayResultCallback& callback) const {
+    dynamicsWorld->rayTest(from, to, callback);
+}
+
+#ifdef WCP_BULLET_MT
+// Куски пакета для планировщика Bullet. Ответы лучей у каждого запроса свои,
+// ответы областей - у каждого куска свои и склеиваются после
+struct RaycastLoop : public btIParallelForBody {
+    const QuerySnapshot* snapshot;
+    const RayQuery* queries;
+    RayQueryHit* hits;
+
+    void forLoop(int begin, int end) const override {
+        snapshot->raycast(queries + begin, static_cast<size_t>(end - begin), hits + begin);
+    }
+};
+
+template <typename Query>
+struct OverlapLoop : public btIParallelForBody {
+    const QuerySnapshot* snapshot;
+    const Query* queries;
+    size_t count;
+    QueryResults* chunks;
+
+    void forLoop(int begin, int end) const override {
+        for (int chunk = begin; chunk < end; ++chunk) {
+            size_t first = static_cast<size_t>(chunk) * QUERY_GRAIN;
+            snapshot->overlap(queries + first, std::min<size_t>(QUERY_GRAIN, count - first), chunks[chunk]);
+        }
+    }
+};
+#endif
+
+const QuerySnapshot& PhysicsWorld::getQuerySnapshot() {
+    if (!querySnapshotValid) {
+        ProfileScope scope(profile, "querySnapshot");
+        querySnapshot.build(dynamicBodies);
+        querySnapshotValid = true;
+    }
+    return querySnapshot;
+}
+
+void PhysicsWorld::raycast(const RayQuery* queries, size_t count, RayQueryHit* hits) {
+    const QuerySnapshot& snapshot = getQuerySnapshot();
+#ifdef WCP_BULLET_MT
+    if (numThreads > 1 && count > static_cast<size_t>(QUERY_GRAIN)) {
+        RaycastLoop loop;
+        loop.snapshot = &snapshot;
+        loop.queries = queries;
+        loop.hits = hits;
+        btParallelFor(0, static_cast<int>(count), QUERY_GRAIN, loop);
+        return;
+    }
+#endif
+    snapshot.raycast(queries, count, hits);
+}
+
+template <typename Query>
+void PhysicsWorld::overlapBatch(const Query* queries, size_t count, QueryResults& results) {
+    const QuerySnapshot& snapshot = getQuerySnapshot();
+#ifdef WCP_BULLET_MT
+    if (numThreads > 1 && count > static_cast<size_t>(QUERY_GRAIN)) {
+        size_t chunkCount = (count + QUERY_GRAIN - 1) / QUERY_GRAIN;
+        if (queryChunks.size() < chunkCount) {
+            queryChunks.resize(chunkCount);
+        }
+        OverlapLoop<Query> loop;
+        loop.snapshot = &snapshot;
+        loop.queries = queries;
+        loop.count = count;
+        loop.chunks = queryChunks.data();
+        btParallelFor(0, static_cast<int>(chunkCount), 1, loop);
+
+        results.clear();
+        for (size_t chunk = 0; chunk < chunkCount; ++chunk) {
+            results.append(queryChunks[chunk]);
+        }
+        return;
+    }
+#endif
+    snapshot.overlap(queries, count, results);
+}
+
+void PhysicsWorld::overlap(const SphereQuery* queries, size_t count, QueryResults& results) {
+    overlapBatch(queries, count, results);
+}
+
+void PhysicsWorld::overlap(const AabbQuery* queries, size_t count, QueryResults& results) {
+    overlapBatch(queries, count, results);
+}
+
+bool PhysicsWorld::beginDrag(const btVector3& from, const btVector3& to) {
+    RayQuery query = { from, to };
+    RayQueryHit hit;
+    getQuerySnapshot().raycast(&query, 1, &hit);
+    btRigidBody* body = getBody(hit.handle);
+    dragBody = body ? hit.handle : BodyHandle();
+    if (!body) return false;
+
+    dragPivot = body->getCenterOfMassTransform().inverse() * hit.point;
+    dragTarget = hit.point;
+    dragDistance = (hit.point - from).length();
+    body->activate(true);
+    return true;
+}
+
+void PhysicsWorld::updateDrag(const btVector3& from, const btVector3& to) {
+    btVector3 direction = to - from;
+    if (!dragBody.isValid() || direction.fuzzyZero()) return;
+    dragTarget = from + direction.normalized() * dragDistance;
+}
+
+void PhysicsWorld::endDrag() {
+    dragBody = BodyHandle();
+}
+
+void PhysicsWorld::applyDragSpring() {
+    if (!dragBody.isValid()) return;
+    btRigidBody* body = getBody(dragBody);
+    if (!body) {
+        // Тело удалили во время перетаскивания
+        dragBody = BodyHandle();
+        return;
+    }
+
+    // Ускорение точки захвата от пружины с затуханием. Сила делится на
+    // эффективную массу в этой точке, поэтому легкое и тяжелое тело, за центр
+    // или за край, идут за курсором одинаково
+    const btScalar omega = SIMD_2_PI * DRAG_FREQUENCY;
+    btVector3 pivot = body->getCenterOfMassTransform() * dragPivot;
+    btVector3 relativePivot = pivot - body->getCenterOfMassPosition();
+    btVector3 acceleration = (dragTarget - pivot) * (omega * omega)
+        - body->getVelocityInLocalPoint(relativePivot) * (2.0f * DRAG_DAMPING_RATIO * omega);
+    btScalar magnitude = acceleration.length();
+    if (magnitude < SIMD_EPSILON) return;
+    if (magnitude > DRAG_MAX_ACCELERATION) {
+        acceleration *= DRAG_MAX_ACCELERATION / magnitude;
+    }
+
+    btScalar denominator = body->computeImpulseDenominator(pivot, acceleration / magnitude);
+    if (denominator < SIMD_EPSILON) return;
+    body->activate(true);
+    body->applyForce(acceleration / denominator, relativePivot);
+}
+
+size_t PhysicsWorld::getMemoryUsage() const {
+    size_t bytes = bodyPool.capacity() * sizeof(btRigidBody)
+        + motionStatePool.capacity() * sizeof(InterpolatedMotionState)
+        + dynamicBodies.getMemoryUsage()
+        + (activeBodies.capacity() + shakeBodies.capacity()) * sizeof(btRigidBody*)
+        + (linearBatch.x.capacity() + angularBatch.x.capacity()) * sizeof(float) * 4
+        + querySnapshot.getMemoryUsage();
+
+    // Внутренние структуры Bullet: на каждое тело - прокси broadphase и место
+    // в массиве объектов мира, на каждую пару - запись кэша и манифолд
+    int objectCount = dynamicsWorld->getNumCollisionObjects();
+    bytes += objectCount * (sizeof(btDbvtProxy) + sizeof(btCollisionObject*));
+    bytes += overlappingPairCache->getOverlappingPairCache()->getNumOverlappingPairs() * sizeof(btBroadphasePair);
+    bytes += dispatcher->getNumManifolds() * sizeof(btPersistentManifold);
+    return bytes;
+}
+
+// Один шаг фиксированной длины; накопление времени кадра - в FixedTimestep
+void PhysicsWorld::stepSimulation(float stepTime) {
+    ++tickCount;
+    querySnapshotValid = false;
+    {
+        ProfileScope scope(profile, "worldStep");
+        dynamicsWorld->stepSimulation(stepTime, 0);
+        profile.addBulletTree();
+    }
+    if (contactEventsEnabled) {
+        ProfileScope scope(profile, "contactEvents");
+        contactTracker.update(dispatcher, contactImpulseThreshold, dynamicBodies, contactEvents);
+    }
+
+    btContactSolverInfo& info = dynamicsWorld->getSolverInfo();
+    info.m_numIterations = solverController.update(timings.solveMs, info.m_numIterations, solverSettings);
+}
+
+void PhysicsWorld::setSolverSettings(const PhysicsSettings& settings) {
+    solverSettings = settings;
+    SolverType type = settings.solverType == 1 ? SolverType::NNCG : SolverType::SequentialImpulse;
+    if (type != solverType) {
+        setSolverType(type);
+    }
+
+    btContactSolverInfo& info = dynamicsWorld->getSolverInfo();
+    // Решатель прекращает итерации, как только невязка падает ниже порога
+    info.m_leastSquaresResidualThreshold = settings.solverResidualThreshold;
+    if (!SolverController::isAdaptive(settings)) {
+        info.m_numIterations = std::max(settings.maxSolverIterations, 1);
+    }
+}
+
+void PhysicsWorld::setSolverType(SolverType type) {
+    btConstraintSolver* newSolver = nullptr;
+#ifdef WCP_BULLET_MT
+    if (dynamic_cast<btConstraintSolverPoolMt*>(solver)) {
+        // Пул владеет решателями и удаляет их вместе с собой
+        std::vector<btConstraintSolver*> solvers(numThreads);
+        for (btConstraintSolver*& threadSolver : solvers) {
+            threadSolver = createSolver(type);
+        }
+        newSolver = new btConstraintSolverPoolMt(solvers.data(), numThreads);
+    }
+#endif
+    if (!newSolver) {
+        newSolver = createSolver(type);
+    }
+
+    dynamicsWorld->setConstraintSolver(newSolver);
+    delete solver;
+    solver = newSolver;
+    solverType = type;
+    // Цена итерации у другого решателя своя - оцениваем заново
+    solverController.reset();
+}
+
+void PhysicsWorld::setContactEvents(bool enabled, float impulseThreshold) {
+    if (!enabled && contactEventsEnabled) {
+        // Пары, отслеженные до выключения, не должны дать события конца потом
+        contactTracker.reset();
+    }
+    contactEventsEnabled = enabled;
+    contactImpulseThreshold = impulseThreshold;
+}
+
+SolverStats PhysicsWorld::getSolverStats() const {
+    SolverStats stats;
+    stats.type = solverType;
+    stats.iterations = dynamicsWorld->getSolverInfo().m_numIterations;
+    stats.solveMs = timings.solveMs;
+    return stats;
+}
+
+// Вызывается Bullet перед каждым внутренним шагом
+void PhysicsWorld::preTickCallback(btDynamicsWorld* world, btScalar timeStep) {
+    static_cast<PhysicsWorld*>(world->getWorldUserInfo())->onPreTick(timeStep);
+}
+
+void PhysicsWorld::onPreTick(btScalar timeStep) {
+    // Пружина будит тело, поэтому идет до сбора активных тел
+    applyDragSpring();
+    gatherActiveBodies();
+    clampVelocities();
+    updateCcd(timeStep);
+}
+
+void PhysicsWorld::gatherActiveBodies() {
+    BT_PROFILE("gatherActiveBodies");
+    // Спящие тела не двигаются, дальше работаем только с активными. Сам сбор
+    // идет по всем телам: Bullet будит целые острова внутри шага, команды
+    // будят тела напрямую, и отследить это без своего прохода нельзя. Проход
+    // читает только флаг активности, как и проходы самого Bullet по телам.
+    // От числа активных зависит все, что после сбора: скорости и CCD
+    activeBodies.clear();
+    for (btRigidBody* body : dynamicBodies) {
+        if (body->isActive()) {
+            activeBodies.push_back(body);
+        }
+    }
+}
+
+void PhysicsWorld::clampVelocities() {
+    BT_PROFILE("clampVelocities");
+    const size_t count = activeBodies.size();
+    linearBatch.resize(count);
+    angularBatch.resize(count);
+
+    for (size_t i = 0; i < count; ++i) {
+        const btVector3& velocity = activeBodies[i]->getLinearVelocity();
+        const btVector3& angVel = activeBodies[i]->getAngularVelocity();
+        linearBatch.x[i] = velocity.x();
+        linearBatch.y[i] = velocity.y();
+        linearBatch.z[i] = velocity.z();
+        angularBatch.x[i] = angVel.x();
+        angularBatch.y[i] = angVel.y();
+        angularBatch.z[i] = angVel.z();
+    }
+
+    // Остановка при малых скоростях и ограничение максимальных скоростей
+    computeClampScales(linearBatch, STOP_SPEED, MAX_LINEAR_SPEED);
+    computeClampScales(angularBatch, STOP_SPEED, MAX_ANGULAR_SPEED);
+
+    // Записываем обратно только то, что действительно изменилось
+    for (size_t i = 0; i < count; ++i) {
+        btRigidBody* body = activeBodies[i];
+        if (linearBatch.scale[i] != 1.0f) {
+            body->setLinearVelocity(body->getLinearVelocity() * linearBatch.scale[i]);
+        }
+        if (angularBatch.scale[i] != 1.0f) {
+            body->setAngularVelocity(body->getAngularVelocity() * angularBatch.scale[i]);
+        }
+    }
+}
+
+void PhysicsWorld::updateCcd(btScalar timeStep) {
+    BT_PROFILE("updateCcd");
+    const size_t count = activeBodies.size();
+    ccdArmedCount = 0;
+
+    if (!adaptiveCcd) {
+        for (btRigidBody* body : activeBodies) {
+            if (body->getCcdMotionThreshold() != ALWAYS_CCD_THRESHOLD) {
+                body->setCcdMotionThreshold(ALWAYS_CCD_THRESHOLD);
+                body->setCcdSweptSphereRadius(shapeCache.getInnerRadius(body->getCollisionShape()));
             }
-            if (angVel.length() > 15.0f) {
-                angVel = angVel.normalized() * 15.0f;
-                body->setAngularVelocity(angVel);
+        }
+        ccdArmedCount = static_cast<int>(count);
+        return;
+    }
+
+    // Скорости уже ограничены clampVelocities: берем их из пакета с учетом множителя
+    const btScalar timeStepSq = timeStep * timeStep;
+    for (size_t i = 0; i < count; ++i) {
+        btRigidBody* body = activeBodies[i];
+        btScalar scale = linearBatch.scale[i];
+        btScalar displacementSq = (linearBatch.x[i] * linearBatch.x[i]
+            + linearBatch.y[i] * linearBatch.y[i]
+            + linearBatch.z[i] * linearBatch.z[i]) * scale * scale * timeStepSq;
+
+        btScalar innerRadius = shapeCache.getInnerRadius(body->getCollisionShape());
+        btScalar threshold = ccdMotionFraction * innerRadius;
+        if (displacementSq > threshold * threshold) {
+            // Bullet сам сравнит порог со смещением после решателя
+            if (body->getCcdMotionThreshold() != threshold) {
+                body->setCcdMotionThreshold(threshold);
+                body->setCcdSweptSphereRadius(innerRadius);
             }
+            ++ccdArmedCount;
+        } else if (body->getCcdMotionThreshold() != 0) {
+            body->setCcdMotionThreshold(0);
         }
     }
-    dynamicsWorld->stepSimulation(deltaTime, 10);
+}
+
+void PhysicsWorld::setCcdPolicy(bool adaptive, float motionFraction) {
+    adaptiveCcd = adaptive;
+    ccdMotionFraction = motionFraction;
 }
 
 void PhysicsWorld::createBoundaryWalls() {
-    float thickness = 0.2f;
+    const float thickness = BOUNDARY_THICKNESS;
     btVector3 sizes[6] = {
         btVector3(thickness, BOUNDARY_SIZE*2, BOUNDARY_SIZE*2),
         btVector3(thickness, BOUNDARY_SIZE*2, BOUNDARY_SIZE*2),
@@ -116,10 +635,16 @@ void PhysicsWorld::createBoundaryWalls() {
     boundaryBody->setFriction(0.1f);
     boundaryBody->setCollisionFlags(boundaryBody->getCollisionFlags() | btCollisionObject::CF_STATIC_OBJECT);
 
+    // Контакты со стенами - самые частые в сцене, считаем их как с полупространствами
+    if (fastNarrowphaseEnabled) {
+        fastNarrowphase.registerBoundaryAlgorithms(dispatcher, collisionConfiguration, boundaryShape,
+            BOUNDARY_INNER);
+    }
+
     dynamicsWorld->addRigidBody(boundaryBody);
 }
 
-PhysicsObject PhysicsWorld::createPhysicsObject(int type, const btVector3& position) {
+PhysicsObject PhysicsWorld::createPhysicsObject(int type, const btVector3& position, btScalar scale) {
     PhysicsObject obj;
     obj.type = type;
     
@@ -128,29 +653,29 @@ PhysicsObject PhysicsWorld::createPhysicsObject(int type, const btVector3& posit
     
     switch(type) {
         case 0: // Куб
-            obj.shape = new btBoxShape(btVector3(0.5f, 0.5f, 0.5f));
+            obj.shape = shapeCache.acquire(BOX_SHAPE_PROXYTYPE, btVector3(0.5f, 0.5f, 0.5f) * scale);
             obj.color = glm::vec3(0.8f, 0.3f, 0.2f);
             mass = 1.0f;
             break;
         case 1: // Сфера
-            obj.shape = new btSphereShape(0.5f);
+            obj.shape = shapeCache.acquire(SPHERE_SHAPE_PROXYTYPE, btVector3(0.5f, 0, 0) * scale);
             obj.color = glm::vec3(0.2f, 0.8f, 0.3f);
             mass = 0.8f;
             break;
         case 2: // Пирамида
-            obj.shape = new btConeShape(0.4f, 1.0f);
+            obj.shape = shapeCache.acquire(CONE_SHAPE_PROXYTYPE, btVector3(0.4f, 1.0f, 0) * scale);
             obj.color = glm::vec3(0.3f, 0.2f, 0.8f);
             mass = 0.8f;
             break;
     }
 
-    obj.shape->calculateLocalInertia(mass, localInertia);
+    localInertia = shapeCache.getLocalInertia(obj.shape, mass);
 
     btTransform transform;
     transform.setIdentity();
     transform.setOrigin(position);
     
-    obj.motionState = new btDefaultMotionState(transform);
+    obj.motionState = createMotionState(transform);
     btRigidBody::btRigidBodyConstructionInfo rbInfo(mass, obj.motionState, obj.shape, localInertia);
 
     // Настраиваем параметры в зависимости от типа
@@ -161,59 +686,304 @@ PhysicsObject PhysicsWorld::createPhysicsObject(int type, const btVector3& posit
         rbInfo.m_spinningFriction = 0.8f;
     }
     
-    obj.rigidBody = new btRigidBody(rbInfo);
+    obj.rigidBody = createRigidBody(rbInfo);
     obj.rigidBody->setDamping(0.1f, 0.1f);  // Небольшое затухание движения
-    obj.rigidBody->setActivationState(DISABLE_DEACTIVATION);
+    configureSleeping(obj.rigidBody);
+    // CCD включает updateCcd, когда тело становится быстрым для своего размера
+    
+    return obj;
+}
+
+// Форма объекта приложения по типу - ключ общей формы в ShapeCache
+static void appObjectShape(int type, int& proxyType, btVector3& dimensions) {
+    switch(type) {
+        case 1: // сфера
+            proxyType = SPHERE_SHAPE_PROXYTYPE;
+            dimensions = btVector3(0.5f, 0, 0);
+            break;
+        case 2: // цилиндр
+            proxyType = CYLINDER_SHAPE_PROXYTYPE;
+            dimensions = btVector3(0.5f, 0.5f, 0.5f);
+            break;
+        default: // куб
+            proxyType = BOX_SHAPE_PROXYTYPE;
+            dimensions = btVector3(0.5f, 0.5f, 0.5f);
+            break;
+    }
+}
+
+// Фабрика объектов приложения: материалы берутся из настроек интерфейса
+PhysicsObject PhysicsWorld::createPhysicsObject(int type, const btVector3& position, const PhysicsSettings& physicsSettings) {
+    PhysicsObject obj;
+    obj.type = type;
+    
+    // Берем общую форму из кэша в зависимости от типа
+    int proxyType;
+    btVector3 dimensions;
+    appObjectShape(type, proxyType, dimensions);
+    obj.shape = shapeCache.acquire(proxyType, dimensions);
+    switch(type) {
+        case 0: // куб
+            obj.color = physicsSettings.cubeColor;
+            break;
+        case 1: // сфера
+            obj.color = glm::vec3(0.2f, 0.8f, 0.3f);
+            break;
+        case 2: // цилиндр
+            obj.color = glm::vec3(0.3f, 0.2f, 0.8f);
+            break;
+    }
+
+    btScalar mass = 1.0f;
+    btVector3 inertia = shapeCache.getLocalInertia(obj.shape, mass);
+
+    btTransform transform;
+    transform.setIdentity();
+    transform.setOrigin(position);
+    
+    obj.motionState = createMotionState(transform);
+    btRigidBody::btRigidBodyConstructionInfo rbInfo(mass, obj.motionState, obj.shape, inertia);
+    
+    // Настройка физических параметров
+    rbInfo.m_restitution = physicsSettings.restitution;
+    rbInfo.m_friction = physicsSettings.friction;
     
-    // Включаем CCD для быстро движущихся объектов
-    obj.rigidBody->setCcdMotionThreshold(1e-7f);
-    obj.rigidBody->setCcdSweptSphereRadius(0.25f);
+    obj.rigidBody = createRigidBody(rbInfo);
+    obj.rigidBody->setRollingFriction(physicsSettings.rollingFriction);
+    obj.rigidBody->setSpinningFriction(physicsSettings.spinningFriction);
+    obj.rigidBody->setDamping(physicsSettings.damping, physicsSettings.damping);
+    configureSleeping(obj.rigidBody);
     
     return obj;
 }
 
-void PhysicsWorld::applyForceToObject(PhysicsObject& obj, const glm::vec2& windowVelocity, const PhysicsSettings& settings) {
-    if (!obj.rigidBody) return;
+// Детерминированный поток возмущений: у каждого тела свой, зависящий от номера встряски
+static uint32_t jitterSeed(uint32_t bodyIndex, uint32_t shakeIndex) {
+    uint32_t x = bodyIndex * 0x9E3779B9u ^ (shakeIndex + 0x7F4A7C15u) * 0x85EBCA6Bu;
+    x ^= x >> 16;
+    x *= 0x7FEB352Du;
+    x ^= x >> 15;
+    x *= 0x846CA68Bu;
+    x ^= x >> 16;
+    return x;
+}
 
-    // Увеличиваем силу импульса
-    btVector3 centralImpulse(
-        windowVelocity.x * settings.horizontalScale * settings.forceScale * 300.0f, // Увеличили множитель
-        -windowVelocity.y * settings.verticalScale * settings.forceScale * 300.0f,  // с 100 до 300
-        windowVelocity.y * settings.zScale * settings.forceScale * 300.0f
-    );
+static float nextJitter(uint32_t& state) {
+    state = state * 1664525u + 1013904223u;
+    return (static_cast<int>((state >> 8) % 100) - 50) * 0.001f;
+}
+
+SpawnRegion PhysicsWorld::boundaryRegion(btScalar radius) {
+    btScalar extent = BOUNDARY_INNER - radius;
+    return { btVector3(-extent, -extent, -extent), btVector3(extent, extent, extent) };
+}
+
+static int latticeSitesPerAxis(int count) {
+    return std::max(1, static_cast<int>(std::ceil(std::cbrt(static_cast<double>(count)))));
+}
+
+btScalar PhysicsWorld::latticeScale(int count) {
+    btScalar spacing = BOUNDARY_INNER * 2.0f / latticeSitesPerAxis(count);
+    return std::min(btScalar(1.0f), spacing / LATTICE_SPACING);
+}
+
+void PhysicsWorld::spawnLattice(int type, int count, std::vector<PhysicsObject>& objects) {
+    objects.reserve(objects.size() + count);
+
+    const int perAxis = latticeSitesPerAxis(count);
+    const btScalar spacing = BOUNDARY_INNER * 2.0f / perAxis;
+    const btScalar scale = latticeScale(count);
+    for (int i = 0; i < count; ++i) {
+        int x = i % perAxis;
+        int y = (i / perAxis) % perAxis;
+        int z = i / (perAxis * perAxis);
+        btVector3 position(
+            -BOUNDARY_INNER + spacing * (x + 0.5f),
+            -BOUNDARY_INNER + spacing * (y + 0.5f),
+            -BOUNDARY_INNER + spacing * (z + 0.5f)
+        );
+        PhysicsObject obj = createPhysicsObject(type >= 0 ? type : i % 3, position, scale);
+        addObject(obj, objects);
+    }
+}
+
+// Ключ ячейки решетки пакетного размещения
+static int64_t cellKey(int x, int y, int z) {
+    return (static_cast<int64_t>(x) << 42) ^ (static_cast<int64_t>(y) << 21) ^ static_cast<int64_t>(z);
+}
+
+size_t PhysicsWorld::spawnBatch(int type, size_t count, const SpawnRegion& region, const PhysicsSettings& settings,
+    std::vector<PhysicsObject>& objects) {
+    if (count == 0) return 0;
+
+    // Размер ячейки по описанной сфере формы: в любой ориентации тело остается
+    // в своей ячейке. Форму держим до конца пакета, чтобы кэш не удалил ее
+    // между этим запросом и созданием первого тела
+    int proxyType;
+    btVector3 dimensions;
+    appObjectShape(type, proxyType, dimensions);
+    btCollisionShape* shape = shapeCache.acquire(proxyType, dimensions);
+    btVector3 center;
+    btScalar radius;
+    shape->getBoundingSphere(center, radius);
 
-    obj.rigidBody->applyCentralImpulse(centralImpulse);
+    const btScalar gap = 0.05f;
+    const btScalar cell = radius * 2.0f + gap;
+    btScalar jitter = gap * 0.5f;
 
-    btVector3 torque(
-        windowVelocity.y * 0.5f,      // Увеличили вращение
+    // Область ограничивает тела целиком: центры отступают от ее границ на
+    // описанную сферу вместе со случайным сдвигом
+    btVector3 inset(radius + jitter, radius + jitter, radius + jitter);
+    btVector3 extent = (region.max - inset) - (region.min + inset);
+    if (extent.x() < 0 || extent.y() < 0 || extent.z() < 0) {
+        shapeCache.release(shape);
+        return 0;
+    }
+    int cellsX = std::max(1, static_cast<int>(extent.x() / cell) + 1);
+    int cellsY = std::max(1, static_cast<int>(extent.y() / cell) + 1);
+    int cellsZ = std::max(1, static_cast<int>(extent.z() / cell) + 1);
+
+    // Центрируем решетку в области, остаток ширины уходит на случайный сдвиг
+    btVector3 used(cellsX - 1, cellsY - 1, cellsZ - 1);
+    btVector3 origin = region.min + inset + (extent - used * cell) * 0.5f;
+
+    // Пространственная сетка занятых ячеек: помечаем все ячейки, которых
+    // касаются AABB существующих тел
+    std::unordered_set<int64_t> occupied;
+    for (btRigidBody* body : dynamicBodies) {
+        btVector3 aabbMin, aabbMax;
+        body->getAabb(aabbMin, aabbMax);
+        btVector3 low = (aabbMin - origin) / cell + btVector3(0.5f, 0.5f, 0.5f);
+        btVector3 high = (aabbMax - origin) / cell + btVector3(0.5f, 0.5f, 0.5f);
+        int x0 = std::max(0, static_cast<int>(std::floor(low.x())));
+        int y0 = std::max(0, static_cast<int>(std::floor(low.y())));
+        int z0 = std::max(0, static_cast<int>(std::floor(low.z())));
+        int x1 = std::min(cellsX - 1, static_cast<int>(std::floor(high.x())));
+        int y1 = std::min(cellsY - 1, static_cast<int>(std::floor(high.y())));
+        int z1 = std::min(cellsZ - 1, static_cast<int>(std::floor(high.z())));
+        for (int y = y0; y <= y1; ++y)
+            for (int z = z0; z <= z1; ++z)
+                for (int x = x0; x <= x1; ++x)
+                    occupied.insert(cellKey(x, y, z));
+    }
+
+    // Заполняем снизу вверх, чтобы пакет сразу лежал кучей, а не падал с высоты
+    std::vector<btVector3> positions;
+    positions.reserve(count);
+    for (int y = 0; y < cellsY && positions.size() < count; ++y) {
+        for (int z = 0; z < cellsZ && positions.size() < count; ++z) {
+            for (int x = 0; x < cellsX && positions.size() < count; ++x) {
+                if (occupied.count(cellKey(x, y, z))) continue;
+                positions.push_back(origin + btVector3(x, y, z) * cell);
+            }
+        }
+    }
+
+    // Детерминированный сдвиг и поворот каждого тела, чтобы решетка не стояла столбами
+    uint32_t state = jitterSeed(static_cast<uint32_t>(dynamicBodies.size()), static_cast<uint32_t>(count));
+    objects.reserve(objects.size() + positions.size());
+    dynamicBodies.reserve(dynamicBodies.size() + positions.size());
+    bodyPool.reserve(bodyPool.size() + positions.size());
+    motionStatePool.reserve(motionStatePool.size() + positions.size());
+
+    // nextJitter дает значения в [-0.05, 0.05), приводим их к нужным диапазонам
+    const btScalar jitterRange = 0.05f;
+    for (const btVector3& cellCenter : positions) {
+        btVector3 offset(nextJitter(state), nextJitter(state), nextJitter(state));
+        btVector3 position = cellCenter + offset * (jitter / jitterRange);
+
+        // Ось со смещенной y-компонентой никогда не бывает нулевой
+        btVector3 axis(nextJitter(state), nextJitter(state) + 2.0f * jitterRange, nextJitter(state));
+        btScalar angle = nextJitter(state) * SIMD_PI / jitterRange;
+        btTransform transform(btQuaternion(axis.normalized(), angle), position);
+
+        PhysicsObject obj = createPhysicsObject(type, position, settings);
+        obj.rigidBody->setCenterOfMassTransform(transform);
+        static_cast<InterpolatedMotionState*>(obj.motionState)->reset(transform);
+
+        addObject(obj, objects);
+    }
+
+    // Новые прокси попадают в динамическое дерево по одному; перестраиваем
+    // деревья один раз на весь пакет, чтобы первый шаг не искал пары в перекошенном дереве
+    if (btDbvtBroadphase* dbvt = dynamic_cast<btDbvtBroadphase*>(overlappingPairCache)) {
+        dbvt->optimize();
+    }
+    shapeCache.release(shape);
+    return positions.size();
+}
+
+void PhysicsWorld::applyForceToAll(PhysicsObject* objects, size_t count, const glm::vec2& windowVelocity, const PhysicsSettings& settings) {
+    // Встряска идет командой до шага, а Bullet сбрасывает свое дерево в начале
+    // шага - поэтому зона своя, а не BT_PROFILE
+    ProfileScope scope(profile, "applyForceToAll");
+    // Импульс и базовый момент одинаковы для всех тел - считаем их один раз
+    const float impulse[3] = {
+        windowVelocity.x * settings.horizontalScale * settings.forceScale * 300.0f,
+        -windowVelocity.y * settings.verticalScale * settings.forceScale * 300.0f,
+        windowVelocity.y * settings.zScale * settings.forceScale * 300.0f
+    };
+    const float torque[3] = {
+        windowVelocity.y * 0.5f,
         windowVelocity.x * 0.5f,
         (windowVelocity.x + windowVelocity.y) * 0.25f
-    );
+    };
+    const float torqueLength = std::sqrt(torque[0] * torque[0] + torque[1] * torque[1] + torque[2] * torque[2]);
+    const float maxTorque = 8.0f;
+    ++shakeCount;
+
+    // Собираем тела в плотный пакет
+    shakeBodies.clear();
+    impulseBatch.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        btRigidBody* body = objects[i].rigidBody;
+        if (!body) continue;
 
-    float mass = obj.rigidBody->getMass();
-    torque *= mass * 0.8f;  // Увеличили влияние массы
+        size_t k = shakeBodies.size();
+        shakeBodies.push_back(body);
 
-    float maxTorque = 8.0f;  // Увеличили максимальный момент
-    if (torque.length() > maxTorque) {
-        torque = torque.normalized() * maxTorque;
+        float mass = body->getMass();
+        float torqueScale = mass * 0.8f;
+        if (torqueLength * torqueScale > maxTorque) {
+            torqueScale = maxTorque / torqueLength;
+        }
+        impulseBatch.inverseMass[k] = body->getInvMass();
+        impulseBatch.torqueScale[k] = torqueScale;
+
+        const btMatrix3x3& invInertia = body->getInvInertiaTensorWorld();
+        for (int row = 0; row < 3; ++row) {
+            for (int col = 0; col < 3; ++col) {
+                impulseBatch.invInertia[row * 3 + col][k] = invInertia[row][col];
+            }
+        }
+
+        uint32_t state = jitterSeed(static_cast<uint32_t>(i), shakeCount);
+        impulseBatch.jitter.x[k] = nextJitter(state);
+        impulseBatch.jitter.y[k] = nextJitter(state);
+        impulseBatch.jitter.z[k] = nextJitter(state);
     }
+    impulseBatch.resize(shakeBodies.size());
 
-    // Добавляем случайное возмущение для предотвращения стояния на грани
-    btVector3 randomTorque(
-        (rand() % 100 - 50) * 0.001f,
-        (rand() % 100 - 50) * 0.001f,
-        (rand() % 100 - 50) * 0.001f
-    );
-    
-    obj.rigidBody->applyTorqueImpulse(torque + randomTorque);
+    computeShakeImpulses(impulseBatch, impulse, torque);
+
+    for (size_t k = 0; k < shakeBodies.size(); ++k) {
+        btRigidBody* body = shakeBodies[k];
+        body->activate(true);
+        btVector3 deltaLinear(impulseBatch.linear.x[k], impulseBatch.linear.y[k], impulseBatch.linear.z[k]);
+        btVector3 deltaAngular(impulseBatch.angular.x[k], impulseBatch.angular.y[k], impulseBatch.angular.z[k]);
+        body->setLinearVelocity(body->getLinearVelocity() + deltaLinear * body->getLinearFactor());
+        body->setAngularVelocity(body->getAngularVelocity() + deltaAngular * body->getAngularFactor());
+    }
 }
 
 void PhysicsWorld::removeObject(PhysicsObject& obj) {
     if (obj.rigidBody) {
         dynamicsWorld->removeRigidBody(obj.rigidBody);
-        delete obj.rigidBody;
-        delete obj.motionState;
-        delete obj.shape;
+        removeDynamicBody(obj.rigidBody);
+        contactTracker.forgetBody(obj.rigidBody, obj.handle);
+        bodyPool.destroy(obj.rigidBody);
+        motionStatePool.destroy(static_cast<InterpolatedMotionState*>(obj.motionState));
+        shapeCache.release(obj.shape);
         
         obj.rigidBody = nullptr;
         obj.motionState = nullptr;
@@ -221,19 +991,174 @@ void PhysicsWorld::removeObject(PhysicsObject& obj) {
     }
 }
 
+void PhysicsWorld::removeObjects(std::vector<PhysicsObject>& objects, bool releaseMemory) {
+    size_t liveBodies = 0;
+    for (const auto& obj : objects) {
+        if (obj.rigidBody) ++liveBodies;
+    }
+
+    // Если удаляются все тела пулов, блоки не возвращаются по одному,
+    // а пулы сбрасываются целиком после вызова деструкторов
+    bool bulk = liveBodies == bodyPool.size() && liveBodies == motionStatePool.size();
+    if (bulk) {
+        // Касаний между оставшимися телами нет: все пары заканчиваются сейчас,
+        // пока тела еще живы и их ручки можно прочитать
+        contactTracker.endAll(dynamicBodies, contactEvents);
+    }
+
+    for (auto& obj : objects) {
+        if (!obj.rigidBody) continue;
+
+        dynamicsWorld->removeRigidBody(obj.rigidBody);
+        removeDynamicBody(obj.rigidBody);
+        if (bulk) {
+            obj.rigidBody->~btRigidBody();
+            obj.motionState->~btMotionState();
+        } else {
+            contactTracker.forgetBody(obj.rigidBody, obj.handle);
+            bodyPool.destroy(obj.rigidBody);
+            motionStatePool.destroy(static_cast<InterpolatedMotionState*>(obj.motionState));
+        }
+        shapeCache.release(obj.shape);
+
+        obj.rigidBody = nullptr;
+        obj.motionState = nullptr;
+        obj.shape = nullptr;
+    }
+
+    if (bulk) {
+        if (releaseMemory) {
+            bodyPool.release();
+            motionStatePool.release();
+        } else {
+            bodyPool.reset();
+            motionStatePool.reset();
+        }
+    }
+}
+
 void PhysicsWorld::removeAllObjects() {
-    // Удаляем все объекты из мира
+    contactTracker.endAll(dynamicBodies, contactEvents);
+    // Удаляем все объекты из мира; динамические тела живут в пулах
     for (int i = dynamicsWorld->getNumCollisionObjects() - 1; i >= 0; i--) {
         btCollisionObject* obj = dynamicsWorld->getCollisionObjectArray()[i];
         btRigidBody* body = btRigidBody::upcast(obj);
+        dynamicsWorld->removeCollisionObject(obj);
+
+        if (body && !body->isStaticObject()) {
+            btCollisionShape* shape = body->getCollisionShape();
+            body->getMotionState()->~btMotionState();
+            body->~btRigidBody();
+            shapeCache.release(shape);
+            continue;
+        }
         if (body && body->getMotionState()) {
             delete body->getMotionState();
         }
-        dynamicsWorld->removeCollisionObject(obj);
         delete obj;
     }
+    dynamicBodies.clear();
+    querySnapshotValid = false;
+    activeBodies.clear();
+    bodyPool.reset();
+    motionStatePool.reset();
 }
 
 void PhysicsWorld::addObject(PhysicsObject& obj) {
     dynamicsWorld->addRigidBody(obj.rigidBody);
+    if (!obj.rigidBody->isStaticObject()) {
+        obj.rigidBody->setUserIndex2(static_cast<int>(dynamicBodies.size()));
+        obj.handle = dynamicBodies.insert(obj.rigidBody);
+        querySnapshotValid = false;
+    }
+}
+
+void PhysicsWorld::addObject(PhysicsObject& obj, std::vector<PhysicsObject>& objects) {
+    addObject(obj);
+    obj.rigidBody->setUserIndex(static_cast<int>(objects.size()));
+    objects.push_back(obj);
+}
+
+bool PhysicsWorld::removeBody(BodyHandle handle, std::vector<PhysicsObject>& objects) {
+    btRigidBody* body = getBody(handle);
+    if (!body) return false;
+    size_t index = static_cast<size_t>(body->getUserIndex());
+    if (index >= objects.size() || objects[index].rigidBody != body) return false;
+
+    removeObject(objects[index]);
+    objects[index] = objects.back();
+    objects.pop_back();
+    if (index < objects.size()) {
+        objects[index].rigidBody->setUserIndex(static_cast<int>(index));
+    }
+    return true;
+}
+
+btRigidBody* PhysicsWorld::getBody(BodyHandle handle) const {
+    btRigidBody* const* body = dynamicBodies.find(handle);
+    return body ? *body : nullptr;
+}
+
+BodyHandle PhysicsWorld::getBodyHandle(const btCollisionObject* body) const {
+    int index = body->getUserIndex2();
+    if (index < 0 || index >= static_cast<int>(dynamicBodies.size()) || dynamicBodies[index] != body) {
+        return BodyHandle();
+    }
+    return dynamicBodies.handleAt(static_cast<size_t>(index));
+}
+
+void PhysicsWorld::removeDynamicBody(btRigidBody* body) {
+    // Удаление перестановкой с последним: индекс в плотном списке хранится в userIndex2
+    int index = body->getUserIndex2();
+    if (index < 0 || index >= static_cast<int>(dynamicBodies.size()) || dynamicBodies[index] != body) {
+        return;
+    }
+    dynamicBodies.removeAt(static_cast<size_t>(index));
+    querySnapshotValid = false;
+    if (index < static_cast<int>(dynamicBodies.size())) {
+        dynamicBodies[index]->setUserIndex2(index);
+    }
+    body->setUserIndex2(-1);
+}
+
+btMotionState* PhysicsWorld::createMotionState(const btTransform& startTrans) {
+    return motionStatePool.create(startTrans, &tickCount);
+}
+
+btRigidBody* PhysicsWorld::createRigidBody(const btRigidBody::btRigidBodyConstructionInfo& info) {
+    return bodyPool.create(info);
+}
+
+void PhysicsWorld::configureSleeping(btRigidBody* body) {
+    if (sleepingEnabled) {
+        body->setSleepingThresholds(sleepLinearThreshold, sleepAngularThreshold);
+        body->forceActivationState(ACTIVE_TAG);
+        body->setDeactivationTime(0.0f);
+    } else {
+        body->forceActivationState(DISABLE_DEACTIVATION);
+    }
+}
+
+void PhysicsWorld::setSleeping(bool enabled, float linearThreshold, float angularThreshold) {
+    if (enabled == sleepingEnabled
+        && linearThreshold == sleepLinearThreshold
+        && angularThreshold == sleepAngularThreshold) {
+        return;
+    }
+
+    sleepingEnabled = enabled;
+    sleepLinearThreshold = linearThreshold;
+    sleepAngularThreshold = angularThreshold;
+
+    for (btRigidBody* body : dynamicBodies) {
+        configureSleeping(body);
+    }
+}
+
+void PhysicsWorld::wakeAll() {
+    for (btRigidBody* body : dynamicBodies) {
+        if (!body->isActive()) {
+            body->activate(true);
+        }
+    }
 }
\ No newline at end of file
@@ -1,28 +1,283 @@
 #pragma once
 
-#include "types.h"
+#include "physics_types.h"
+#include "shape_cache.h"
+#include "object_pool.h"
+#include "kernels.h"
+#include "scene_map.h"
+#include "instrumented_world.h"
+#include "fast_narrowphase.h"
+#include "solver_controller.h"
+#include "contact_events.h"
+#include "profiler.h"
+#include "physics_query.h"
 #include <bullet/btBulletDynamicsCommon.h>
+#include <cstdint>
+#include <string>
 #include <vector>
 
+#ifdef WCP_BULLET_MT
+#include <bullet/BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h>
+#include <bullet/BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h>
+#include <bullet/BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h>
+#include <bullet/LinearMath/btThreads.h>
+#endif
+
+// Реализации broadphase. Мир - ограниченная коробка, поэтому кроме Dbvt
+// подходят sweep-and-prune с границами по стенам и равномерная сетка
+enum class BroadphaseType {
+    Dbvt,
+    AxisSweep3,   // 16-битный SAP, не больше AXIS_SWEEP_MAX_HANDLES прокси
+    AxisSweep3_32,
+    UniformGrid
+};
+
+const int AXIS_SWEEP_MAX_HANDLES = 32766;
+
+const char* broadphaseName(BroadphaseType type);
+bool parseBroadphaseType(const char* name, BroadphaseType& type);
+
+// Решатели контактов, между которыми можно переключаться на ходу
+enum class SolverType {
+    SequentialImpulse,
+    NNCG // нелинейный сопряженный градиент, сходится быстрее на стопках
+};
+
+const char* solverName(SolverType type);
+bool parseSolverType(const char* name, SolverType& type);
+
+// Параметры создания мира, которые нельзя поменять без пересоздания
+struct PhysicsWorldConfig {
+    int numThreads = 1; // 1 - однопоточный мир, 0 - по числу ядер машины
+    BroadphaseType broadphase = BroadphaseType::Dbvt;
+    float gridCellSize = 1.2f; // ячейка UniformGrid, чуть больше самого крупного тела
+    bool fastNarrowphase = true; // аналитические контакты со стенами и сфер с коробками и цилиндрами
+    size_t contactEventCapacity = 16384; // емкость кольца событий контактов
+};
+
+// Счетчики broadphase за последний шаг
+struct BroadphaseStats {
+    double pairMs = 0.0;
+    int overlappingPairs = 0;
+};
+
+// Состояние решателя на последнем шаге
+struct SolverStats {
+    SolverType type = SolverType::SequentialImpulse;
+    int iterations = 0;
+    double solveMs = 0.0;
+};
+
+// Область размещения пакета тел: границы центров тел
+struct SpawnRegion {
+    btVector3 min;
+    btVector3 max;
+};
+
+// Состояние движения, хранящее трансформы двух последних шагов физики,
+// чтобы рендер мог интерполировать между ними при любой частоте кадров
+class InterpolatedMotionState : public btMotionState {
+public:
+    BT_DECLARE_ALIGNED_ALLOCATOR();
+
+    InterpolatedMotionState(const btTransform& startTrans, const unsigned int* tickCounter);
+
+    void getWorldTransform(btTransform& worldTrans) const override;
+    void setWorldTransform(const btTransform& worldTrans) override;
+
+    // Перенос тела без интерполяции: оба шага указывают на новую трансформу
+    void reset(const btTransform& trans);
+
+    // Трансформы предыдущего и текущего шага физики
+    void getStepTransforms(btTransform& previousTrans, btTransform& currentTrans) const;
+
+private:
+    btTransform previous;
+    btTransform current;
+    const unsigned int* tickCounter;
+    unsigned int updatedTick;
+};
+
 class PhysicsWorld {
 public:
     PhysicsWorld();
     ~PhysicsWorld();
 
-    void init();
+    void init(const PhysicsWorldConfig& config = PhysicsWorldConfig());
     void cleanup();
-    void stepSimulation(float deltaTime);
+    void stepSimulation(float stepTime);
     void createBoundaryWalls();
-    PhysicsObject createPhysicsObject(int type, const btVector3& position);
-    void applyForceToObject(PhysicsObject& obj, const glm::vec2& windowVelocity, const PhysicsSettings& settings);
+    // Тело для консольных прогонов; scale уменьшает форму, масса остается прежней
+    PhysicsObject createPhysicsObject(int type, const btVector3& position, btScalar scale = 1.0f);
+    PhysicsObject createPhysicsObject(int type, const btVector3& position, const PhysicsSettings& settings);
+    // Пакетное создание: тела раскладываются по решетке со случайным сдвигом
+    // внутри свободных ячеек, не пересекаясь ни друг с другом, ни с уже
+    // существующими телами, и вставляются в broadphase одним проходом.
+    // Тела целиком лежат внутри области, boundaryRegion(0) - вся коробка.
+    // Возвращает число созданных тел - в область может поместиться меньше.
+    size_t spawnBatch(int type, size_t count, const SpawnRegion& region, const PhysicsSettings& settings,
+        std::vector<PhysicsObject>& objects);
+    // Вся внутренность коробки с отступом от стен на радиус тела
+    static SpawnRegion boundaryRegion(btScalar radius);
+    // Решетка count тел на всю коробку для консольных прогонов, type < 0 -
+    // типы по кругу. В коробку помещается около сотни тел единичного размера,
+    // поэтому на больших числах тела уменьшаются до шага решетки (latticeScale)
+    // и не пересекаются ни с соседями, ни со стенами ни в какой ориентации
+    void spawnLattice(int type, int count, std::vector<PhysicsObject>& objects);
+    static btScalar latticeScale(int count);
+    // Встряска всех тел за один проход: общий импульс считается один раз,
+    // возмущение момента детерминировано для каждого тела
+    void applyForceToAll(PhysicsObject* objects, size_t count, const glm::vec2& windowVelocity, const PhysicsSettings& settings);
     void removeObject(PhysicsObject& obj);
+    // Удаляет все переданные объекты; releaseMemory возвращает память пулов системе
+    void removeObjects(std::vector<PhysicsObject>& objects, bool releaseMemory);
     void removeAllObjects();
     void addObject(PhysicsObject& obj);
+    // Добавляет тело в мир и в конец списка владельца. userIndex тела - индекс
+    // записи в objects, по нему removeBody находит ее без поиска
+    void addObject(PhysicsObject& obj, std::vector<PhysicsObject>& objects);
+    // Удаление одного тела по ручке за O(1): из массивов Bullet, из плотного
+    // списка мира и перестановкой с последним из objects. false для устаревшей ручки
+    bool removeBody(BodyHandle handle, std::vector<PhysicsObject>& objects);
+    // Живое тело по ручке или nullptr
+    btRigidBody* getBody(BodyHandle handle) const;
+    // Ручка динамического тела; у стен и удаленных тел - недействительная
+    BodyHandle getBodyHandle(const btCollisionObject* body) const;
+    size_t getBodyCount() const { return dynamicBodies.size(); }
+    // Тела и состояния движения создаются в пулах мира, а не в общей куче
+    btMotionState* createMotionState(const btTransform& startTrans);
+    btRigidBody* createRigidBody(const btRigidBody::btRigidBodyConstructionInfo& info);
+
+    // Засыпание островов Bullet: покоящиеся тела не интегрируются и не решаются
+    void setSleeping(bool enabled, float linearThreshold, float angularThreshold);
+    void configureSleeping(btRigidBody* body);
+    void wakeAll();
+
+    // CCD по смещению за шаг: свип включается только телам, которые за шаг
+    // проходят больше motionFraction своего внутреннего радиуса. Без adaptive
+    // CCD включен у всех тел с почти нулевым порогом.
+    void setCcdPolicy(bool adaptive, float motionFraction);
+    // Сколько тел получили порог CCD на последнем шаге. Свип Bullet делает
+    // только тем из них, кто после решателя сместился дальше порога
+    int getCcdArmedCount() const { return ccdArmedCount; }
+
+    // Тип решателя, границы итераций, бюджет и порог невязки. Смена типа
+    // пересоздает решатель, число итераций подбирает SolverController
+    void setSolverSettings(const PhysicsSettings& settings);
+    SolverStats getSolverStats() const;
+
+    // События контактов пишутся в кольцо после каждого шага: начало касания
+    // пары, продолжение и конец. Пары с импульсом меньше порога событий не дают.
+    void setContactEvents(bool enabled, float impulseThreshold);
+    // Все события с прошлого чтения одним пакетом. Тела в событиях - ручки,
+    // у удаленного тела ручка уже устаревшая
+    size_t readContactEvents(std::vector<ContactEvent>& events) { return contactEvents.read(events); }
+    ContactEventStats getContactEventStats() const { return contactTracker.getStats(); }
+    uint64_t getDroppedContactEvents() const { return contactEvents.getDropped(); }
+
+    // Двоичный снимок сцены: архетипы форм, трансформы, скорости, состояния сна
+    // и настройки. Загрузка удаляет переданные объекты и добавляет тела из файла.
+    bool saveSnapshot(const std::string& path, const std::vector<PhysicsObject>& objects, const PhysicsSettings& settings) const;
+    bool loadSnapshot(const std::string& path, std::vector<PhysicsObject>& objects, PhysicsSettings& settings);
+    // Плоская сцена для отображения в память: тела создаются пакетно по архетипам
+    // прямо из отображенных массивов, без разбора и промежуточных копий
+    bool saveSceneMap(const std::string& path, const std::vector<PhysicsObject>& objects) const;
+    bool loadSceneMap(const MappedScene& scene, std::vector<PhysicsObject>& objects);
+
+    // Луч по всем телам мира, включая стены; фильтр задает callback
+    void rayTest(const btVector3& from, const btVector3& to, btCollisionWorld::RayResultCallback& callback) const;
+    // Снимок динамических тел для запросов. Строится при первом запросе после
+    // шага или изменения состава тел; его можно отдать другим потокам до
+    // следующего изменения мира
+    const QuerySnapshot& getQuerySnapshot();
+    // Пакетные запросы по снимку. С WCP_BULLET_MT большой пакет делится
+    // между потоками планировщика Bullet
+    void raycast(const RayQuery* queries, size_t count, RayQueryHit* hits);
+    void overlap(const SphereQuery* queries, size_t count, QueryResults& results);
+    void overlap(const AabbQuery* queries, size_t count, QueryResults& results);
+
+    // Перетаскивание мышью: ближайшее тело на луче захватывается в точке
+    // попадания, и эта точка тянется пружиной к точке луча на той же дистанции
+    bool beginDrag(const btVector3& from, const btVector3& to);
+    void updateDrag(const btVector3& from, const btVector3& to);
+    void endDrag();
+    // Перетаскиваемое тело; недействительная ручка, если тела нет
+    BodyHandle getDragBody() const { return dragBody; }
+    // Оценка памяти под тела: пулы тел и состояний движения, плотные списки,
+    // прокси broadphase, пары и манифолды контактов
+    size_t getMemoryUsage() const;
+
+    ShapeCache& getShapeCache() { return shapeCache; }
+    unsigned int getTickCount() const { return tickCount; }
+
+    // Число потоков, с которым реально работает мир (1 без WCP_BULLET_MT)
+    int getNumThreads() const { return numThreads; }
+    BroadphaseType getBroadphaseType() const { return broadphaseType; }
+    bool isFastNarrowphaseEnabled() const { return fastNarrowphaseEnabled; }
+    BroadphaseStats getBroadphaseStats() const;
+    // Время фаз последнего шага: broadphase, узкая фаза, решатель, интегрирование
+    const WorldTimings& getTimings() const { return timings; }
+    // Дерево зон потока физики с прошлого чтения: шаги с фазами Bullet,
+    // ограничение скоростей, встряска, события контактов
+    FrameProfile& getProfile() { return profile; }
+    static bool isMultithreadingAvailable();
 
 private:
+    static void preTickCallback(btDynamicsWorld* world, btScalar timeStep);
+    void onPreTick(btScalar timeStep);
+    void gatherActiveBodies();
+    void clampVelocities();
+    void updateCcd(btScalar timeStep);
+    void setSolverType(SolverType type);
+    void removeDynamicBody(btRigidBody* body);
+    void applyDragSpring();
+    template <typename Query>
+    void overlapBatch(const Query* queries, size_t count, QueryResults& results);
+
     btDefaultCollisionConfiguration* collisionConfiguration;
     btCollisionDispatcher* dispatcher;
     btBroadphaseInterface* overlappingPairCache;
-    btSequentialImpulseConstraintSolver* solver;
+    btConstraintSolver* solver;
     btDiscreteDynamicsWorld* dynamicsWorld;
+    int numThreads;
+    BroadphaseType broadphaseType;
+    bool fastNarrowphaseEnabled;
+    FastNarrowphase fastNarrowphase;
+    WorldTimings timings;
+    uint32_t shakeCount;
+    bool sleepingEnabled;
+    float sleepLinearThreshold;
+    float sleepAngularThreshold;
+    bool adaptiveCcd;
+    float ccdMotionFraction;
+    int ccdArmedCount;
+    SolverType solverType;
+    SolverController solverController;
+    PhysicsSettings solverSettings; // настройки решателя из последнего setSolverSettings
+    bool contactEventsEnabled;
+    float contactImpulseThreshold;
+    ContactTracker contactTracker;
+    ContactEventRing contactEvents;
+    FrameProfile profile;
+    QuerySnapshot querySnapshot;
+    bool querySnapshotValid;
+    std::vector<QueryResults> queryChunks; // ответы кусков пакета при параллельном запросе
+    BodyHandle dragBody;
+    btVector3 dragPivot;  // точка захвата в координатах тела
+    btVector3 dragTarget;
+    btScalar dragDistance; // расстояние от начала луча до точки захвата
+    ShapeCache shapeCache;
+    ObjectPool<btRigidBody> bodyPool;
+    ObjectPool<InterpolatedMotionState> motionStatePool;
+
+    // Плотный список динамических тел за ручками и активных тел текущего шага.
+    // Индекс тела в списке хранится в userIndex2 и совпадает с индексом в
+    // m_nonStaticRigidBodies мира Bullet
+    SlotMap<btRigidBody*> dynamicBodies;
+    std::vector<btRigidBody*> activeBodies;
+    VectorBatch linearBatch;
+    VectorBatch angularBatch;
+    std::vector<btRigidBody*> shakeBodies;
+    ImpulseBatch impulseBatch;
+    unsigned int tickCount;
 };
\ No newline at end of file
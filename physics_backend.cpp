@@ -0,0 +1,45 @@
+#include "physics_backend.h"
+#include "bullet_backend.h"
+#include "particle_backend.h"
+#include "reference_backend.h"
+#include <cstring>
+
+const char* backendName(BackendType type) {
+    switch (type) {
+        case BackendType::Bullet: return "bullet";
+        case BackendType::Particles: return "particles";
+        case BackendType::Reference: return "reference";
+    }
+    return "unknown";
+}
+
+bool parseBackendType(const char* name, BackendType& type) {
+    const BackendType types[] = { BackendType::Bullet, BackendType::Particles, BackendType::Reference };
+    for (BackendType candidate : types) {
+        if (strcmp(name, backendName(candidate)) == 0) {
+            type = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::unique_ptr<PhysicsBackend> createPhysicsBackend(BackendType type) {
+    return createPhysicsBackend(type, PhysicsWorldConfig());
+}
+
+std::unique_ptr<PhysicsBackend> createPhysicsBackend(BackendType type, const PhysicsWorldConfig& worldConfig) {
+    switch (type) {
+        case BackendType::Bullet:
+            return std::unique_ptr<PhysicsBackend>(new BulletBackend(worldConfig));
+        case BackendType::Particles: {
+            // Радиус сферы Bullet: одна и та же сцена сравнима между движками
+            ParticleConfig config;
+            config.radius = 0.5f;
+            return std::unique_ptr<PhysicsBackend>(new ParticleBackend(config));
+        }
+        case BackendType::Reference:
+            return std::unique_ptr<PhysicsBackend>(new ReferenceBackend());
+    }
+    return nullptr;
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <memory>
+
+// Типы мира Bullet нужны только фабрике и реализациям движков
+struct PhysicsSettings;
+struct PhysicsWorldConfig;
+
+// Попадание луча: индекс тела, доля пути от начала луча, точка и нормаль
+struct RayHit {
+    size_t body = 0;
+    float fraction = 1.0f;
+    glm::vec3 point;
+    glm::vec3 normal;
+};
+
+// Общий интерфейс движков физики без типов Bullet в сигнатурах: сцену из
+// одной записи можно прогнать на любом из них и сравнить время шага и память.
+// Индексы тел действительны до следующего шага, создания или очистки -
+// движок может переупорядочивать тела.
+class PhysicsBackend {
+public:
+    virtual ~PhysicsBackend() {}
+
+    virtual const char* getName() const = 0;
+
+    // Одно тело в заданной точке; движок без форм создает вместо него сферу
+    virtual void spawnBody(int type, const glm::vec3& position, const PhysicsSettings& settings) = 0;
+    // Пакет тел без пересечений по всей коробке. Возвращает число созданных тел
+    virtual size_t spawnBatch(int type, size_t count, const PhysicsSettings& settings) = 0;
+    virtual void clear(bool releaseMemory) = 0;
+    virtual void step(float stepTime, const PhysicsSettings& settings) = 0;
+
+    virtual size_t getBodyCount() const = 0;
+    // Трансформы всех тел одним проходом: positions - float[3 * N],
+    // rotations - кватернионы float[4 * N] в порядке x, y, z, w, types - int[N].
+    // Любой из указателей может быть nullptr
+    virtual void readTransforms(float* positions, float* rotations, int* types) const = 0;
+
+    virtual void applyImpulse(size_t body, const glm::vec3& impulse) = 0;
+    // Встряска окна, как в PhysicsWorld::applyForceToAll
+    virtual void applyShake(const glm::vec2& windowVelocity, const PhysicsSettings& settings) = 0;
+    // Пробуждение уснувших тел, если движок их усыпляет
+    virtual void wakeAll() {}
+
+    // Ближайшее динамическое тело на отрезке from-to, стены не учитываются
+    virtual bool raycast(const glm::vec3& from, const glm::vec3& to, RayHit& hit) const = 0;
+
+    // Оценка памяти под тела в байтах
+    virtual size_t getMemoryUsage() const = 0;
+};
+
+enum class BackendType {
+    Bullet,
+    Particles, // ParticleWorld: только сферы одного радиуса
+    Reference  // эталонный интегратор без контактов между телами
+};
+
+const char* backendName(BackendType type);
+bool parseBackendType(const char* name, BackendType& type);
+
+std::unique_ptr<PhysicsBackend> createPhysicsBackend(BackendType type);
+// worldConfig нужен только Bullet
+std::unique_ptr<PhysicsBackend> createPhysicsBackend(BackendType type, const PhysicsWorldConfig& worldConfig);
\ No newline at end of file
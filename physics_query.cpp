@@ -0,0 +1,291 @@
+#include "physics_query.h"
+#include "physics_types.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Сетка не мельче 64 ячеек на ось: больше ячеек - дороже ее очистка при построении
+static const int MAX_CELLS_PER_AXIS = 64;
+
+void QueryResults::clear() {
+    offsets.assign(1, 0);
+    hits.clear();
+}
+
+void QueryResults::append(const QueryResults& chunk) {
+    if (offsets.empty()) {
+        offsets.push_back(0);
+    }
+    uint32_t base = static_cast<uint32_t>(hits.size());
+    for (size_t i = 1; i < chunk.offsets.size(); ++i) {
+        offsets.push_back(chunk.offsets[i] + base);
+    }
+    hits.insert(hits.end(), chunk.hits.begin(), chunk.hits.end());
+}
+
+QuerySnapshot::QuerySnapshot()
+    : gridMin(0, 0, 0)
+    , cellSize(1.0f)
+    , cellsPerAxis(1) {
+}
+
+void QuerySnapshot::build(const SlotMap<btRigidBody*>& source) {
+    const int count = static_cast<int>(source.size());
+    bodies.resize(count);
+
+    // AABB считается по форме и трансформе снимка: у спящих тел прокси
+    // broadphase не обновляется, а у быстрых Bullet растягивает его на
+    // перемещение за шаг, и такой AABB разошелся бы с трансформой
+    btScalar extentSum = 0.0f;
+    for (int i = 0; i < count; ++i) {
+        btRigidBody* rigidBody = source[i];
+        Body& body = bodies[i];
+        body.transform = rigidBody->getWorldTransform();
+        rigidBody->getCollisionShape()->getAabb(body.transform, body.aabbMin, body.aabbMax);
+        btVector3 localCenter;
+        rigidBody->getCollisionShape()->getBoundingSphere(localCenter, body.radius);
+        body.center = body.transform * localCenter;
+        body.object = rigidBody;
+        body.shape = rigidBody->getCollisionShape();
+        body.handle = source.handleAt(static_cast<size_t>(i));
+
+        btVector3 extent = body.aabbMax - body.aabbMin;
+        extentSum += extent[extent.maxAxis()];
+    }
+
+    // Ячейка - средний размер тела: обычное тело лежит в 1-8 ячейках.
+    // Границы те же, что у broadphase мира
+    const btScalar span = (BOUNDARY_SIZE + 1.0f) * 2.0f;
+    gridMin.setValue(-BOUNDARY_SIZE - 1.0f, -BOUNDARY_SIZE - 1.0f, -BOUNDARY_SIZE - 1.0f);
+    btScalar averageExtent = count > 0 ? extentSum / count : span;
+    cellsPerAxis = static_cast<int>(std::ceil(span / std::max(averageExtent, span / MAX_CELLS_PER_AXIS)));
+    cellsPerAxis = std::clamp(cellsPerAxis, 1, MAX_CELLS_PER_AXIS);
+    cellSize = span / cellsPerAxis;
+
+    // Сортировка подсчетом: число записей в каждой ячейке, префиксные суммы,
+    // затем раскладка с конца, как в ParticleWorld
+    cellStart.assign(static_cast<size_t>(cellsPerAxis) * cellsPerAxis * cellsPerAxis + 1, 0);
+    for (int i = 0; i < count; ++i) {
+        Body& body = bodies[i];
+        cellRange(body.aabbMin, body.aabbMax, body.cellMin, body.cellMax);
+        for (int z = body.cellMin[2]; z <= body.cellMax[2]; ++z) {
+            for (int y = body.cellMin[1]; y <= body.cellMax[1]; ++y) {
+                for (int x = body.cellMin[0]; x <= body.cellMax[0]; ++x) {
+                    ++cellStart[cellIndex(x, y, z)];
+                }
+            }
+        }
+    }
+    for (size_t c = 1; c < cellStart.size(); ++c) {
+        cellStart[c] += cellStart[c - 1];
+    }
+    cellBodies.resize(cellStart.back());
+    for (int i = count - 1; i >= 0; --i) {
+        const Body& body = bodies[i];
+        for (int z = body.cellMin[2]; z <= body.cellMax[2]; ++z) {
+            for (int y = body.cellMin[1]; y <= body.cellMax[1]; ++y) {
+                for (int x = body.cellMin[0]; x <= body.cellMax[0]; ++x) {
+                    cellBodies[--cellStart[cellIndex(x, y, z)]] = static_cast<uint32_t>(i);
+                }
+            }
+        }
+    }
+}
+
+void QuerySnapshot::clear() {
+    bodies.clear();
+    cellStart.clear();
+    cellBodies.clear();
+}
+
+size_t QuerySnapshot::getMemoryUsage() const {
+    return bodies.capacity() * sizeof(Body) + (cellStart.capacity() + cellBodies.capacity()) * sizeof(uint32_t);
+}
+
+void QuerySnapshot::cellRange(const btVector3& min, const btVector3& max, int* cellMin, int* cellMax) const {
+    for (int axis = 0; axis < 3; ++axis) {
+        int low = static_cast<int>(std::floor((min[axis] - gridMin[axis]) / cellSize));
+        int high = static_cast<int>(std::floor((max[axis] - gridMin[axis]) / cellSize));
+        cellMin[axis] = std::clamp(low, 0, cellsPerAxis - 1);
+        cellMax[axis] = std::clamp(high, 0, cellsPerAxis - 1);
+    }
+}
+
+void QuerySnapshot::raycast(const RayQuery* queries, size_t count, RayQueryHit* hits) const {
+    // Тело лежит в нескольких ячейках, но проверяется лучом один раз. Метки
+    // свои у каждого потока, поэтому снимок можно опрашивать параллельно
+    static thread_local std::vector<uint32_t> stamps;
+    static thread_local uint32_t stamp = 0;
+    if (stamps.size() < static_cast<size_t>(bodies.size())) {
+        stamps.resize(bodies.size(), 0);
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        if (++stamp == 0) {
+            std::fill(stamps.begin(), stamps.end(), 0);
+            stamp = 1;
+        }
+        hits[i] = RayQueryHit();
+        raycastOne(queries[i], stamp, stamps, hits[i]);
+    }
+}
+
+bool QuerySnapshot::raycastOne(const RayQuery& query, uint32_t stamp, std::vector<uint32_t>& stamps,
+    RayQueryHit& hit) const {
+    if (bodies.size() == 0) return false;
+
+    // Отрезок обрезается по границам сетки
+    const btVector3 direction = query.to - query.from;
+    const btScalar gridSpan = cellsPerAxis * cellSize;
+    btScalar tEnter = 0.0f;
+    btScalar tExit = 1.0f;
+    for (int axis = 0; axis < 3; ++axis) {
+        btScalar origin = query.from[axis] - gridMin[axis];
+        if (std::fabs(direction[axis]) < SIMD_EPSILON) {
+            if (origin < 0.0f || origin > gridSpan) return false;
+            continue;
+        }
+        btScalar t0 = -origin / direction[axis];
+        btScalar t1 = (gridSpan - origin) / direction[axis];
+        if (t0 > t1) std::swap(t0, t1);
+        tEnter = std::max(tEnter, t0);
+        tExit = std::min(tExit, t1);
+    }
+    if (tEnter > tExit) return false;
+
+    // Обход ячеек вдоль луча (Amanatides-Woo): tMax - доля пути до следующей
+    // границы ячейки по оси, tDelta - доля пути через одну ячейку
+    const btScalar infinity = std::numeric_limits<btScalar>::infinity();
+    btVector3 start = query.from + direction * tEnter;
+    int cell[3];
+    int step[3];
+    btScalar tMax[3];
+    btScalar tDelta[3];
+    for (int axis = 0; axis < 3; ++axis) {
+        cell[axis] = std::clamp(static_cast<int>((start[axis] - gridMin[axis]) / cellSize), 0, cellsPerAxis - 1);
+        if (direction[axis] > SIMD_EPSILON) {
+            step[axis] = 1;
+            tMax[axis] = (gridMin[axis] + (cell[axis] + 1) * cellSize - query.from[axis]) / direction[axis];
+            tDelta[axis] = cellSize / direction[axis];
+        } else if (direction[axis] < -SIMD_EPSILON) {
+            step[axis] = -1;
+            tMax[axis] = (gridMin[axis] + cell[axis] * cellSize - query.from[axis]) / direction[axis];
+            tDelta[axis] = -cellSize / direction[axis];
+        } else {
+            step[axis] = 0;
+            tMax[axis] = infinity;
+            tDelta[axis] = infinity;
+        }
+    }
+
+    const btTransform rayFrom(btQuaternion::getIdentity(), query.from);
+    const btTransform rayTo(btQuaternion::getIdentity(), query.to);
+    btCollisionWorld::ClosestRayResultCallback callback(query.from, query.to);
+    int hitBody = -1;
+    while (true) {
+        size_t c = cellIndex(cell[0], cell[1], cell[2]);
+        for (uint32_t i = cellStart[c]; i < cellStart[c + 1]; ++i) {
+            uint32_t index = cellBodies[i];
+            if (stamps[index] == stamp) continue;
+            stamps[index] = stamp;
+
+            // Дешевая проверка по AABB, затем точная по форме тела
+            const Body& body = bodies[index];
+            btScalar param = callback.m_closestHitFraction;
+            btVector3 normal;
+            if (!btRayAabb(query.from, query.to, body.aabbMin, body.aabbMax, param, normal)) continue;
+            btScalar closest = callback.m_closestHitFraction;
+            btCollisionWorld::rayTestSingle(rayFrom, rayTo, body.object, body.shape, body.transform, callback);
+            if (callback.m_closestHitFraction < closest) {
+                hitBody = static_cast<int>(index);
+            }
+        }
+
+        // Точка любого попадания лежит в одной из пройденных ячеек, поэтому
+        // обход заканчивается, как только следующая граница дальше попадания
+        int axis = tMax[0] < tMax[1] ? (tMax[0] < tMax[2] ? 0 : 2) : (tMax[1] < tMax[2] ? 1 : 2);
+        if (tMax[axis] > tExit || tMax[axis] >= callback.m_closestHitFraction) break;
+        cell[axis] += step[axis];
+        if (cell[axis] < 0 || cell[axis] >= cellsPerAxis) break;
+        tMax[axis] += tDelta[axis];
+    }
+
+    if (hitBody < 0) return false;
+    hit.handle = bodies[hitBody].handle;
+    hit.fraction = callback.m_closestHitFraction;
+    hit.point = callback.m_hitPointWorld;
+    hit.normal = callback.m_hitNormalWorld;
+    return true;
+}
+
+static void queryBounds(const SphereQuery& query, btVector3& min, btVector3& max) {
+    btVector3 extent(query.radius, query.radius, query.radius);
+    min = query.center - extent;
+    max = query.center + extent;
+}
+
+static void queryBounds(const AabbQuery& query, btVector3& min, btVector3& max) {
+    min = query.min;
+    max = query.max;
+}
+
+static bool overlapsBody(const SphereQuery& query, const btVector3& aabbMin, const btVector3& aabbMax,
+    const btVector3& center, btScalar radius) {
+    btVector3 closest = query.center;
+    closest.setMax(aabbMin);
+    closest.setMin(aabbMax);
+    if ((closest - query.center).length2() > query.radius * query.radius) return false;
+    btScalar reach = query.radius + radius;
+    return (center - query.center).length2() <= reach * reach;
+}
+
+static bool overlapsBody(const AabbQuery& query, const btVector3& aabbMin, const btVector3& aabbMax,
+    const btVector3&, btScalar) {
+    return TestAabbAgainstAabb2(query.min, query.max, aabbMin, aabbMax);
+}
+
+template <typename Query>
+void QuerySnapshot::overlapQueries(const Query* queries, size_t count, QueryResults& results) const {
+    results.clear();
+    results.offsets.reserve(count + 1);
+    for (size_t q = 0; q < count; ++q) {
+        const Query& query = queries[q];
+        btVector3 min;
+        btVector3 max;
+        queryBounds(query, min, max);
+        int queryMin[3];
+        int queryMax[3];
+        cellRange(min, max, queryMin, queryMax);
+
+        for (int z = queryMin[2]; z <= queryMax[2]; ++z) {
+            for (int y = queryMin[1]; y <= queryMax[1]; ++y) {
+                for (int x = queryMin[0]; x <= queryMax[0]; ++x) {
+                    size_t c = cellIndex(x, y, z);
+                    for (uint32_t i = cellStart[c]; i < cellStart[c + 1]; ++i) {
+                        const Body& body = bodies[cellBodies[i]];
+                        // Тело попадает в ответ один раз - в первой ячейке,
+                        // общей для него и запроса
+                        if (x != std::max(body.cellMin[0], queryMin[0]) || y != std::max(body.cellMin[1], queryMin[1])
+                            || z != std::max(body.cellMin[2], queryMin[2])) {
+                            continue;
+                        }
+                        if (!overlapsBody(query, body.aabbMin, body.aabbMax, body.center, body.radius)) continue;
+                        OverlapHit hit;
+                        hit.handle = body.handle;
+                        hit.position = body.transform.getOrigin();
+                        results.hits.push_back(hit);
+                    }
+                }
+            }
+        }
+        results.offsets.push_back(static_cast<uint32_t>(results.hits.size()));
+    }
+}
+
+void QuerySnapshot::overlap(const SphereQuery* queries, size_t count, QueryResults& results) const {
+    overlapQueries(queries, count, results);
+}
+
+void QuerySnapshot::overlap(const AabbQuery* queries, size_t count, QueryResults& results) const {
+    overlapQueries(queries, count, results);
+}
\ No newline at end of file
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "slot_map.h"
+#include <bullet/btBulletDynamicsCommon.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Запросы к телам мира пакетами: лучи, сферы и AABB
+struct RayQuery {
+    btVector3 from;
+    btVector3 to;
+};
+
+struct SphereQuery {
+    btVector3 center;
+    btScalar radius;
+};
+
+struct AabbQuery {
+    btVector3 min;
+    btVector3 max;
+};
+
+// Ближайшее попадание луча. Без попадания ручка недействительна, fraction = 1
+struct RayQueryHit {
+    BodyHandle handle;
+    btScalar fraction = 1.0f;
+    btVector3 point;
+    btVector3 normal;
+};
+
+// Тело, найденное запросом области, и его центр на момент снимка
+struct OverlapHit {
+    BodyHandle handle;
+    btVector3 position;
+};
+
+// Результаты пакета запросов области: тела запроса i -
+// hits[offsets[i]] .. hits[offsets[i + 1] - 1], offsets на один длиннее пакета
+struct QueryResults {
+    std::vector<uint32_t> offsets;
+    std::vector<OverlapHit> hits;
+
+    size_t size() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+    void clear();
+    // Дописывает результаты следующего куска пакета
+    void append(const QueryResults& chunk);
+};
+
+// Снимок динамических тел только для чтения: трансформы, AABB по ним и
+// формы, разложенные по равномерной сетке. После построения снимок не
+// зависит от мира, поэтому запросы к нему можно вести из любого числа
+// потоков одновременно, в том числе пока мир делает следующий шаг. Формы не
+// копируются: снимок действителен, пока тела снимка не удалены.
+class QuerySnapshot {
+public:
+    QuerySnapshot();
+
+    void build(const SlotMap<btRigidBody*>& bodies);
+    void clear();
+    size_t size() const { return bodies.size(); }
+
+    // Ближайшее тело на каждом отрезке from-to, точная проверка по форме.
+    // Стены в снимок не входят
+    void raycast(const RayQuery* queries, size_t count, RayQueryHit* hits) const;
+    // Все тела, пересекающие область каждого запроса. Сфера проверяется по AABB
+    // тела и по описанной сфере его формы - для сфер точно, для остальных форм
+    // с запасом у ребер. results перезаписываются
+    void overlap(const SphereQuery* queries, size_t count, QueryResults& results) const;
+    void overlap(const AabbQuery* queries, size_t count, QueryResults& results) const;
+
+    size_t getMemoryUsage() const;
+
+private:
+    struct Body {
+        btTransform transform;
+        btVector3 aabbMin;
+        btVector3 aabbMax;
+        btVector3 center; // центр описанной сферы в мире
+        btScalar radius;
+        btCollisionObject* object;
+        const btCollisionShape* shape;
+        BodyHandle handle;
+        int cellMin[3]; // ячейки сетки, которые покрывает AABB
+        int cellMax[3];
+    };
+
+    template <typename Query>
+    void overlapQueries(const Query* queries, size_t count, QueryResults& results) const;
+    bool raycastOne(const RayQuery& query, uint32_t stamp, std::vector<uint32_t>& stamps, RayQueryHit& hit) const;
+    void cellRange(const btVector3& min, const btVector3& max, int* cellMin, int* cellMax) const;
+    size_t cellIndex(int x, int y, int z) const {
+        return (static_cast<size_t>(z) * cellsPerAxis + y) * cellsPerAxis + x;
+    }
+
+    btAlignedObjectArray<Body> bodies;
+
+    // Сетка: тела по ячейкам подряд. Тело лежит во всех ячейках своего AABB
+    btVector3 gridMin;
+    btScalar cellSize;
+    int cellsPerAxis;
+    std::vector<uint32_t> cellStart; // первая запись ячейки, последний элемент - число записей
+    std::vector<uint32_t> cellBodies;
+};
\ No newline at end of file
@@ -0,0 +1,226 @@
+#include "physics_thread.h"
+#include "timestep.h"
+#include "trace.h"
+#include <algorithm>
+#include <chrono>
+
+using Clock = std::chrono::steady_clock;
+
+// Сколько кадров профиля ждет рендер, пока не начнет их забирать; старые
+// кадры сверх этого отбрасываются
+static const size_t MAX_PROFILE_FRAMES = 240;
+
+static double secondsSinceEpoch(Clock::time_point time) {
+    return std::chrono::duration<double>(time.time_since_epoch()).count();
+}
+
+static glm::vec3 toGlm(const btVector3& v) {
+    return glm::vec3(v.x(), v.y(), v.z());
+}
+
+static glm::vec4 toGlm(const btQuaternion& q) {
+    return glm::vec4(q.x(), q.y(), q.z(), q.w());
+}
+
+PhysicsThread::PhysicsThread(BulletBackend& backend)
+    : backend(backend)
+    , world(backend.getWorld())
+    , objects(backend.getObjects())
+    , running(false)
+    , lastPublishIdle(false)
+    , contactCounts() {
+    contactEvents.init(PhysicsWorldConfig().contactEventCapacity);
+}
+
+PhysicsThread::~PhysicsThread() {
+    stop();
+}
+
+void PhysicsThread::start() {
+    if (running) return;
+    running = true;
+    thread = std::thread(&PhysicsThread::run, this);
+}
+
+void PhysicsThread::stop() {
+    running = false;
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void PhysicsThread::post(Command command) {
+    std::lock_guard<std::mutex> lock(commandMutex);
+    pendingCommands.push_back(std::move(command));
+}
+
+void PhysicsThread::setSettings(const PhysicsSettings& newSettings) {
+    std::lock_guard<std::mutex> lock(commandMutex);
+    settings = newSettings;
+}
+
+const PhysicsSnapshot& PhysicsThread::acquireSnapshot() {
+    snapshots.update();
+    return snapshots.readBuffer();
+}
+
+void PhysicsThread::readProfileFrames(std::vector<std::vector<ProfileZone>>& frames) {
+    frames.clear();
+    std::lock_guard<std::mutex> lock(profileMutex);
+    frames.swap(profileFrames);
+}
+
+size_t PhysicsThread::readContactEvents(std::vector<ContactEvent>& events) {
+    std::lock_guard<std::mutex> lock(contactMutex);
+    return contactEvents.read(events);
+}
+
+float PhysicsThread::interpolationAlpha(const PhysicsSnapshot& snapshot) {
+    double elapsed = secondsSinceEpoch(Clock::now()) - snapshot.publishTime;
+    return static_cast<float>(std::clamp(elapsed / snapshot.stepTime, 0.0, 1.0));
+}
+
+void PhysicsThread::stepSynchronous(float stepTime) {
+    PhysicsSettings currentSettings;
+    executeCommands(currentSettings);
+    world.stepSimulation(stepTime);
+    publishSnapshot(stepTime, secondsSinceEpoch(Clock::now()));
+    commands.clear();
+}
+
+bool PhysicsThread::loadSnapshot(const std::string& path, PhysicsSettings& loadedSettings) {
+    if (running) return false;
+    if (!world.loadSnapshot(path, objects, loadedSettings)) return false;
+
+    std::lock_guard<std::mutex> lock(commandMutex);
+    settings = loadedSettings;
+    return true;
+}
+
+bool PhysicsThread::loadSceneMap(const MappedScene& scene) {
+    if (running) return false;
+    return world.loadSceneMap(scene, objects);
+}
+
+void PhysicsThread::executeCommands(PhysicsSettings& currentSettings) {
+    {
+        std::lock_guard<std::mutex> lock(commandMutex);
+        commands.swap(pendingCommands);
+        currentSettings = settings;
+    }
+    world.setSleeping(currentSettings.sleepingEnabled,
+        currentSettings.sleepLinearThreshold, currentSettings.sleepAngularThreshold);
+    world.setCcdPolicy(currentSettings.adaptiveCcd, currentSettings.ccdMotionFraction);
+    world.setSolverSettings(currentSettings);
+    world.setContactEvents(currentSettings.contactEvents, currentSettings.contactImpulseThreshold);
+    if (commands.empty()) return;
+    ProfileScope scope(world.getProfile(), "commands");
+    for (auto& command : commands) {
+        command(world, objects);
+    }
+}
+
+void PhysicsThread::run() {
+    FixedTimestep timestep;
+    PhysicsSettings currentSettings;
+    Clock::time_point lastTime = Clock::now();
+    Trace::setThreadName("physics");
+
+    while (running) {
+        Clock::time_point tickStart = Clock::now();
+        executeCommands(currentSettings);
+
+        Clock::time_point now = Clock::now();
+        float frameTime = std::chrono::duration<float>(now - lastTime).count();
+        lastTime = now;
+
+        int steps = timestep.advance(frameTime, currentSettings);
+        for (int i = 0; i < steps; ++i) {
+            world.stepSimulation(timestep.getStepTime());
+        }
+
+        // Когда все тела спят, снимок не меняется - не тратим на него время
+        if (!commands.empty() || (steps > 0 && !lastPublishIdle)) {
+            publishSnapshot(timestep.getStepTime(), secondsSinceEpoch(Clock::now()));
+        } else {
+            // Профиль неопубликованных шагов не копится до следующего снимка
+            world.getProfile().clear();
+        }
+        commands.clear();
+        // В трассе итерация цикла без сна до следующего шага
+        if (Trace::isEnabled()) {
+            Trace::record("physicsTick", tickStart, Clock::now());
+        }
+
+        // Спим до момента, когда накопится следующий шаг
+        float untilNextStep = (1.0f - timestep.getAlpha()) * timestep.getStepTime();
+        std::this_thread::sleep_for(std::chrono::duration<float>(untilNextStep));
+    }
+}
+
+void PhysicsThread::publishSnapshot(float stepTime, double publishTime) {
+    TraceScope scope("publishSnapshot");
+    Clock::time_point start = Clock::now();
+    PhysicsSnapshot& snapshot = snapshots.writeBuffer();
+    snapshot.bodies.resize(objects.size());
+    snapshot.publishTime = publishTime;
+    snapshot.stepTime = stepTime;
+    snapshot.tick = world.getTickCount();
+    snapshot.stats = PhysicsStats();
+
+    btTransform previous;
+    btTransform current;
+    for (size_t i = 0; i < objects.size(); ++i) {
+        const PhysicsObject& obj = objects[i];
+        static_cast<const InterpolatedMotionState*>(obj.motionState)->getStepTransforms(previous, current);
+
+        BodySnapshot& body = snapshot.bodies[i];
+        body.previousPosition = toGlm(previous.getOrigin());
+        body.previousRotation = toGlm(previous.getRotation());
+        body.position = toGlm(current.getOrigin());
+        body.rotation = toGlm(current.getRotation());
+        body.color = obj.color;
+        body.type = obj.type;
+        body.handle = obj.handle;
+
+        if (obj.rigidBody->isActive()) {
+            ++snapshot.stats.activeBodies;
+        } else {
+            ++snapshot.stats.sleepingBodies;
+        }
+    }
+
+    snapshot.stats.ccdArmed = world.getCcdArmedCount();
+    SolverStats solver = world.getSolverStats();
+    snapshot.stats.solverType = static_cast<int>(solver.type);
+    snapshot.stats.solverIterations = solver.iterations;
+    snapshot.stats.solveMs = static_cast<float>(solver.solveMs);
+
+    // События в снимок не кладутся: снимок, который рендер пропустит, унес бы
+    // их с собой. Счетчики с запуска верны и в любом следующем снимке
+    world.readContactEvents(stepContactEvents);
+    {
+        std::lock_guard<std::mutex> lock(contactMutex);
+        for (const ContactEvent& event : stepContactEvents) {
+            contactEvents.push(event);
+            ++contactCounts[static_cast<int>(event.type)];
+        }
+    }
+    snapshot.stats.contactBegins = contactCounts[static_cast<int>(ContactEventType::Begin)];
+    snapshot.stats.contactPersists = contactCounts[static_cast<int>(ContactEventType::Persist)];
+    snapshot.stats.contactEnds = contactCounts[static_cast<int>(ContactEventType::End)];
+    lastPublishIdle = snapshot.stats.activeBodies == 0;
+    float publishMs = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+    snapshot.stats.publishMs = publishMs;
+    snapshots.publish();
+
+    // После publish снимок принадлежит читателю
+    world.getProfile().read(profileZones);
+    ProfileZone publishZone = { "publishSnapshot", -1, 0, publishMs };
+    profileZones.push_back(publishZone);
+    std::lock_guard<std::mutex> lock(profileMutex);
+    if (profileFrames.size() >= MAX_PROFILE_FRAMES) {
+        profileFrames.erase(profileFrames.begin());
+    }
+    profileFrames.push_back(profileZones);
+}
\ No newline at end of file
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "bullet_backend.h"
+#include "snapshot.h"
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Поток физики: шагает мир движка Bullet с фиксированной частотой и после
+// каждого кадра публикует снимок трансформ через тройной буфер. Все изменения
+// мира идут через очередь команд, которые выполняются в потоке физики перед
+// шагом; команда может работать и с миром, и с движком через getBackend.
+class PhysicsThread {
+public:
+    using Command = std::function<void(PhysicsWorld&, std::vector<PhysicsObject>&)>;
+
+    explicit PhysicsThread(BulletBackend& backend);
+    ~PhysicsThread();
+
+    void start();
+    void stop();
+
+    // Вызываются из потока рендера
+    void post(Command command);
+    void setSettings(const PhysicsSettings& settings);
+    // Последний полностью записанный снимок; ссылка валидна до следующего вызова
+    const PhysicsSnapshot& acquireSnapshot();
+    // Доля шага, прошедшая с публикации снимка (0..1), для интерполяции
+    static float interpolationAlpha(const PhysicsSnapshot& snapshot);
+    // Кадры профиля всех снимков, опубликованных с прошлого вызова, по порядку.
+    // Тройной буфер отдает рендеру только последний снимок, поэтому профиль
+    // идет отдельной очередью и кадры пропущенных снимков не теряются
+    void readProfileFrames(std::vector<std::vector<ProfileZone>>& frames);
+    // События контактов всех шагов с прошлого вызова, от старых к новым; тела
+    // в них - ручки, как handle в снимке. По той же причине идут мимо снимка.
+    // Если долго не читать, самые старые события перезаписываются
+    size_t readContactEvents(std::vector<ContactEvent>& events);
+
+    // Кадр без отдельного потока: команды, ровно один шаг и публикация снимка.
+    // Используется для детерминированного воспроизведения; поток при этом не запущен.
+    void stepSynchronous(float stepTime);
+    // Загрузка двоичного снимка сцены; вызывается только до start()
+    bool loadSnapshot(const std::string& path, PhysicsSettings& loadedSettings);
+    bool loadSceneMap(const MappedScene& scene);
+
+    // Движок, который шагает поток: трогать его можно только из команд
+    PhysicsBackend& getBackend() { return backend; }
+
+private:
+    void run();
+    void executeCommands(PhysicsSettings& currentSettings);
+    void publishSnapshot(float stepTime, double publishTime);
+
+    BulletBackend& backend;
+    PhysicsWorld& world;
+    std::vector<PhysicsObject>& objects;
+
+    std::thread thread;
+    std::atomic<bool> running;
+
+    std::mutex commandMutex;
+    std::vector<Command> pendingCommands;
+    std::vector<Command> commands;
+    PhysicsSettings settings;
+
+    TripleBuffer<PhysicsSnapshot> snapshots;
+    std::vector<ProfileZone> profileZones;
+    std::mutex profileMutex;
+    std::vector<std::vector<ProfileZone>> profileFrames;
+    std::vector<ContactEvent> stepContactEvents;
+    std::mutex contactMutex;
+    ContactEventRing contactEvents;
+    uint64_t contactCounts[3]; // по ContactEventType, с запуска
+    bool lastPublishIdle;
+};
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "slot_map.h"
+#include <glm/glm.hpp>
+#include <bullet/btBulletDynamicsCommon.h>
+
+struct PhysicsObject {
+    btRigidBody* rigidBody;
+    btCollisionShape* shape;
+    btMotionState* motionState;
+    int type; // 0 - куб, 1 - сфера, 2 - цилиндр
+    glm::vec3 color;
+    BodyHandle handle; // выдается миром в addObject
+};
+
+struct PhysicsSettings {
+    float forceScale = 0.01f;
+    float horizontalScale = 1.0f;
+    float verticalScale = 1.0f;
+    float zScale = 1.0f;
+    float maxForce = 10.0f;
+    float torqueScale = 0.0002f;
+    float maxTorque = 5.0f;
+    float restitution = 0.5f;
+    float friction = 0.5f;
+    float rollingFriction = 0.1f;
+    float spinningFriction = 0.4f;
+    float damping = 0.1f;
+    float massScale = 1.0f;
+    float tickRate = 60.0f;       // Частота фиксированного шага физики, Гц
+    int maxCatchUpSteps = 4;      // Максимум шагов за кадр, остальное время отбрасывается
+    bool releaseMemoryOnClear = false; // Возвращать память пулов тел при очистке сцены
+    bool sleepingEnabled = true;  // Засыпание покоящихся тел
+    float sleepLinearThreshold = 0.8f;
+    float sleepAngularThreshold = 1.0f;
+    bool adaptiveCcd = true;      // CCD только для тел, быстрых относительно своего размера
+    float ccdMotionFraction = 0.5f; // доля внутреннего радиуса, после которой за шаг включается CCD
+    int solverType = 0;           // 0 - последовательные импульсы, 1 - NNCG
+    bool adaptiveSolver = true;   // подбирать число итераций под бюджет времени решателя
+    int minSolverIterations = 4;
+    int maxSolverIterations = 10; // без адаптации - постоянное число итераций
+    float solverBudgetMs = 4.0f;  // целевое время решателя на шаг
+    float solverResidualThreshold = 0.0f; // ранний выход по невязке, 0 - все итерации
+    bool contactEvents = true;    // события начала, продолжения и конца касаний
+    float contactImpulseThreshold = 1.0f; // события только для пар с суммарным импульсом не меньше
+    glm::vec3 cubeColor = glm::vec3(0.8f, 0.3f, 0.2f);
+};
+
+// Глобальные константы
+const float BOUNDARY_SIZE = 5.0f;
+// Стены коробки стоят серединой на расстоянии BOUNDARY_SIZE от центра, их
+// внутренние грани - на BOUNDARY_INNER
+const float BOUNDARY_THICKNESS = 0.2f;
+const float BOUNDARY_INNER = BOUNDARY_SIZE - BOUNDARY_THICKNESS * 0.5f;
+// Зазор решеток размещения ParticleWorld и ReferenceBackend в долях радиуса
+const float SPAWN_GAP = 0.2f;
\ No newline at end of file
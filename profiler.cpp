@@ -0,0 +1,212 @@
+#include "profiler.h"
+#include "trace.h"
+#include <bullet/LinearMath/btQuickprof.h>
+#include <algorithm>
+#include <cstring>
+
+static bool sameName(const char* a, const char* b) {
+    return a == b || std::strcmp(a, b) == 0;
+}
+
+void FrameProfile::begin(const char* name) {
+    int parent = openZones.empty() ? -1 : openZones.back();
+    openZones.push_back(findOrAdd(name, parent));
+    openStarts.push_back(Clock::now());
+}
+
+void FrameProfile::end() {
+    if (openZones.empty()) return;
+    Clock::time_point now = Clock::now();
+    ProfileZone& zone = zones[openZones.back()];
+    zone.ms += std::chrono::duration<float, std::milli>(now - openStarts.back()).count();
+    // Каждая зона профиля - заодно событие трассы
+    if (Trace::isEnabled()) {
+        Trace::record(zone.name, openStarts.back(), now);
+    }
+    openZones.pop_back();
+    openStarts.pop_back();
+}
+
+void FrameProfile::addBulletTree() {
+#ifndef BT_NO_PROFILE
+    CProfileIterator* iterator = CProfileManager::Get_Iterator();
+    if (!iterator) return;
+    addBulletChildren(iterator, openZones.empty() ? -1 : openZones.back());
+    CProfileManager::Release_Iterator(iterator);
+#endif
+}
+
+void FrameProfile::addBulletChildren(CProfileIterator* iterator, int parent) {
+#ifndef BT_NO_PROFILE
+    // Сначала все дети узла, потом спуск в каждого, как в CProfileManager::dumpRecursive.
+    // Узлы, которые на этом шаге не вызывались, остаются в дереве с нулем вызовов
+    int children = 0;
+    for (iterator->First(); !iterator->Is_Done(); iterator->Next()) {
+        ++children;
+        if (iterator->Get_Current_Total_Calls() == 0) continue;
+        int zone = findOrAdd(iterator->Get_Current_Name(), parent);
+        zones[zone].ms += iterator->Get_Current_Total_Time();
+    }
+    for (int i = 0; i < children; ++i) {
+        iterator->Enter_Child(i);
+        if (iterator->Get_Current_Parent_Total_Calls() > 0) {
+            addBulletChildren(iterator, findOrAdd(iterator->Get_Current_Parent_Name(), parent));
+        }
+        iterator->Enter_Parent();
+    }
+#else
+    (void)iterator;
+    (void)parent;
+#endif
+}
+
+void FrameProfile::read(std::vector<ProfileZone>& out) {
+    out.assign(zones.begin(), zones.end());
+    zones.clear();
+}
+
+void FrameProfile::clear() {
+    zones.clear();
+}
+
+int FrameProfile::findOrAdd(const char* name, int parent) {
+    // Зон в кадре десятки, линейный поиск дешевле любой карты
+    for (size_t i = 0; i < zones.size(); ++i) {
+        if (zones[i].parent == parent && sameName(zones[i].name, name)) {
+            return static_cast<int>(i);
+        }
+    }
+    ProfileZone zone = { name, parent, parent < 0 ? 0 : zones[parent].depth + 1, 0.0f };
+    zones.push_back(zone);
+    return static_cast<int>(zones.size() - 1);
+}
+
+ProfileHistory::ProfileHistory(size_t window)
+    : frames(std::max<size_t>(window, 1))
+    , window(std::max<size_t>(window, 1))
+    , next(0)
+    , count(0) {
+}
+
+void ProfileHistory::setWindow(size_t frameCount) {
+    window = std::max<size_t>(frameCount, 1);
+    frames.assign(window, std::vector<ProfileZone>());
+    next = 0;
+    count = 0;
+}
+
+void ProfileHistory::addFrame(const std::vector<ProfileZone>& zones) {
+    frames[next].assign(zones.begin(), zones.end());
+    next = (next + 1) % window;
+    count = std::min(count + 1, window);
+}
+
+void ProfileHistory::clear() {
+    for (std::vector<ProfileZone>& frame : frames) {
+        frame.clear();
+    }
+    next = 0;
+    count = 0;
+}
+
+const std::vector<ProfileZone>& ProfileHistory::getLastFrame() const {
+    return frames[(next + window - 1) % window];
+}
+
+const std::vector<ProfileZone>& ProfileHistory::getWorstFrame() const {
+    size_t worst = (next + window - 1) % window;
+    for (size_t i = 0; i < count; ++i) {
+        size_t frame = (next + window - 1 - i) % window;
+        if (frameTime(frames[frame]) > frameTime(frames[worst])) {
+            worst = frame;
+        }
+    }
+    return frames[worst];
+}
+
+float ProfileHistory::frameTime(const std::vector<ProfileZone>& zones) {
+    float total = 0.0f;
+    for (const ProfileZone& zone : zones) {
+        if (zone.parent < 0) total += zone.ms;
+    }
+    return total;
+}
+
+// Зона с одним и тем же путем во всех кадрах окна
+struct ProfileTrack {
+    const char* name;
+    int parent;
+    int depth;
+    std::vector<float> samples;
+    std::vector<int> children;
+};
+
+static ProfileZoneStats summarize(const char* name, int depth, const std::vector<float>& samples, std::vector<float>& sorted) {
+    ProfileZoneStats stats = { name, depth, samples.back(), samples[0], 0.0f, 0.0f };
+    double sum = 0.0;
+    for (float sample : samples) {
+        stats.min = std::min(stats.min, sample);
+        sum += sample;
+    }
+    stats.avg = static_cast<float>(sum / samples.size());
+
+    sorted.assign(samples.begin(), samples.end());
+    size_t rank = (sorted.size() - 1) * 99 / 100;
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+    stats.p99 = sorted[rank];
+    return stats;
+}
+
+static void appendTrack(const std::vector<ProfileTrack>& tracks, int track, std::vector<float>& sorted,
+    std::vector<ProfileZoneStats>& stats) {
+    const ProfileTrack& entry = tracks[track];
+    stats.push_back(summarize(entry.name, entry.depth + 1, entry.samples, sorted));
+    for (int child : entry.children) {
+        appendTrack(tracks, child, sorted, stats);
+    }
+}
+
+void ProfileHistory::computeStats(std::vector<ProfileZoneStats>& stats) const {
+    stats.clear();
+    if (count == 0) return;
+
+    std::vector<ProfileTrack> tracks;
+    std::vector<int> roots;
+    std::vector<float> totals(count, 0.0f);
+    std::vector<int> trackOf;
+    size_t oldest = (next + window - count) % window;
+    for (size_t f = 0; f < count; ++f) {
+        const std::vector<ProfileZone>& zones = frames[(oldest + f) % window];
+        trackOf.resize(zones.size());
+        for (size_t i = 0; i < zones.size(); ++i) {
+            const ProfileZone& zone = zones[i];
+            int parent = zone.parent >= 0 ? trackOf[zone.parent] : -1;
+            int track = -1;
+            for (size_t t = 0; t < tracks.size(); ++t) {
+                if (tracks[t].parent == parent && sameName(tracks[t].name, zone.name)) {
+                    track = static_cast<int>(t);
+                    break;
+                }
+            }
+            if (track < 0) {
+                track = static_cast<int>(tracks.size());
+                ProfileTrack entry = { zone.name, parent, zone.depth, std::vector<float>(count, 0.0f), {} };
+                tracks.push_back(entry);
+                if (parent >= 0) {
+                    tracks[parent].children.push_back(track);
+                } else {
+                    roots.push_back(track);
+                }
+            }
+            tracks[track].samples[f] += zone.ms;
+            trackOf[i] = track;
+            if (zone.parent < 0) totals[f] += zone.ms;
+        }
+    }
+
+    std::vector<float> sorted;
+    stats.push_back(summarize("frame", 0, totals, sorted));
+    for (int root : roots) {
+        appendTrack(tracks, root, sorted, stats);
+    }
+}
\ No newline at end of file
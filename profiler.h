@@ -0,0 +1,94 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+class CProfileIterator;
+
+// Зона профиля кадра. Имена - строковые литералы, поэтому кадр можно
+// передать в другой поток вместе со снимком без копирования строк
+struct ProfileZone {
+    const char* name;
+    int parent; // индекс родителя в том же кадре, -1 у корневых зон
+    int depth;
+    float ms;
+};
+
+// Иерархический профиль кадра одного потока. Одноименные зоны под одним
+// родителем складываются, так что несколько шагов за кадр дают одно дерево,
+// а родитель всегда стоит в массиве раньше своих детей.
+class FrameProfile {
+public:
+    void begin(const char* name);
+    void end();
+    // Дерево CProfileManager последнего шага Bullet в этом потоке - под
+    // открытой сейчас зоной. Bullet сбрасывает его в начале каждого шага,
+    // поэтому вызывается сразу после stepSimulation. С BT_NO_PROFILE пусто
+    void addBulletTree();
+    // Забирает накопленные зоны и начинает новый кадр
+    void read(std::vector<ProfileZone>& out);
+    void clear();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    int findOrAdd(const char* name, int parent);
+    void addBulletChildren(CProfileIterator* iterator, int parent);
+
+    std::vector<ProfileZone> zones;
+    std::vector<int> openZones;
+    std::vector<Clock::time_point> openStarts;
+};
+
+// Зона на время жизни объекта
+class ProfileScope {
+public:
+    ProfileScope(FrameProfile& profile, const char* name) : profile(profile) { profile.begin(name); }
+    ~ProfileScope() { profile.end(); }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    FrameProfile& profile;
+};
+
+// Статистика одной зоны за окно кадров
+struct ProfileZoneStats {
+    const char* name;
+    int depth;
+    float last;
+    float min;
+    float avg;
+    float p99;
+};
+
+// Кольцо последних кадров одного потока для окна профайлера
+class ProfileHistory {
+public:
+    explicit ProfileHistory(size_t window = 240);
+
+    // Меняет размер окна; накопленные кадры сбрасываются
+    void setWindow(size_t frameCount);
+    size_t getWindow() const { return window; }
+    size_t getFrameCount() const { return count; }
+    void addFrame(const std::vector<ProfileZone>& zones);
+    void clear();
+
+    // Последний и самый долгий кадр окна; пустые, пока кадров нет
+    const std::vector<ProfileZone>& getLastFrame() const;
+    const std::vector<ProfileZone>& getWorstFrame() const;
+    // Время кадра - сумма корневых зон
+    static float frameTime(const std::vector<ProfileZone>& zones);
+
+    // Статистика всех зон окна в порядке дерева. Первая строка - кадр
+    // целиком, зона, которой не было в кадре, считается за 0 мс
+    void computeStats(std::vector<ProfileZoneStats>& stats) const;
+
+private:
+    std::vector<std::vector<ProfileZone>> frames;
+    size_t window;
+    size_t next;  // куда запишется следующий кадр
+    size_t count;
+};
\ No newline at end of file
@@ -0,0 +1,280 @@
+#include "recording.h"
+#include "scene_input.h"
+#include <algorithm>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+enum class FieldKind { Float, Int, Bool, Vec3 };
+
+struct SettingsField {
+    const char* name;
+    FieldKind kind;
+    size_t offset;
+};
+
+// Все поля PhysicsSettings: новое поле настроек нужно добавить и сюда,
+// иначе воспроизведение пойдет со значением по умолчанию
+const SettingsField SETTINGS_FIELDS[] = {
+    { "forceScale", FieldKind::Float, offsetof(PhysicsSettings, forceScale) },
+    { "horizontalScale", FieldKind::Float, offsetof(PhysicsSettings, horizontalScale) },
+    { "verticalScale", FieldKind::Float, offsetof(PhysicsSettings, verticalScale) },
+    { "zScale", FieldKind::Float, offsetof(PhysicsSettings, zScale) },
+    { "maxForce", FieldKind::Float, offsetof(PhysicsSettings, maxForce) },
+    { "torqueScale", FieldKind::Float, offsetof(PhysicsSettings, torqueScale) },
+    { "maxTorque", FieldKind::Float, offsetof(PhysicsSettings, maxTorque) },
+    { "restitution", FieldKind::Float, offsetof(PhysicsSettings, restitution) },
+    { "friction", FieldKind::Float, offsetof(PhysicsSettings, friction) },
+    { "rollingFriction", FieldKind::Float, offsetof(PhysicsSettings, rollingFriction) },
+    { "spinningFriction", FieldKind::Float, offsetof(PhysicsSettings, spinningFriction) },
+    { "damping", FieldKind::Float, offsetof(PhysicsSettings, damping) },
+    { "massScale", FieldKind::Float, offsetof(PhysicsSettings, massScale) },
+    { "tickRate", FieldKind::Float, offsetof(PhysicsSettings, tickRate) },
+    { "maxCatchUpSteps", FieldKind::Int, offsetof(PhysicsSettings, maxCatchUpSteps) },
+    { "releaseMemoryOnClear", FieldKind::Bool, offsetof(PhysicsSettings, releaseMemoryOnClear) },
+    { "sleepingEnabled", FieldKind::Bool, offsetof(PhysicsSettings, sleepingEnabled) },
+    { "sleepLinearThreshold", FieldKind::Float, offsetof(PhysicsSettings, sleepLinearThreshold) },
+    { "sleepAngularThreshold", FieldKind::Float, offsetof(PhysicsSettings, sleepAngularThreshold) },
+    { "adaptiveCcd", FieldKind::Bool, offsetof(PhysicsSettings, adaptiveCcd) },
+    { "ccdMotionFraction", FieldKind::Float, offsetof(PhysicsSettings, ccdMotionFraction) },
+    { "solverType", FieldKind::Int, offsetof(PhysicsSettings, solverType) },
+    { "adaptiveSolver", FieldKind::Bool, offsetof(PhysicsSettings, adaptiveSolver) },
+    { "minSolverIterations", FieldKind::Int, offsetof(PhysicsSettings, minSolverIterations) },
+    { "maxSolverIterations", FieldKind::Int, offsetof(PhysicsSettings, maxSolverIterations) },
+    { "solverBudgetMs", FieldKind::Float, offsetof(PhysicsSettings, solverBudgetMs) },
+    { "solverResidualThreshold", FieldKind::Float, offsetof(PhysicsSettings, solverResidualThreshold) },
+    { "contactEvents", FieldKind::Bool, offsetof(PhysicsSettings, contactEvents) },
+    { "contactImpulseThreshold", FieldKind::Float, offsetof(PhysicsSettings, contactImpulseThreshold) },
+    { "cubeColor", FieldKind::Vec3, offsetof(PhysicsSettings, cubeColor) },
+};
+
+const char* RECORD_HEADER = "wcp-record";
+const int RECORD_VERSION = 1;
+
+} // namespace
+
+std::string serializeSettings(const PhysicsSettings& settings) {
+    std::ostringstream out;
+    out << std::setprecision(9);
+    const char* base = reinterpret_cast<const char*>(&settings);
+    for (const auto& field : SETTINGS_FIELDS) {
+        const char* value = base + field.offset;
+        out << ' ' << field.name << '=';
+        switch (field.kind) {
+        case FieldKind::Float:
+            out << *reinterpret_cast<const float*>(value);
+            break;
+        case FieldKind::Int:
+            out << *reinterpret_cast<const int*>(value);
+            break;
+        case FieldKind::Bool:
+            out << (*reinterpret_cast<const bool*>(value) ? 1 : 0);
+            break;
+        case FieldKind::Vec3: {
+            const glm::vec3& v = *reinterpret_cast<const glm::vec3*>(value);
+            out << v.x << ',' << v.y << ',' << v.z;
+            break;
+        }
+        }
+    }
+    return out.str();
+}
+
+void parseSettings(const std::string& text, PhysicsSettings& settings) {
+    std::istringstream in(text);
+    std::string token;
+    char* base = reinterpret_cast<char*>(&settings);
+    while (in >> token) {
+        size_t eq = token.find('=');
+        if (eq == std::string::npos) continue;
+        std::string name = token.substr(0, eq);
+        std::istringstream value(token.substr(eq + 1));
+
+        for (const auto& field : SETTINGS_FIELDS) {
+            if (name != field.name) continue;
+            char* target = base + field.offset;
+            switch (field.kind) {
+            case FieldKind::Float:
+                value >> *reinterpret_cast<float*>(target);
+                break;
+            case FieldKind::Int:
+                value >> *reinterpret_cast<int*>(target);
+                break;
+            case FieldKind::Bool: {
+                int flag = 0;
+                value >> flag;
+                *reinterpret_cast<bool*>(target) = flag != 0;
+                break;
+            }
+            case FieldKind::Vec3: {
+                glm::vec3& v = *reinterpret_cast<glm::vec3*>(target);
+                char comma;
+                value >> v.x >> comma >> v.y >> comma >> v.z;
+                break;
+            }
+            }
+            break;
+        }
+    }
+}
+
+bool InputRecorder::open(const std::string& path) {
+    out.open(path);
+    if (!out.is_open()) {
+        std::cerr << "Cannot open recording file: " << path << std::endl;
+        return false;
+    }
+    out << std::setprecision(9);
+    out << RECORD_HEADER << ' ' << RECORD_VERSION << '\n';
+    lastSettings.clear();
+    return true;
+}
+
+void InputRecorder::recordWindowPos(double time, int xpos, int ypos) {
+    if (!out.is_open()) return;
+    out << "pos " << time << ' ' << xpos << ' ' << ypos << '\n';
+}
+
+void InputRecorder::recordSpawn(double time, int type) {
+    if (!out.is_open()) return;
+    out << "spawn " << time << ' ' << type << '\n';
+}
+
+void InputRecorder::recordSpawnBatch(double time, int type, int count) {
+    if (!out.is_open()) return;
+    out << "batch " << time << ' ' << type << ' ' << count << '\n';
+}
+
+void InputRecorder::recordClear(double time, bool releaseMemory) {
+    if (!out.is_open()) return;
+    out << "clear " << time << ' ' << (releaseMemory ? 1 : 0) << '\n';
+}
+
+void InputRecorder::recordSettings(double time, const PhysicsSettings& settings) {
+    if (!out.is_open()) return;
+    std::string serialized = serializeSettings(settings);
+    if (serialized == lastSettings) return;
+    out << "settings " << time << serialized << '\n';
+    lastSettings = serialized;
+}
+
+void InputRecorder::close(double time) {
+    if (!out.is_open()) return;
+    out << "end " << time << '\n';
+    out.close();
+}
+
+bool InputReplay::load(const std::string& path) {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        std::cerr << "Cannot open recording file: " << path << std::endl;
+        return false;
+    }
+
+    std::string header;
+    int version = 0;
+    in >> header >> version;
+    if (header != RECORD_HEADER || version != RECORD_VERSION) {
+        std::cerr << "Unsupported recording format: " << path << std::endl;
+        return false;
+    }
+
+    events.clear();
+    next = 0;
+    duration = 0.0;
+    initialSettings = PhysicsSettings();
+    bool haveInitialSettings = false;
+
+    std::string line;
+    std::getline(in, line);
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string kind;
+        InputEvent event;
+        if (!(fields >> kind >> event.time)) continue;
+
+        if (kind == "pos") {
+            event.type = InputEventType::WindowPos;
+            fields >> event.x >> event.y;
+        } else if (kind == "spawn") {
+            event.type = InputEventType::Spawn;
+            fields >> event.x;
+        } else if (kind == "batch") {
+            event.type = InputEventType::SpawnBatch;
+            fields >> event.x >> event.y;
+        } else if (kind == "clear") {
+            event.type = InputEventType::Clear;
+            fields >> event.x;
+        } else if (kind == "settings") {
+            event.type = InputEventType::Settings;
+            std::string rest;
+            std::getline(fields, rest);
+            parseSettings(rest, event.settings);
+            if (!haveInitialSettings) {
+                initialSettings = event.settings;
+                haveInitialSettings = true;
+            }
+        } else if (kind == "end") {
+            event.type = InputEventType::End;
+        } else {
+            continue;
+        }
+
+        duration = std::max(duration, event.time);
+        events.push_back(event);
+    }
+    return true;
+}
+
+void InputReplay::feed(double untilTime, SceneInput& input, PhysicsSettings& settings) {
+    while (next < events.size() && events[next].time <= untilTime) {
+        const InputEvent& event = events[next++];
+        switch (event.type) {
+        case InputEventType::WindowPos:
+            input.onWindowPos(event.time, event.x, event.y);
+            break;
+        case InputEventType::Spawn:
+            input.spawn(event.time, event.x, settings);
+            break;
+        case InputEventType::SpawnBatch:
+            input.spawnBatch(event.time, event.x, event.y, settings);
+            break;
+        case InputEventType::Clear:
+            input.clear(event.time, event.x != 0);
+            break;
+        case InputEventType::Settings:
+            settings = event.settings;
+            break;
+        case InputEventType::End:
+            break;
+        }
+    }
+}
+
+bool FrameTimingLog::open(const std::string& path) {
+    out.open(path);
+    if (!out.is_open()) {
+        std::cerr << "Cannot open timings file: " << path << std::endl;
+        return false;
+    }
+    out << "frame,physics_ms,render_ms\n";
+    return true;
+}
+
+void FrameTimingLog::add(int frame, double physicsMs, double renderMs) {
+    ++frames;
+    totalPhysicsMs += physicsMs;
+    totalRenderMs += renderMs;
+    if (out.is_open()) {
+        out << frame << ',' << physicsMs << ',' << renderMs << '\n';
+    }
+}
+
+void FrameTimingLog::close() {
+    if (out.is_open()) {
+        out.close();
+    }
+}
\ No newline at end of file
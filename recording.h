@@ -0,0 +1,91 @@
+#pragma once
+
+#include "physics_types.h"
+#include <fstream>
+#include <string>
+#include <vector>
+
+class SceneInput;
+
+// Запись пользовательского ввода для воспроизводимых замеров производительности.
+// Текстовый формат, одна строка на событие:
+//   wcp-record 1
+//   settings <t> key=value ...
+//   pos <t> <x> <y>
+//   spawn <t> <type>
+//   batch <t> <type> <count>
+//   clear <t> <releaseMemory>
+//   end <t>
+enum class InputEventType {
+    WindowPos,
+    Spawn,
+    SpawnBatch,
+    Clear,
+    Settings,
+    End
+};
+
+struct InputEvent {
+    double time = 0.0;
+    InputEventType type = InputEventType::End;
+    int x = 0; // WindowPos - позиция окна, Spawn и SpawnBatch - тип объекта, Clear - releaseMemory
+    int y = 0; // SpawnBatch - число тел
+    PhysicsSettings settings;
+};
+
+class InputRecorder {
+public:
+    bool open(const std::string& path);
+    bool isOpen() const { return out.is_open(); }
+
+    void recordWindowPos(double time, int xpos, int ypos);
+    void recordSpawn(double time, int type);
+    void recordSpawnBatch(double time, int type, int count);
+    void recordClear(double time, bool releaseMemory);
+    // Пишет настройки, только если они изменились с прошлой записи
+    void recordSettings(double time, const PhysicsSettings& settings);
+    void close(double time);
+
+private:
+    std::ofstream out;
+    std::string lastSettings;
+};
+
+class InputReplay {
+public:
+    bool load(const std::string& path);
+
+    const PhysicsSettings& getInitialSettings() const { return initialSettings; }
+    double getDuration() const { return duration; }
+    bool finished(double time) const { return next >= events.size() && time >= duration; }
+
+    // Передает в SceneInput все события с временем не больше untilTime
+    void feed(double untilTime, SceneInput& input, PhysicsSettings& settings);
+
+private:
+    std::vector<InputEvent> events;
+    PhysicsSettings initialSettings;
+    size_t next = 0;
+    double duration = 0.0;
+};
+
+// Покадровые замеры воспроизведения в CSV: frame,physics_ms,render_ms
+class FrameTimingLog {
+public:
+    bool open(const std::string& path);
+    void add(int frame, double physicsMs, double renderMs);
+    void close();
+
+    int getFrameCount() const { return frames; }
+    double getAveragePhysicsMs() const { return frames > 0 ? totalPhysicsMs / frames : 0.0; }
+    double getAverageRenderMs() const { return frames > 0 ? totalRenderMs / frames : 0.0; }
+
+private:
+    std::ofstream out;
+    int frames = 0;
+    double totalPhysicsMs = 0.0;
+    double totalRenderMs = 0.0;
+};
+
+std::string serializeSettings(const PhysicsSettings& settings);
+void parseSettings(const std::string& text, PhysicsSettings& settings);
\ No newline at end of file
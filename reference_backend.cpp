@@ -0,0 +1,172 @@
+#include "reference_backend.h"
+#include "physics_types.h"
+#include <algorithm>
+#include <cmath>
+
+static const float BODY_RADIUS = 0.5f;
+static const float BODY_MASS = 1.0f;
+static const float GRAVITY = -9.81f;
+static const float MAX_LINEAR_SPEED = 30.0f;
+
+// Стена: центр зажимается в [low, high], скорость в стену отражается
+static void collideWall(float& position, float& velocity, float low, float high, float restitution) {
+    if (position < low) {
+        position = low;
+        if (velocity < 0.0f) velocity = -velocity * restitution;
+    } else if (position > high) {
+        position = high;
+        if (velocity > 0.0f) velocity = -velocity * restitution;
+    }
+}
+
+ReferenceBackend::ReferenceBackend() {
+    high = BOUNDARY_INNER - BODY_RADIUS;
+    low = -high;
+}
+
+void ReferenceBackend::addBody(int type, float x, float y, float z) {
+    px.push_back(std::min(high, std::max(low, x)));
+    py.push_back(std::min(high, std::max(low, y)));
+    pz.push_back(std::min(high, std::max(low, z)));
+    vx.push_back(0.0f);
+    vy.push_back(0.0f);
+    vz.push_back(0.0f);
+    bodyTypes.push_back(type);
+}
+
+void ReferenceBackend::spawnBody(int type, const glm::vec3& position, const PhysicsSettings&) {
+    addBody(type, position.x, position.y, position.z);
+}
+
+size_t ReferenceBackend::spawnBatch(int type, size_t count, const PhysicsSettings&) {
+    // Решетка снизу вверх продолжается с места, где закончилась предыдущая:
+    // тела не сталкиваются друг с другом, поэтому пересечения не проверяются
+    const float spacing = BODY_RADIUS * (2.0f + SPAWN_GAP);
+    const size_t perAxis = static_cast<size_t>((high - low) / spacing) + 1;
+    const size_t capacity = perAxis * perAxis * perAxis;
+    const size_t first = bodyTypes.size();
+    const size_t last = std::min(capacity, first + count);
+
+    for (size_t site = first; site < last; ++site) {
+        size_t x = site % perAxis;
+        size_t z = (site / perAxis) % perAxis;
+        size_t y = site / (perAxis * perAxis);
+        addBody(type, low + x * spacing, low + y * spacing, low + z * spacing);
+    }
+    return last > first ? last - first : 0;
+}
+
+void ReferenceBackend::clear(bool releaseMemory) {
+    std::vector<float>* arrays[] = { &px, &py, &pz, &vx, &vy, &vz };
+    for (std::vector<float>* values : arrays) {
+        values->clear();
+        if (releaseMemory) values->shrink_to_fit();
+    }
+    bodyTypes.clear();
+    if (releaseMemory) bodyTypes.shrink_to_fit();
+}
+
+void ReferenceBackend::step(float stepTime, const PhysicsSettings& settings) {
+    const float damping = std::pow(std::max(0.0f, 1.0f - settings.damping), stepTime);
+    const float maxSpeedSq = MAX_LINEAR_SPEED * MAX_LINEAR_SPEED;
+    const float restitution = settings.restitution;
+
+    const size_t count = bodyTypes.size();
+    for (size_t i = 0; i < count; ++i) {
+        vy[i] += GRAVITY * stepTime;
+        vx[i] *= damping;
+        vy[i] *= damping;
+        vz[i] *= damping;
+
+        float speedSq = vx[i] * vx[i] + vy[i] * vy[i] + vz[i] * vz[i];
+        if (speedSq > maxSpeedSq) {
+            float scale = MAX_LINEAR_SPEED / std::sqrt(speedSq);
+            vx[i] *= scale;
+            vy[i] *= scale;
+            vz[i] *= scale;
+        }
+
+        px[i] += vx[i] * stepTime;
+        py[i] += vy[i] * stepTime;
+        pz[i] += vz[i] * stepTime;
+        collideWall(px[i], vx[i], low, high, restitution);
+        collideWall(py[i], vy[i], low, high, restitution);
+        collideWall(pz[i], vz[i], low, high, restitution);
+    }
+}
+
+void ReferenceBackend::readTransforms(float* positions, float* rotations, int* types) const {
+    const size_t count = bodyTypes.size();
+    for (size_t i = 0; i < count; ++i) {
+        if (positions) {
+            positions[i * 3 + 0] = px[i];
+            positions[i * 3 + 1] = py[i];
+            positions[i * 3 + 2] = pz[i];
+        }
+        if (rotations) {
+            rotations[i * 4 + 0] = 0.0f;
+            rotations[i * 4 + 1] = 0.0f;
+            rotations[i * 4 + 2] = 0.0f;
+            rotations[i * 4 + 3] = 1.0f;
+        }
+        if (types) {
+            types[i] = bodyTypes[i];
+        }
+    }
+}
+
+void ReferenceBackend::applyImpulse(size_t body, const glm::vec3& impulse) {
+    if (body >= bodyTypes.size()) return;
+    vx[body] += impulse.x / BODY_MASS;
+    vy[body] += impulse.y / BODY_MASS;
+    vz[body] += impulse.z / BODY_MASS;
+}
+
+void ReferenceBackend::applyShake(const glm::vec2& windowVelocity, const PhysicsSettings& settings) {
+    // Линейная часть импульса PhysicsWorld::applyForceToAll
+    const float scale = settings.forceScale * 300.0f / BODY_MASS;
+    const float dx = windowVelocity.x * settings.horizontalScale * scale;
+    const float dy = -windowVelocity.y * settings.verticalScale * scale;
+    const float dz = windowVelocity.y * settings.zScale * scale;
+    for (size_t i = 0; i < bodyTypes.size(); ++i) {
+        vx[i] += dx;
+        vy[i] += dy;
+        vz[i] += dz;
+    }
+}
+
+bool ReferenceBackend::raycast(const glm::vec3& from, const glm::vec3& to, RayHit& hit) const {
+    const glm::vec3 d = to - from;
+    const float a = glm::dot(d, d);
+    if (a <= 0.0f) return false;
+
+    bool found = false;
+    float best = 1.0f;
+    for (size_t i = 0; i < bodyTypes.size(); ++i) {
+        const glm::vec3 m = from - glm::vec3(px[i], py[i], pz[i]);
+        const float b = glm::dot(m, d);
+        const float c = glm::dot(m, m) - BODY_RADIUS * BODY_RADIUS;
+        if (c > 0.0f && b > 0.0f) continue;
+        const float discriminant = b * b - a * c;
+        if (discriminant < 0.0f) continue;
+        const float t = std::max(0.0f, (-b - std::sqrt(discriminant)) / a);
+        if (t <= best) {
+            best = t;
+            hit.body = i;
+            found = true;
+        }
+    }
+    if (!found) return false;
+
+    hit.fraction = best;
+    hit.point = from + d * best;
+    glm::vec3 outward = hit.point - glm::vec3(px[hit.body], py[hit.body], pz[hit.body]);
+    float length = glm::length(outward);
+    hit.normal = length > 0.0f ? outward / length : glm::vec3(0.0f, 1.0f, 0.0f);
+    return true;
+}
+
+size_t ReferenceBackend::getMemoryUsage() const {
+    size_t floats = px.capacity() + py.capacity() + pz.capacity() + vx.capacity() + vy.capacity() + vz.capacity();
+    return floats * sizeof(float) + bodyTypes.capacity() * sizeof(int);
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "physics_backend.h"
+#include <vector>
+
+// Эталонный интегратор: полунеявный Эйлер с гравитацией, затуханием, пределом
+// скорости и аналитическими стенами. Контактов между телами нет - это нижняя
+// граница времени шага, с которой сравниваются настоящие движки. Любое тело -
+// шар радиуса 0.5, без вращения.
+class ReferenceBackend : public PhysicsBackend {
+public:
+    ReferenceBackend();
+
+    const char* getName() const override { return "reference"; }
+
+    void spawnBody(int type, const glm::vec3& position, const PhysicsSettings& settings) override;
+    size_t spawnBatch(int type, size_t count, const PhysicsSettings& settings) override;
+    void clear(bool releaseMemory) override;
+    void step(float stepTime, const PhysicsSettings& settings) override;
+
+    size_t getBodyCount() const override { return bodyTypes.size(); }
+    void readTransforms(float* positions, float* rotations, int* types) const override;
+
+    void applyImpulse(size_t body, const glm::vec3& impulse) override;
+    void applyShake(const glm::vec2& windowVelocity, const PhysicsSettings& settings) override;
+
+    bool raycast(const glm::vec3& from, const glm::vec3& to, RayHit& hit) const override;
+
+    size_t getMemoryUsage() const override;
+
+private:
+    void addBody(int type, float x, float y, float z);
+
+    float low;  // границы центров тел по каждой оси
+    float high;
+    std::vector<float> px, py, pz;
+    std::vector<float> vx, vy, vz;
+    std::vector<int> bodyTypes;
+};
\ No newline at end of file
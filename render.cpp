@@ -1,4 +1,5 @@
 #include "render.h"
+#include <algorithm>
 #define _USE_MATH_DEFINES
 #include <math.h>
 
@@ -157,24 +158,8 @@ Meshes createMeshes() {
     return meshes;
 }
 
-void Renderer::renderPhysicsObject(const PhysicsObject& obj, GLuint shaderProgram, 
-    const Meshes& meshes, const glm::mat4& view, const glm::mat4& projection, 
-    const Camera& camera) {
-    // Включаем тест глубины
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LESS);
-    
-    // Отключаем смешивание (если оно было включено)
-    glDisable(GL_BLEND);
-
-    btTransform trans;
-    obj.rigidBody->getMotionState()->getWorldTransform(trans);
-
-    glm::mat4 model;
-    trans.getOpenGLMatrix(glm::value_ptr(model));
-
+void Renderer::setSceneUniforms(GLuint shaderProgram, const glm::mat4& view, const glm::mat4& projection, const Camera& camera) {
     glUseProgram(shaderProgram);
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
     glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(view));
     glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
 
@@ -186,26 +171,87 @@ void Renderer::renderPhysicsObject(const PhysicsObject& obj, GLuint shaderProgra
     glUniform3fv(glGetUniformLocation(shaderProgram, "lightPos"), 1, glm::value_ptr(lightPos));
     glUniform3fv(glGetUniformLocation(shaderProgram, "lightColor"), 1, glm::value_ptr(lightColor));
     glUniform3fv(glGetUniformLocation(shaderProgram, "viewPos"), 1, glm::value_ptr(viewPos));
-    glUniform3fv(glGetUniformLocation(shaderProgram, "cubeColor"), 1, glm::value_ptr(obj.color));
-
-    // Выбираем нужный меш в зависимости от типа объекта
-    const Mesh* currentMesh;
-    switch(obj.type) {
-        case 0:
-            currentMesh = &meshes.cube;
-            break;
-        case 1:
-            currentMesh = &meshes.sphere;
-            break;
-        case 2:
-            currentMesh = &meshes.cylinder;
-            break;
-        default:
-            currentMesh = &meshes.cube;
+}
+
+void Renderer::createInstanceBuffers(InstanceBuffers& buffers) {
+    glGenBuffers(1, &buffers.positionVBO);
+    glGenBuffers(1, &buffers.rotationVBO);
+    glGenBuffers(1, &buffers.colorVBO);
+    buffers.capacity = 0;
+}
+
+void Renderer::deleteInstanceBuffers(InstanceBuffers& buffers) {
+    glDeleteBuffers(1, &buffers.positionVBO);
+    glDeleteBuffers(1, &buffers.rotationVBO);
+    glDeleteBuffers(1, &buffers.colorVBO);
+    buffers = InstanceBuffers();
+}
+
+static void uploadInstanceArray(GLuint vbo, const float* data, size_t floats, bool grow, size_t capacityFloats) {
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    if (grow) {
+        glBufferData(GL_ARRAY_BUFFER, capacityFloats * sizeof(float), nullptr, GL_STREAM_DRAW);
     }
+    glBufferSubData(GL_ARRAY_BUFFER, 0, floats * sizeof(float), data);
+}
+
+void Renderer::uploadInstances(InstanceBuffers& buffers, const float* positions, const float* rotations,
+    const float* colors, size_t count) {
+    if (count == 0) return;
+
+    // Буферы только растут, чтобы не пересоздавать их каждый кадр
+    bool grow = count > buffers.capacity;
+    if (grow) {
+        buffers.capacity = std::max(count, buffers.capacity * 2);
+    }
+    uploadInstanceArray(buffers.positionVBO, positions, count * 3, grow, buffers.capacity * 3);
+    uploadInstanceArray(buffers.rotationVBO, rotations, count * 4, grow, buffers.capacity * 4);
+    uploadInstanceArray(buffers.colorVBO, colors, count * 3, grow, buffers.capacity * 3);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+static void bindInstanceAttribute(GLuint location, GLuint vbo, int components, size_t first) {
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glVertexAttribPointer(location, components, GL_FLOAT, GL_FALSE, components * sizeof(float),
+        (void*)(first * components * sizeof(float)));
+    glEnableVertexAttribArray(location);
+    glVertexAttribDivisor(location, 1);
+}
 
-    glBindVertexArray(currentMesh->VAO);
-    glDrawElements(GL_TRIANGLES, currentMesh->indexCount, GL_UNSIGNED_INT, 0);
+void Renderer::renderInstances(const InstanceBuffers& buffers, const std::vector<InstanceRange>& ranges,
+    GLuint shaderProgram, const Meshes& meshes, const glm::mat4& view, const glm::mat4& projection,
+    const Camera& camera) {
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LESS);
+    glDisable(GL_BLEND);
+
+    setSceneUniforms(shaderProgram, view, projection, camera);
+
+    for (const auto& range : ranges) {
+        if (range.count == 0) continue;
+
+        // Выбираем нужный меш в зависимости от типа объекта
+        const Mesh* currentMesh;
+        switch(range.type) {
+            case 1:
+                currentMesh = &meshes.sphere;
+                break;
+            case 2:
+                currentMesh = &meshes.cylinder;
+                break;
+            default:
+                currentMesh = &meshes.cube;
+        }
+
+        // Атрибуты экземпляров указывают прямо на начало диапазона в буферах
+        glBindVertexArray(currentMesh->VAO);
+        bindInstanceAttribute(2, buffers.positionVBO, 3, range.first);
+        bindInstanceAttribute(3, buffers.rotationVBO, 4, range.first);
+        bindInstanceAttribute(4, buffers.colorVBO, 3, range.first);
+        glUniform1f(glGetUniformLocation(shaderProgram, "instanceScale"), range.scale);
+        glDrawElementsInstanced(GL_TRIANGLES, currentMesh->indexCount, GL_UNSIGNED_INT, 0, static_cast<GLsizei>(range.count));
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 Mesh Renderer::createSphere(int latitudes, int longitudes) {
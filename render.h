@@ -6,6 +6,8 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include "camera.h"
+#include "instances.h"
+#include <vector>
 
 struct Meshes {
     Mesh cube;
@@ -13,6 +15,13 @@ struct Meshes {
     Mesh cylinder;
 };
 
+struct InstanceBuffers {
+    GLuint positionVBO = 0;
+    GLuint rotationVBO = 0;
+    GLuint colorVBO = 0;
+    size_t capacity = 0;
+};
+
 class Renderer {
 public:
     static GLuint createShaderProgram(const char* vertexSource, const char* fragmentSource);
@@ -21,7 +30,14 @@ public:
     static Mesh createSphere(int latitudes, int longitudes);
     static Mesh createCylinder(int segments);
     static void renderSkybox(GLuint skyboxVAO, GLuint skyboxShader, const glm::mat4& view, const glm::mat4& projection);
-    static void renderPhysicsObject(const PhysicsObject& obj, GLuint shaderProgram, 
-        const Meshes& meshes, const glm::mat4& view, const glm::mat4& projection, 
+    static void setSceneUniforms(GLuint shaderProgram, const glm::mat4& view, const glm::mat4& projection, const Camera& camera);
+
+    // Экземплярный рендер: один вызов отрисовки на диапазон тел одного типа
+    static void createInstanceBuffers(InstanceBuffers& buffers);
+    static void deleteInstanceBuffers(InstanceBuffers& buffers);
+    static void uploadInstances(InstanceBuffers& buffers, const float* positions, const float* rotations,
+        const float* colors, size_t count);
+    static void renderInstances(const InstanceBuffers& buffers, const std::vector<InstanceRange>& ranges,
+        GLuint shaderProgram, const Meshes& meshes, const glm::mat4& view, const glm::mat4& projection,
         const Camera& camera);
 };
\ No newline at end of file
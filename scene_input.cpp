@@ -0,0 +1,137 @@
+#include "scene_input.h"
+#include "physics_backend.h"
+#include "recording.h"
+
+static btVector3 toBullet(const glm::vec3& v) {
+    return btVector3(v.x, v.y, v.z);
+}
+
+SceneInput::SceneInput(PhysicsThread& physicsThread)
+    : physicsThread(&physicsThread)
+    , backend(&physicsThread.getBackend())
+    , recorder(nullptr)
+    , objectCount(0)
+    , lastWindowPos(0.0, 0.0)
+    , windowVelocity(0.0, 0.0)
+    , firstMove(true)
+    , windowMoved(false) {
+}
+
+SceneInput::SceneInput(PhysicsBackend& backend)
+    : physicsThread(nullptr)
+    , backend(&backend)
+    , recorder(nullptr)
+    , objectCount(0)
+    , lastWindowPos(0.0, 0.0)
+    , windowVelocity(0.0, 0.0)
+    , firstMove(true)
+    , windowMoved(false) {
+}
+
+void SceneInput::apply(std::function<void(PhysicsBackend&)> action) {
+    if (!physicsThread) {
+        action(*backend);
+        return;
+    }
+    PhysicsBackend* target = backend;
+    physicsThread->post([target, action](PhysicsWorld&, std::vector<PhysicsObject>&) {
+        action(*target);
+    });
+}
+
+void SceneInput::onWindowPos(double time, int xpos, int ypos) {
+    if (recorder) {
+        recorder->recordWindowPos(time, xpos, ypos);
+    }
+
+    if (objectCount > 0) {
+        if (!firstMove) {
+            windowVelocity = glm::dvec2(xpos - lastWindowPos.x, ypos - lastWindowPos.y);
+            windowMoved = true;
+        }
+        lastWindowPos = glm::dvec2(xpos, ypos);
+        firstMove = false;
+    }
+}
+
+void SceneInput::spawn(double time, int type, const PhysicsSettings& settings) {
+    if (recorder) {
+        recorder->recordSettings(time, settings);
+        recorder->recordSpawn(time, type);
+    }
+
+    apply([type, settings](PhysicsBackend& backend) {
+        backend.spawnBody(type, glm::vec3(0.0f, 2.0f, 0.0f), settings);
+    });
+}
+
+void SceneInput::spawnBatch(double time, int type, int count, const PhysicsSettings& settings) {
+    if (recorder) {
+        recorder->recordSettings(time, settings);
+        recorder->recordSpawnBatch(time, type, count);
+    }
+
+    apply([type, count, settings](PhysicsBackend& backend) {
+        backend.spawnBatch(type, static_cast<size_t>(count), settings);
+    });
+}
+
+void SceneInput::clear(double time, bool releaseMemory) {
+    if (recorder) {
+        recorder->recordClear(time, releaseMemory);
+    }
+
+    apply([releaseMemory](PhysicsBackend& backend) {
+        backend.clear(releaseMemory);
+    });
+}
+
+void SceneInput::flush(double time, const PhysicsSettings& settings) {
+    if (recorder) {
+        recorder->recordSettings(time, settings);
+    }
+
+    // Применение сил к объектам
+    if (objectCount > 0 && glm::length(windowVelocity) > 0.1) {
+        glm::vec2 velocity(windowVelocity);
+        apply([velocity, settings](PhysicsBackend& backend) {
+            backend.applyShake(velocity, settings);
+        });
+        windowVelocity = glm::dvec2(0.0, 0.0); // Сбрасываем скорость после применения
+    } else if (windowMoved) {
+        // Даже медленное движение окна сдвигает коробку - будим уснувшие тела
+        apply([](PhysicsBackend& backend) {
+            backend.wakeAll();
+        });
+    }
+    windowMoved = false;
+    // Движок получает настройки с каждым шагом от вызывающего кода
+    if (physicsThread) {
+        physicsThread->setSettings(settings);
+    }
+}
+
+void SceneInput::beginDrag(const glm::vec3& from, const glm::vec3& to) {
+    if (!physicsThread) return;
+    btVector3 rayFrom = toBullet(from);
+    btVector3 rayTo = toBullet(to);
+    physicsThread->post([rayFrom, rayTo](PhysicsWorld& world, std::vector<PhysicsObject>&) {
+        world.beginDrag(rayFrom, rayTo);
+    });
+}
+
+void SceneInput::updateDrag(const glm::vec3& from, const glm::vec3& to) {
+    if (!physicsThread) return;
+    btVector3 rayFrom = toBullet(from);
+    btVector3 rayTo = toBullet(to);
+    physicsThread->post([rayFrom, rayTo](PhysicsWorld& world, std::vector<PhysicsObject>&) {
+        world.updateDrag(rayFrom, rayTo);
+    });
+}
+
+void SceneInput::endDrag() {
+    if (!physicsThread) return;
+    physicsThread->post([](PhysicsWorld& world, std::vector<PhysicsObject>&) {
+        world.endDrag();
+    });
+}
\ No newline at end of file
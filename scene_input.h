@@ -0,0 +1,49 @@
+#pragma once
+
+#include "physics_thread.h"
+#include <glm/glm.hpp>
+#include <functional>
+
+class InputRecorder;
+class PhysicsBackend;
+
+// Единая точка входа для действий пользователя: движение окна, создание и
+// очистка объектов. Через нее идут и живой ввод, и воспроизведение записи,
+// поэтому оба пути порождают одинаковые команды для потока физики.
+// Действия идут через интерфейс PhysicsBackend: с потоком - командой к его
+// движку Bullet, без потока - сразу к движку на вызывающем потоке.
+class SceneInput {
+public:
+    explicit SceneInput(PhysicsThread& physicsThread);
+    explicit SceneInput(PhysicsBackend& backend);
+
+    void setRecorder(InputRecorder* recorder) { this->recorder = recorder; }
+    // Число тел в последнем снимке: без тел движение окна игнорируется
+    void setObjectCount(size_t count) { objectCount = count; }
+
+    void onWindowPos(double time, int xpos, int ypos);
+    void spawn(double time, int type, const PhysicsSettings& settings);
+    void spawnBatch(double time, int type, int count, const PhysicsSettings& settings);
+    void clear(double time, bool releaseMemory);
+    // Конец кадра: встряска или пробуждение тел и передача настроек физике
+    void flush(double time, const PhysicsSettings& settings);
+
+    // Перетаскивание тела мышью по лучу from-to из камеры. В запись не попадает;
+    // движки без тел Bullet перетаскивание не поддерживают
+    void beginDrag(const glm::vec3& from, const glm::vec3& to);
+    void updateDrag(const glm::vec3& from, const glm::vec3& to);
+    void endDrag();
+
+private:
+    void apply(std::function<void(PhysicsBackend&)> action);
+
+    PhysicsThread* physicsThread; // nullptr, если движок шагает вызывающий поток
+    PhysicsBackend* backend;
+    InputRecorder* recorder;
+    size_t objectCount;
+
+    glm::dvec2 lastWindowPos;
+    glm::dvec2 windowVelocity;
+    bool firstMove;
+    bool windowMoved;
+};
\ No newline at end of file
@@ -0,0 +1,154 @@
+#include "scene_map.h"
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static uint64_t alignOffset(uint64_t offset) {
+    return (offset + SCENE_MAP_ALIGNMENT - 1) & ~(SCENE_MAP_ALIGNMENT - 1);
+}
+
+void computeSceneMapLayout(uint32_t bodyCount, uint32_t archetypeCount, SceneMapHeader& header) {
+    std::memcpy(header.magic, SCENE_MAP_MAGIC, sizeof(header.magic));
+    header.version = SCENE_MAP_VERSION;
+    header.bodyCount = bodyCount;
+    header.archetypeCount = archetypeCount;
+
+    const uint64_t n = bodyCount;
+    uint64_t offset = alignOffset(sizeof(SceneMapHeader));
+    header.archetypeOffset = offset;
+    offset = alignOffset(offset + archetypeCount * sizeof(SceneMapArchetype));
+    header.positionOffset = offset;
+    offset = alignOffset(offset + n * 3 * sizeof(float));
+    header.rotationOffset = offset;
+    offset = alignOffset(offset + n * 4 * sizeof(float));
+    header.linearVelocityOffset = offset;
+    offset = alignOffset(offset + n * 3 * sizeof(float));
+    header.angularVelocityOffset = offset;
+    offset = alignOffset(offset + n * 3 * sizeof(float));
+    header.activationStateOffset = offset;
+    offset = alignOffset(offset + n * sizeof(int32_t));
+    header.deactivationTimeOffset = offset;
+    offset = alignOffset(offset + n * sizeof(float));
+    header.colorOffset = offset;
+    header.fileSize = offset + n * 3 * sizeof(float);
+}
+
+MappedScene::MappedScene()
+    : data(nullptr)
+    , size(0)
+#ifdef _WIN32
+    , fileHandle(nullptr)
+    , mappingHandle(nullptr)
+#endif
+{
+}
+
+MappedScene::~MappedScene() {
+    close();
+}
+
+bool MappedScene::open(const std::string& path) {
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        std::cerr << "Cannot open scene file: " << path << std::endl;
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(file, &fileSize);
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view) {
+        if (mapping) CloseHandle(mapping);
+        CloseHandle(file);
+        std::cerr << "Cannot map scene file: " << path << std::endl;
+        return false;
+    }
+    fileHandle = file;
+    mappingHandle = mapping;
+    data = view;
+    size = static_cast<size_t>(fileSize.QuadPart);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Cannot open scene file: " << path << std::endl;
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        ::close(fd);
+        std::cerr << "Cannot open scene file: " << path << std::endl;
+        return false;
+    }
+    void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    // Отображение держит файл само, дескриптор больше не нужен
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        std::cerr << "Cannot map scene file: " << path << std::endl;
+        return false;
+    }
+    // Массивы читаются подряд один раз - просим ядро читать вперед
+    madvise(view, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+    data = view;
+    size = static_cast<size_t>(info.st_size);
+#endif
+
+    if (!validate()) {
+        std::cerr << "Unsupported or corrupted scene file: " << path << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedScene::close() {
+    if (!data) return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+    CloseHandle(static_cast<HANDLE>(mappingHandle));
+    CloseHandle(static_cast<HANDLE>(fileHandle));
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+#else
+    munmap(data, size);
+#endif
+    data = nullptr;
+    size = 0;
+}
+
+bool MappedScene::validate() const {
+    if (size < sizeof(SceneMapHeader)) return false;
+
+    const SceneMapHeader* h = header();
+    if (std::memcmp(h->magic, SCENE_MAP_MAGIC, sizeof(h->magic)) != 0 || h->version != SCENE_MAP_VERSION) {
+        return false;
+    }
+
+    // Смещения должны совпадать с раскладкой, которую пишет сохранение
+    SceneMapHeader expected;
+    computeSceneMapLayout(h->bodyCount, h->archetypeCount, expected);
+    if (std::memcmp(&expected, h, sizeof(SceneMapHeader)) != 0 || h->fileSize > size) {
+        return false;
+    }
+
+    const SceneMapArchetype* archetypes = getArchetypes();
+    for (uint32_t i = 0; i < h->archetypeCount; ++i) {
+        if (archetypes[i].firstBody > h->bodyCount || archetypes[i].bodyCount > h->bodyCount - archetypes[i].firstBody) {
+            return false;
+        }
+    }
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Плоский формат сцены для отображения в память. После заголовка идут
+// таблица архетипов и массивы по телам, каждый выровнен на SCENE_MAP_ALIGNMENT:
+//   positions        float[3 * N]
+//   rotations        float[4 * N]  кватернион x, y, z, w
+//   linearVelocity   float[3 * N]
+//   angularVelocity  float[3 * N]
+//   activationStates int32[N]      состояние сна Bullet
+//   deactivationTime float[N]
+//   colors           float[3 * N]
+// Тела отсортированы по архетипу, так что каждый архетип - непрерывный
+// диапазон, который можно создать одним проходом и нарисовать одним вызовом.
+// Архетип тела определяется диапазоном, отдельный массив индексов не нужен.
+const char SCENE_MAP_MAGIC[4] = { 'W', 'C', 'P', 'M' };
+const uint32_t SCENE_MAP_VERSION = 2;
+const uint64_t SCENE_MAP_ALIGNMENT = 64;
+
+struct SceneMapHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t bodyCount;
+    uint32_t archetypeCount;
+    uint64_t archetypeOffset;
+    uint64_t positionOffset;
+    uint64_t rotationOffset;
+    uint64_t linearVelocityOffset;
+    uint64_t angularVelocityOffset;
+    uint64_t activationStateOffset;
+    uint64_t deactivationTimeOffset;
+    uint64_t colorOffset;
+    uint64_t fileSize;
+};
+
+// Заполняет смещения массивов и размер файла для заданного числа тел и архетипов
+void computeSceneMapLayout(uint32_t bodyCount, uint32_t archetypeCount, SceneMapHeader& header);
+
+// Форма, масса и материал, общие для диапазона тел
+struct SceneMapArchetype {
+    int32_t proxyType;
+    float dimensions[3];
+    int32_t type; // тип объекта для рендера: 0 - куб, 1 - сфера, 2 - цилиндр
+    float mass;
+    float friction;
+    float restitution;
+    float rollingFriction;
+    float spinningFriction;
+    float linearDamping;
+    float angularDamping;
+    float ccdMotionThreshold;
+    float ccdSweptSphereRadius;
+    uint32_t firstBody;
+    uint32_t bodyCount;
+};
+
+// Файл сцены, отображенный в память только для чтения. Массивы читаются
+// напрямую из отображения, без разбора и промежуточных копий.
+class MappedScene {
+public:
+    MappedScene();
+    ~MappedScene();
+
+    MappedScene(const MappedScene&) = delete;
+    MappedScene& operator=(const MappedScene&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return data != nullptr; }
+
+    uint32_t getBodyCount() const { return header()->bodyCount; }
+    uint32_t getArchetypeCount() const { return header()->archetypeCount; }
+    const SceneMapArchetype* getArchetypes() const { return at<SceneMapArchetype>(header()->archetypeOffset); }
+    const float* getPositions() const { return at<float>(header()->positionOffset); }
+    const float* getRotations() const { return at<float>(header()->rotationOffset); }
+    const float* getLinearVelocities() const { return at<float>(header()->linearVelocityOffset); }
+    const float* getAngularVelocities() const { return at<float>(header()->angularVelocityOffset); }
+    const int32_t* getActivationStates() const { return at<int32_t>(header()->activationStateOffset); }
+    const float* getDeactivationTimes() const { return at<float>(header()->deactivationTimeOffset); }
+    const float* getColors() const { return at<float>(header()->colorOffset); }
+
+private:
+    const SceneMapHeader* header() const { return static_cast<const SceneMapHeader*>(data); }
+
+    template <typename T>
+    const T* at(uint64_t offset) const {
+        return reinterpret_cast<const T*>(static_cast<const char*>(data) + offset);
+    }
+
+    bool validate() const;
+
+    void* data;
+    size_t size;
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#endif
+};
\ No newline at end of file
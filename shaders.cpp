@@ -57,6 +57,72 @@ void main()
 }
 )";
 
+// Экземпляры: позиция, кватернион и цвет приходят из буферов экземпляров,
+// матрица модели не нужна - масштаб общий на диапазон и равномерный, поэтому
+// нормали просто поворачиваются
+const char* instancedVertexShaderSource = R"(
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec3 aOffset;
+layout (location = 3) in vec4 aRotation;
+layout (location = 4) in vec3 aColor;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform float instanceScale;
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec3 Color;
+
+vec3 rotate(vec4 q, vec3 v)
+{
+    return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+void main()
+{
+    FragPos = rotate(aRotation, aPos * instanceScale) + aOffset;
+    Normal = rotate(aRotation, aNormal);
+    Color = aColor;
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
+)";
+
+const char* instancedFragmentShaderSource = R"(
+#version 330 core
+in vec3 FragPos;
+in vec3 Normal;
+in vec3 Color;
+
+uniform vec3 lightPos;
+uniform vec3 viewPos;
+uniform vec3 lightColor;
+
+out vec4 FragColor;
+
+void main()
+{
+    float ambientStrength = 0.2;
+    vec3 ambient = ambientStrength * lightColor;
+
+    vec3 norm = normalize(Normal);
+    vec3 lightDir = normalize(lightPos - FragPos);
+    float diff = max(dot(norm, lightDir), 0.0);
+    vec3 diffuse = diff * lightColor;
+
+    float specularStrength = 0.5;
+    vec3 viewDir = normalize(viewPos - FragPos);
+    vec3 reflectDir = reflect(-lightDir, norm);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32.0);
+    vec3 specular = specularStrength * spec * lightColor;
+
+    vec3 result = (ambient + diffuse + specular) * Color;
+    FragColor = vec4(result, 1.0);
+}
+)";
+
 const char* skyboxVertexShaderSource = R"(
 #version 330 core
 layout (location = 0) in vec3 aPos;
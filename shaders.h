@@ -2,5 +2,7 @@
 
 extern const char* vertexShaderSource;
 extern const char* fragmentShaderSource;
+extern const char* instancedVertexShaderSource;
+extern const char* instancedFragmentShaderSource;
 extern const char* skyboxVertexShaderSource;
 extern const char* skyboxFragmentShaderSource;
\ No newline at end of file
@@ -0,0 +1,108 @@
+#include "shape_cache.h"
+#include <tuple>
+
+bool ShapeCache::Key::operator<(const Key& other) const {
+    return std::tie(proxyType, x, y, z) < std::tie(other.proxyType, other.x, other.y, other.z);
+}
+
+ShapeCache::~ShapeCache() {
+    clear();
+}
+
+btCollisionShape* ShapeCache::acquire(int proxyType, const btVector3& dimensions, int references) {
+    Key key = { proxyType, dimensions.x(), dimensions.y(), dimensions.z() };
+    auto it = entries.find(key);
+    if (it != entries.end()) {
+        it->second.refCount += references;
+        return it->second.shape;
+    }
+
+    btCollisionShape* shape = nullptr;
+    btScalar innerRadius = 0;
+    switch (proxyType) {
+        case BOX_SHAPE_PROXYTYPE:
+            shape = new btBoxShape(dimensions);
+            innerRadius = dimensions[dimensions.minAxis()];
+            break;
+        case SPHERE_SHAPE_PROXYTYPE:
+            shape = new btSphereShape(dimensions.x());
+            innerRadius = dimensions.x();
+            break;
+        case CONE_SHAPE_PROXYTYPE:
+            shape = new btConeShape(dimensions.x(), dimensions.y());
+            // Вписанная сфера конуса: r * h / (r + sqrt(r^2 + h^2))
+            innerRadius = dimensions.x() * dimensions.y()
+                / (dimensions.x() + btSqrt(dimensions.x() * dimensions.x() + dimensions.y() * dimensions.y()));
+            break;
+        case CYLINDER_SHAPE_PROXYTYPE:
+            shape = new btCylinderShape(dimensions);
+            innerRadius = btMin(dimensions.x(), dimensions.y());
+            break;
+        default:
+            return nullptr;
+    }
+
+    Entry entry;
+    entry.key = key;
+    entry.shape = shape;
+    entry.innerRadius = innerRadius;
+    entry.refCount = references;
+    shape->calculateLocalInertia(1.0f, entry.unitInertia);
+
+    it = entries.emplace(key, entry).first;
+    // Узлы map не перемещаются, поэтому форма может хранить указатель на свою запись
+    shape->setUserPointer(&it->second);
+    return shape;
+}
+
+void ShapeCache::release(btCollisionShape* shape) {
+    if (!shape) return;
+
+    Entry* entry = static_cast<Entry*>(shape->getUserPointer());
+    if (!entry || entry->shape != shape) return;
+
+    if (--entry->refCount == 0) {
+        Key key = entry->key;
+        delete shape;
+        entries.erase(key);
+    }
+}
+
+btVector3 ShapeCache::getLocalInertia(const btCollisionShape* shape, btScalar mass) const {
+    // Инерция тела пропорциональна массе, поэтому хватает значения для единичной
+    const Entry* entry = static_cast<const Entry*>(shape->getUserPointer());
+    if (!entry || entry->shape != shape) {
+        btVector3 inertia(0, 0, 0);
+        shape->calculateLocalInertia(mass, inertia);
+        return inertia;
+    }
+    return entry->unitInertia * mass;
+}
+
+btScalar ShapeCache::getInnerRadius(const btCollisionShape* shape) const {
+    const Entry* entry = static_cast<const Entry*>(shape->getUserPointer());
+    if (!entry || entry->shape != shape) {
+        // Форма не из кэша - грубая оценка по описанной сфере
+        btVector3 center;
+        btScalar radius;
+        shape->getBoundingSphere(center, radius);
+        return radius * 0.5f;
+    }
+    return entry->innerRadius;
+}
+
+bool ShapeCache::describe(const btCollisionShape* shape, int& proxyType, btVector3& dimensions) const {
+    const Entry* entry = static_cast<const Entry*>(shape->getUserPointer());
+    if (!entry || entry->shape != shape) return false;
+
+    proxyType = entry->key.proxyType;
+    dimensions.setValue(entry->key.x, entry->key.y, entry->key.z);
+    return true;
+}
+
+void ShapeCache::clear() {
+    for (auto& pair : entries) {
+        delete pair.second.shape;
+    }
+    entries.clear();
+}
\ No newline at end of file
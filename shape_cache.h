@@ -0,0 +1,47 @@
+#pragma once
+
+#include <bullet/btBulletDynamicsCommon.h>
+#include <map>
+
+// Общие формы столкновений: все объекты одного типа и размера используют
+// один экземпляр формы, инерция для единичной массы считается один раз
+class ShapeCache {
+public:
+    ShapeCache() = default;
+    ~ShapeCache();
+
+    ShapeCache(const ShapeCache&) = delete;
+    ShapeCache& operator=(const ShapeCache&) = delete;
+
+    // Размеры: бокс и цилиндр - половины сторон, сфера - (радиус, 0, 0),
+    // конус - (радиус, высота, 0). references - сколько раз форма будет
+    // освобождена через release, для пакетного создания тел одной формы
+    btCollisionShape* acquire(int proxyType, const btVector3& dimensions, int references = 1);
+    void release(btCollisionShape* shape);
+    btVector3 getLocalInertia(const btCollisionShape* shape, btScalar mass) const;
+    // Радиус вписанной сферы: насколько тело может сместиться за шаг, не пропустив стену
+    btScalar getInnerRadius(const btCollisionShape* shape) const;
+    // Тип и размеры формы из кэша, по которым ее можно получить снова через acquire
+    bool describe(const btCollisionShape* shape, int& proxyType, btVector3& dimensions) const;
+
+    size_t size() const { return entries.size(); }
+    void clear();
+
+private:
+    struct Key {
+        int proxyType;
+        btScalar x, y, z;
+
+        bool operator<(const Key& other) const;
+    };
+
+    struct Entry {
+        Key key;
+        btCollisionShape* shape;
+        btVector3 unitInertia;
+        btScalar innerRadius;
+        int refCount;
+    };
+
+    std::map<Key, Entry> entries;
+};
\ No newline at end of file
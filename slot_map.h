@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Ручка элемента слот-карты: номер слота и поколение. После удаления элемента
+// поколение слота растет, и все старые ручки на него становятся устаревшими.
+struct SlotHandle {
+    static const uint32_t INVALID_SLOT = 0xFFFFFFFFu;
+
+    uint32_t slot = INVALID_SLOT;
+    uint32_t generation = 0;
+
+    bool isValid() const { return slot != INVALID_SLOT; }
+    bool operator==(const SlotHandle& other) const { return slot == other.slot && generation == other.generation; }
+    bool operator!=(const SlotHandle& other) const { return !(*this == other); }
+};
+
+// Ручка тела мира физики
+using BodyHandle = SlotHandle;
+
+// Слот-карта: элементы лежат плотным массивом, ручка ведет через слот к
+// индексу в нем. Вставка в конец и удаление перестановкой с последним за O(1),
+// обход - по плотному массиву без пропусков. Устаревшая ручка не находит ничего.
+template <typename T>
+class SlotMap {
+public:
+    SlotHandle insert(const T& value) {
+        uint32_t slot;
+        if (!freeSlots.empty()) {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        } else {
+            slot = static_cast<uint32_t>(slots.size());
+            slots.push_back(Slot());
+        }
+        slots[slot].index = static_cast<uint32_t>(values.size());
+        values.push_back(value);
+        valueSlots.push_back(slot);
+
+        SlotHandle handle;
+        handle.slot = slot;
+        handle.generation = slots[slot].generation;
+        return handle;
+    }
+
+    // Последний элемент переезжает на место удаленного, его ручка остается верной
+    void removeAt(size_t index) {
+        uint32_t slot = valueSlots[index];
+        size_t last = values.size() - 1;
+        if (index != last) {
+            values[index] = values[last];
+            valueSlots[index] = valueSlots[last];
+            slots[valueSlots[index]].index = static_cast<uint32_t>(index);
+        }
+        values.pop_back();
+        valueSlots.pop_back();
+        freeSlot(slot);
+    }
+
+    bool remove(SlotHandle handle) {
+        int index = indexOf(handle);
+        if (index < 0) return false;
+        removeAt(static_cast<size_t>(index));
+        return true;
+    }
+
+    // Индекс в плотном массиве или -1 для устаревшей ручки
+    int indexOf(SlotHandle handle) const {
+        if (handle.slot >= slots.size()) return -1;
+        const Slot& slot = slots[handle.slot];
+        if (slot.generation != handle.generation || slot.index == FREE) return -1;
+        return static_cast<int>(slot.index);
+    }
+
+    T* find(SlotHandle handle) {
+        int index = indexOf(handle);
+        return index < 0 ? nullptr : &values[index];
+    }
+
+    const T* find(SlotHandle handle) const {
+        int index = indexOf(handle);
+        return index < 0 ? nullptr : &values[index];
+    }
+
+    SlotHandle handleAt(size_t index) const {
+        SlotHandle handle;
+        handle.slot = valueSlots[index];
+        handle.generation = slots[handle.slot].generation;
+        return handle;
+    }
+
+    // Все ручки устаревают; слоты остаются, чтобы поколения не начались заново
+    void clear() {
+        for (uint32_t slot : valueSlots) {
+            freeSlot(slot);
+        }
+        values.clear();
+        valueSlots.clear();
+    }
+
+    void reserve(size_t count) {
+        values.reserve(count);
+        valueSlots.reserve(count);
+        slots.reserve(count);
+    }
+
+    size_t size() const { return values.size(); }
+    bool empty() const { return values.empty(); }
+    // Память массивов карты в байтах
+    size_t getMemoryUsage() const {
+        return values.capacity() * sizeof(T) + valueSlots.capacity() * sizeof(uint32_t)
+            + slots.capacity() * sizeof(Slot) + freeSlots.capacity() * sizeof(uint32_t);
+    }
+
+    T& operator[](size_t index) { return values[index]; }
+    const T& operator[](size_t index) const { return values[index]; }
+    typename std::vector<T>::iterator begin() { return values.begin(); }
+    typename std::vector<T>::iterator end() { return values.end(); }
+    typename std::vector<T>::const_iterator begin() const { return values.begin(); }
+    typename std::vector<T>::const_iterator end() const { return values.end(); }
+
+private:
+    static const uint32_t FREE = 0xFFFFFFFFu;
+
+    struct Slot {
+        uint32_t generation = 0;
+        uint32_t index = FREE; // индекс элемента в плотном массиве
+    };
+
+    void freeSlot(uint32_t slot) {
+        slots[slot].index = FREE;
+        ++slots[slot].generation;
+        freeSlots.push_back(slot);
+    }
+
+    std::vector<T> values;
+    std::vector<uint32_t> valueSlots; // слот каждого элемента плотного массива
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+};
\ No newline at end of file
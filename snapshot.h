@@ -0,0 +1,81 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// Компактное состояние одного тела для рендера: трансформы двух последних
+// шагов физики, чтобы поток рендера мог интерполировать между ними
+struct BodySnapshot {
+    glm::vec3 previousPosition;
+    glm::vec4 previousRotation; // кватернион x, y, z, w
+    glm::vec3 position;
+    glm::vec4 rotation;
+    glm::vec3 color;
+    int type;
+    BodyHandle handle; // ручка тела в мире, действительна и после перестановок bodies
+};
+
+// Счетчики состояния мира для интерфейса
+struct PhysicsStats {
+    int activeBodies = 0;
+    int sleepingBodies = 0;
+    int ccdArmed = 0; // тела с порогом CCD на последнем шаге
+    int solverType = 0; // 0 - последовательные импульсы, 1 - NNCG
+    int solverIterations = 0;
+    float solveMs = 0.0f;
+    int particles = 0; // частицы ParticleWorld, если сцена в режиме частиц
+    int particleContacts = 0;
+    float particleStepMs = 0.0f;
+    uint64_t contactBegins = 0; // события контактов с запуска потока физики
+    uint64_t contactPersists = 0;
+    uint64_t contactEnds = 0;
+    float publishMs = 0.0f; // копирование трансформ тел в этот снимок
+};
+
+struct PhysicsSnapshot {
+    std::vector<BodySnapshot> bodies;
+    double publishTime = 0.0; // момент публикации, секунды steady_clock
+    float stepTime = 1.0f / 60.0f;
+    unsigned int tick = 0;
+    PhysicsStats stats;
+};
+
+// Тройной буфер без ожиданий для одного писателя и одного читателя.
+// Писатель всегда пишет в свой буфер и атомарно меняет его местами со средним,
+// читатель забирает средний буфер, только если там появилось что-то новое.
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() : middle(1), writeIndex(0), readIndex(2) {}
+
+    // Сторона писателя
+    T& writeBuffer() { return buffers[writeIndex]; }
+
+    void publish() {
+        uint8_t previous = middle.exchange(static_cast<uint8_t>(writeIndex | DIRTY), std::memory_order_acq_rel);
+        writeIndex = previous & INDEX_MASK;
+    }
+
+    // Сторона читателя: true, если был получен новый снимок
+    bool update() {
+        if ((middle.load(std::memory_order_relaxed) & DIRTY) == 0) {
+            return false;
+        }
+        uint8_t previous = middle.exchange(readIndex, std::memory_order_acq_rel);
+        readIndex = previous & INDEX_MASK;
+        return true;
+    }
+
+    const T& readBuffer() const { return buffers[readIndex]; }
+
+private:
+    static constexpr uint8_t INDEX_MASK = 0x3;
+    static constexpr uint8_t DIRTY = 0x4;
+
+    T buffers[3];
+    std::atomic<uint8_t> middle;
+    uint8_t writeIndex;
+    uint8_t readIndex;
+};
\ No newline at end of file
@@ -0,0 +1,39 @@
+#include "solver_controller.h"
+#include <algorithm>
+#include <cmath>
+
+// Вес нового замера в сглаженной цене итерации
+static const double COST_SMOOTHING = 0.2;
+// Рост за шаг ограничен, чтобы всплеск дешевых шагов не раскачивал решатель
+static const int MAX_ITERATION_GROWTH = 1;
+
+SolverController::SolverController()
+    : msPerIteration(0.0) {
+}
+
+int SolverController::update(double solveMs, int iterations, const PhysicsSettings& settings) {
+    int minIterations = std::max(settings.minSolverIterations, 1);
+    int maxIterations = std::max(settings.maxSolverIterations, minIterations);
+    if (!isAdaptive(settings)) {
+        return maxIterations;
+    }
+    if (iterations <= 0 || solveMs <= 0.0) {
+        return std::clamp(iterations, minIterations, maxIterations);
+    }
+
+    double sample = solveMs / iterations;
+    msPerIteration = msPerIteration > 0.0 ? msPerIteration + (sample - msPerIteration) * COST_SMOOTHING : sample;
+
+    int affordable = static_cast<int>(std::floor(settings.solverBudgetMs / msPerIteration));
+    // Сверх бюджета сразу уходим вниз, вверх поднимаемся постепенно
+    int next = std::min(affordable, iterations + MAX_ITERATION_GROWTH);
+    return std::clamp(next, minIterations, maxIterations);
+}
+
+bool SolverController::isAdaptive(const PhysicsSettings& settings) {
+    return settings.adaptiveSolver && settings.solverResidualThreshold <= 0.0f;
+}
+
+void SolverController::reset() {
+    msPerIteration = 0.0;
+}
\ No newline at end of file
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "physics_types.h"
+
+// Подбирает число итераций решателя под бюджет времени шага. Время решения
+// делится на число итераций - получается цена итерации (со сглаживанием),
+// по ней выбирается, сколько итераций помещается в solverBudgetMs.
+// Подготовка контактов тоже попадает в цену, поэтому оценка с запасом.
+// С ранним выходом по невязке Bullet делает меньше итераций, чем задано, и
+// сколько именно - не сообщает: цена вышла бы заниженной, поэтому при
+// ненулевом пороге подбор выключен и идет постоянное число итераций.
+class SolverController {
+public:
+    SolverController();
+
+    // Возвращает число итераций для следующего шага
+    int update(double solveMs, int iterations, const PhysicsSettings& settings);
+    void reset();
+    // Подбор включен и не мешает ранний выход по невязке
+    static bool isAdaptive(const PhysicsSettings& settings);
+
+    double getMsPerIteration() const { return msPerIteration; }
+
+private:
+    double msPerIteration;
+};
\ No newline at end of file
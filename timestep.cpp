@@ -0,0 +1,42 @@
+#include "timestep.h"
+#include <algorithm>
+#include <cmath>
+
+FixedTimestep::FixedTimestep()
+    : accumulator(0.0f)
+    , stepTime(1.0f / 60.0f)
+    , alpha(0.0f)
+    , timeScale(1.0f) {
+}
+
+int FixedTimestep::advance(float frameTime, const PhysicsSettings& settings) {
+    stepTime = 1.0f / std::max(settings.tickRate, 1.0f);
+    int maxSteps = std::max(settings.maxCatchUpSteps, 1);
+
+    // Защита от огромных пауз (перетаскивание окна, отладчик)
+    float clampedTime = std::clamp(frameTime, 0.0f, stepTime * maxSteps * 4.0f);
+    float droppedTime = std::max(frameTime - clampedTime, 0.0f);
+    accumulator += clampedTime;
+
+    int steps = static_cast<int>(accumulator / stepTime);
+    if (steps > maxSteps) {
+        // Перегрузка: выполняем не больше maxSteps шагов, лишнее время
+        // отбрасываем - симуляция замедляется вместо того, чтобы тормозить кадры
+        steps = maxSteps;
+        float remaining = accumulator - steps * stepTime;
+        accumulator = std::fmod(remaining, stepTime);
+        droppedTime += remaining - accumulator;
+    } else {
+        accumulator -= steps * stepTime;
+    }
+
+    timeScale = frameTime > 0.0f ? std::clamp(1.0f - droppedTime / frameTime, 0.0f, 1.0f) : 1.0f;
+    alpha = accumulator / stepTime;
+    return steps;
+}
+
+void FixedTimestep::reset() {
+    accumulator = 0.0f;
+    alpha = 0.0f;
+    timeScale = 1.0f;
+}
\ No newline at end of file
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "physics_types.h"
+
+// Планировщик фиксированного шага: накапливает время кадра и выдает
+// целое число шагов физики плюс коэффициент интерполяции для рендера
+class FixedTimestep {
+public:
+    FixedTimestep();
+
+    // Возвращает число шагов физики, которые нужно выполнить в этом кадре
+    int advance(float frameTime, const PhysicsSettings& settings);
+    void reset();
+
+    float getStepTime() const { return stepTime; }
+    // Доля шага между предыдущим и текущим состоянием (0..1)
+    float getAlpha() const { return alpha; }
+    // Отношение симулированного времени к реальному за последний кадр (< 1 при перегрузке)
+    float getTimeScale() const { return timeScale; }
+
+private:
+    float accumulator;
+    float stepTime;
+    float alpha;
+    float timeScale;
+};
\ No newline at end of file
@@ -0,0 +1,151 @@
+#include "trace.h"
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+struct TraceEvent {
+    const char* name;
+    Trace::Clock::time_point begin;
+    Trace::Clock::time_point end;
+};
+
+// Кольцо одного потока. Пишет только владелец, head публикуется после
+// записи события, поэтому читатель видит события до head целиком
+struct TraceBuffer {
+    std::vector<TraceEvent> events;
+    std::atomic<uint64_t> head{0};
+    std::atomic<const char*> threadName{nullptr};
+    int threadId = 0;
+};
+
+// Кольца живут до конца программы: события завершившегося потока тоже
+// попадают в файл. Мьютекс берется только при первом событии потока и при записи
+std::mutex buffersMutex;
+std::vector<std::unique_ptr<TraceBuffer>> buffers;
+std::atomic<int64_t> captureStart{0};
+
+thread_local TraceBuffer* threadBuffer = nullptr;
+thread_local const char* threadName = nullptr;
+
+TraceBuffer* acquireThreadBuffer() {
+    if (!threadBuffer) {
+        std::unique_ptr<TraceBuffer> buffer(new TraceBuffer());
+        buffer->events.resize(Trace::BUFFER_CAPACITY);
+        buffer->threadName.store(threadName, std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        buffer->threadId = static_cast<int>(buffers.size()) + 1;
+        threadBuffer = buffer.get();
+        buffers.push_back(std::move(buffer));
+    }
+    return threadBuffer;
+}
+
+int64_t toNanoseconds(Trace::Clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+// Имена событий - литералы из кода, но кавычки и слеши экранируются на всякий случай
+void writeString(std::ofstream& out, const char* text) {
+    out << '"';
+    for (const char* c = text; *c; ++c) {
+        if (*c == '"' || *c == '\\') out << '\\';
+        out << *c;
+    }
+    out << '"';
+}
+
+} // namespace
+
+std::atomic<bool> Trace::enabled{false};
+
+void Trace::start() {
+    captureStart.store(toNanoseconds(Clock::now()), std::memory_order_relaxed);
+    enabled.store(true, std::memory_order_release);
+}
+
+void Trace::stop() {
+    enabled.store(false, std::memory_order_release);
+}
+
+void Trace::setThreadName(const char* name) {
+    threadName = name;
+    if (threadBuffer) {
+        threadBuffer->threadName.store(name, std::memory_order_relaxed);
+    }
+}
+
+void Trace::record(const char* name, Clock::time_point begin, Clock::time_point end) {
+    TraceBuffer* buffer = acquireThreadBuffer();
+    uint64_t head = buffer->head.load(std::memory_order_relaxed);
+    TraceEvent& event = buffer->events[head % BUFFER_CAPACITY];
+    event.name = name;
+    event.begin = begin;
+    event.end = end;
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+bool Trace::write(const std::string& path) {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        std::cerr << "Cannot open trace file: " << path << std::endl;
+        return false;
+    }
+
+    const int64_t origin = captureStart.load(std::memory_order_relaxed);
+    std::vector<TraceEvent> events;
+    bool first = true;
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    out.setf(std::ios::fixed);
+    out.precision(3);
+
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    for (const std::unique_ptr<TraceBuffer>& buffer : buffers) {
+        // Копия кольца, пока владелец продолжает писать. События, которые
+        // успели затереть во время копирования, отбрасываются. Барьер не дает
+        // повторному чтению head обогнать копирование, а при head = h владелец
+        // может уже писать слот события h - BUFFER_CAPACITY, поэтому
+        // отбрасывается и оно
+        uint64_t head = buffer->head.load(std::memory_order_acquire);
+        uint64_t tail = head > BUFFER_CAPACITY ? head - BUFFER_CAPACITY : 0;
+        events.clear();
+        for (uint64_t i = tail; i < head; ++i) {
+            events.push_back(buffer->events[i % BUFFER_CAPACITY]);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t overwritten = buffer->head.load(std::memory_order_relaxed);
+        overwritten = overwritten + 1 > BUFFER_CAPACITY ? overwritten + 1 - BUFFER_CAPACITY : 0;
+        size_t skip = static_cast<size_t>(std::min<uint64_t>(std::max(overwritten, tail) - tail, events.size()));
+
+        const char* name = buffer->threadName.load(std::memory_order_relaxed);
+        out << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+            << buffer->threadId << ",\"args\":{\"name\":";
+        writeString(out, name ? name : "thread");
+        out << "}}";
+        first = false;
+
+        for (size_t i = skip; i < events.size(); ++i) {
+            const TraceEvent& event = events[i];
+            int64_t begin = toNanoseconds(event.begin);
+            if (begin < origin) continue;
+            // Chrome ждет микросекунды; полное событие "X" - начало и длительность
+            out << ",\n{\"name\":";
+            writeString(out, event.name);
+            out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadId
+                << ",\"ts\":" << (begin - origin) / 1000.0
+                << ",\"dur\":" << (toNanoseconds(event.end) - begin) / 1000.0 << "}";
+        }
+    }
+    out << "\n]}\n";
+    if (!out) {
+        std::cerr << "Cannot write trace file: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+// Запись событий для chrome://tracing и Perfetto. Каждый поток пишет в свое
+// кольцо без блокировок, запись в JSON читает кольца всех потоков. Пока
+// запись выключена, событие стоит одну проверку атомарного флага.
+class Trace {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Событий в кольце одного потока; старые затираются новыми
+    static constexpr size_t BUFFER_CAPACITY = 1 << 17;
+
+    // Начинает запись: в файл попадут только события после этого вызова
+    static void start();
+    static void stop();
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+    // Имя текущего потока в трассе. Имя - строковый литерал
+    static void setThreadName(const char* name);
+
+    // Законченное событие текущего потока. name - строковый литерал
+    static void record(const char* name, Clock::time_point begin, Clock::time_point end);
+
+    // Все события записи из колец всех потоков в формате Chrome trace event.
+    // Можно вызывать, пока другие потоки пишут
+    static bool write(const std::string& path);
+
+private:
+    static std::atomic<bool> enabled;
+};
+
+// Событие на время жизни объекта; при выключенной записи время не берется
+class TraceScope {
+public:
+    explicit TraceScope(const char* name) : name(Trace::isEnabled() ? name : nullptr) {
+        if (this->name) begin = Trace::Clock::now();
+    }
+    ~TraceScope() {
+        if (name) Trace::record(name, begin, Trace::Clock::now());
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name;
+    Trace::Clock::time_point begin;
+};
\ No newline at end of file
@@ -2,33 +2,8 @@
 
 #include <GL/glew.h>
 #include <glm/glm.hpp>
-#include <bullet/btBulletDynamicsCommon.h>
 #include <vector>
-
-struct PhysicsObject {
-    btRigidBody* rigidBody;
-    btCollisionShape* shape;
-    btMotionState* motionState;
-    int type; // 0 - куб, 1 - сфера, 2 - цилиндр
-    glm::vec3 color;
-};
-
-struct PhysicsSettings {
-    float forceScale = 0.01f;
-    float horizontalScale = 1.0f;
-    float verticalScale = 1.0f;
-    float zScale = 1.0f;
-    float maxForce = 10.0f;
-    float torqueScale = 0.0002f;
-    float maxTorque = 5.0f;
-    float restitution = 0.5f;
-    float friction = 0.5f;
-    float rollingFriction = 0.1f;
-    float spinningFriction = 0.4f;
-    float damping = 0.1f;
-    float massScale = 1.0f;
-    glm::vec3 cubeColor = glm::vec3(0.8f, 0.3f, 0.2f);
-};
+#include "physics_types.h"
 
 struct Camera {
     glm::vec3 position = glm::vec3(0.0f, 10.0f, 17.5f);
@@ -44,7 +19,4 @@ struct Camera {
 struct Mesh {
     GLuint VAO, VBO, EBO;
     int indexCount;
-};
-
-// Глобальные константы
-const float BOUNDARY_SIZE = 5.0f;
\ No newline at end of file
+};
\ No newline at end of file
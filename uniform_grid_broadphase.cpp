@@ -0,0 +1,189 @@
+#include "uniform_grid_broadphase.h"
+#include <algorithm>
+#include <cmath>
+
+// Прокси, занимающий больше ячеек, проверяется со всеми остальными напрямую
+static const int MAX_CELLS_PER_PROXY = 64;
+
+// Удаляет из кэша пары, AABB которых больше не пересекаются
+struct SeparatedPairCallback : public btOverlapCallback {
+    bool processOverlap(btBroadphasePair& pair) override {
+        return !TestAabbAgainstAabb2(pair.m_pProxy0->m_aabbMin, pair.m_pProxy0->m_aabbMax,
+            pair.m_pProxy1->m_aabbMin, pair.m_pProxy1->m_aabbMax);
+    }
+};
+
+UniformGridBroadphase::UniformGridBroadphase(const btVector3& worldMin, const btVector3& worldMax, btScalar cellSize)
+    : worldMin(worldMin)
+    , worldMax(worldMax)
+    , cellSize(cellSize)
+    , invCellSize(1.0f / cellSize)
+    , pairCache(new btHashedOverlappingPairCache())
+    , nextId(2) {
+    btVector3 extent = worldMax - worldMin;
+    for (int axis = 0; axis < 3; ++axis) {
+        dims[axis] = std::max(1, static_cast<int>(std::ceil(extent[axis] * invCellSize)));
+    }
+    cellStart.resize(dims[0] * dims[1] * dims[2] + 1);
+}
+
+UniformGridBroadphase::~UniformGridBroadphase() {
+    delete pairCache;
+}
+
+void UniformGridBroadphase::computeCellRange(GridProxy* proxy) const {
+    for (int axis = 0; axis < 3; ++axis) {
+        int low = static_cast<int>(std::floor((proxy->m_aabbMin[axis] - worldMin[axis]) * invCellSize));
+        int high = static_cast<int>(std::floor((proxy->m_aabbMax[axis] - worldMin[axis]) * invCellSize));
+        proxy->cellMin[axis] = std::clamp(low, 0, dims[axis] - 1);
+        proxy->cellMax[axis] = std::clamp(high, 0, dims[axis] - 1);
+    }
+}
+
+btBroadphaseProxy* UniformGridBroadphase::createProxy(const btVector3& aabbMin, const btVector3& aabbMax, int shapeType,
+    void* userPtr, int collisionFilterGroup, int collisionFilterMask, btDispatcher* dispatcher) {
+    (void)shapeType;
+    (void)dispatcher;
+
+    GridProxy* proxy = proxyPool.create(aabbMin, aabbMax, userPtr, collisionFilterGroup, collisionFilterMask);
+    // Кэш пар хэширует по m_uniqueId, поэтому идентификаторы переиспользуются
+    if (!freeIds.empty()) {
+        proxy->m_uniqueId = freeIds.back();
+        freeIds.pop_back();
+    } else {
+        proxy->m_uniqueId = nextId++;
+    }
+    proxy->index = static_cast<int>(proxies.size());
+    proxies.push_back(proxy);
+    return proxy;
+}
+
+void UniformGridBroadphase::destroyProxy(btBroadphaseProxy* proxy, btDispatcher* dispatcher) {
+    GridProxy* gridProxy = static_cast<GridProxy*>(proxy);
+    pairCache->removeOverlappingPairsContainingProxy(proxy, dispatcher);
+
+    // Удаление перестановкой с последним
+    GridProxy* last = proxies.back();
+    proxies[gridProxy->index] = last;
+    last->index = gridProxy->index;
+    proxies.pop_back();
+
+    freeIds.push_back(gridProxy->m_uniqueId);
+    proxyPool.destroy(gridProxy);
+}
+
+void UniformGridBroadphase::setAabb(btBroadphaseProxy* proxy, const btVector3& aabbMin, const btVector3& aabbMax, btDispatcher* dispatcher) {
+    (void)dispatcher;
+    proxy->m_aabbMin = aabbMin;
+    proxy->m_aabbMax = aabbMax;
+}
+
+void UniformGridBroadphase::getAabb(btBroadphaseProxy* proxy, btVector3& aabbMin, btVector3& aabbMax) const {
+    aabbMin = proxy->m_aabbMin;
+    aabbMax = proxy->m_aabbMax;
+}
+
+void UniformGridBroadphase::rayTest(const btVector3& rayFrom, const btVector3& rayTo, btBroadphaseRayCallback& rayCallback,
+    const btVector3& aabbMin, const btVector3& aabbMax) {
+    (void)rayFrom;
+    (void)rayTo;
+    (void)aabbMin;
+    (void)aabbMax;
+    // Как в btSimpleBroadphase: точную проверку луча делает сам callback
+    for (GridProxy* proxy : proxies) {
+        rayCallback.process(proxy);
+    }
+}
+
+void UniformGridBroadphase::aabbTest(const btVector3& aabbMin, const btVector3& aabbMax, btBroadphaseAabbCallback& callback) {
+    for (GridProxy* proxy : proxies) {
+        if (TestAabbAgainstAabb2(aabbMin, aabbMax, proxy->m_aabbMin, proxy->m_aabbMax)) {
+            callback.process(proxy);
+        }
+    }
+}
+
+void UniformGridBroadphase::calculateOverlappingPairs(btDispatcher* dispatcher) {
+    // Раскладка сортировкой подсчетом: сначала число записей на ячейку
+    std::fill(cellStart.begin(), cellStart.end(), 0);
+    largeProxies.clear();
+    for (GridProxy* proxy : proxies) {
+        computeCellRange(proxy);
+        int spanned = (proxy->cellMax[0] - proxy->cellMin[0] + 1)
+            * (proxy->cellMax[1] - proxy->cellMin[1] + 1)
+            * (proxy->cellMax[2] - proxy->cellMin[2] + 1);
+        if (spanned > MAX_CELLS_PER_PROXY) {
+            largeProxies.push_back(proxy);
+            proxy->cellMax[0] = -1; // признак большого прокси
+            continue;
+        }
+        for (int z = proxy->cellMin[2]; z <= proxy->cellMax[2]; ++z)
+            for (int y = proxy->cellMin[1]; y <= proxy->cellMax[1]; ++y)
+                for (int x = proxy->cellMin[0]; x <= proxy->cellMax[0]; ++x)
+                    ++cellStart[cellIndex(x, y, z) + 1];
+    }
+    for (size_t c = 1; c < cellStart.size(); ++c) {
+        cellStart[c] += cellStart[c - 1];
+    }
+
+    cellEntries.resize(cellStart.back());
+    std::vector<int>& cursor = cellStart; // заполняем, сдвигая начала, потом восстанавливаем
+    for (GridProxy* proxy : proxies) {
+        if (proxy->cellMax[0] < 0) continue;
+        for (int z = proxy->cellMin[2]; z <= proxy->cellMax[2]; ++z)
+            for (int y = proxy->cellMin[1]; y <= proxy->cellMax[1]; ++y)
+                for (int x = proxy->cellMin[0]; x <= proxy->cellMax[0]; ++x)
+                    cellEntries[cursor[cellIndex(x, y, z)]++] = proxy;
+    }
+    for (size_t c = cellStart.size() - 1; c > 0; --c) {
+        cellStart[c] = cellStart[c - 1];
+    }
+    cellStart[0] = 0;
+
+    // Пары внутри ячеек. Пара, попавшая в несколько общих ячеек, учитывается
+    // только в той, что лежит в покомпонентном максимуме нижних углов
+    for (int z = 0; z < dims[2]; ++z) {
+        for (int y = 0; y < dims[1]; ++y) {
+            for (int x = 0; x < dims[0]; ++x) {
+                int cell = cellIndex(x, y, z);
+                int begin = cellStart[cell];
+                int end = cellStart[cell + 1];
+                for (int i = begin; i < end; ++i) {
+                    GridProxy* a = cellEntries[i];
+                    for (int j = i + 1; j < end; ++j) {
+                        GridProxy* b = cellEntries[j];
+                        if (std::max(a->cellMin[0], b->cellMin[0]) != x
+                            || std::max(a->cellMin[1], b->cellMin[1]) != y
+                            || std::max(a->cellMin[2], b->cellMin[2]) != z) {
+                            continue;
+                        }
+                        if (TestAabbAgainstAabb2(a->m_aabbMin, a->m_aabbMax, b->m_aabbMin, b->m_aabbMax)) {
+                            pairCache->addOverlappingPair(a, b);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // Большие прокси проверяются со всеми остальными
+    for (size_t i = 0; i < largeProxies.size(); ++i) {
+        GridProxy* large = largeProxies[i];
+        for (GridProxy* proxy : proxies) {
+            if (proxy == large) continue;
+            // Пару двух больших прокси учитываем один раз
+            if (proxy->cellMax[0] < 0 && proxy->index < large->index) continue;
+            if (TestAabbAgainstAabb2(large->m_aabbMin, large->m_aabbMax, proxy->m_aabbMin, proxy->m_aabbMax)) {
+                pairCache->addOverlappingPair(large, proxy);
+            }
+        }
+    }
+
+    SeparatedPairCallback separated;
+    pairCache->processAllOverlappingPairs(&separated, dispatcher);
+}
+
+void UniformGridBroadphase::getBroadphaseAabb(btVector3& aabbMin, btVector3& aabbMax) const {
+    aabbMin = worldMin;
+    aabbMax = worldMax;
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "object_pool.h"
+#include <bullet/btBulletCollisionCommon.h>
+#include <vector>
+
+// Broadphase для ограниченного мира с плотной кучей тел близкого размера.
+// Каждый шаг тела заново раскладываются сортировкой подсчетом по плотной
+// сетке ячеек, пары ищутся только внутри ячеек. Прокси, занимающие слишком
+// много ячеек (стены коробки), хранятся отдельно и проверяются со всеми.
+class UniformGridBroadphase : public btBroadphaseInterface {
+public:
+    UniformGridBroadphase(const btVector3& worldMin, const btVector3& worldMax, btScalar cellSize);
+    ~UniformGridBroadphase() override;
+
+    btBroadphaseProxy* createProxy(const btVector3& aabbMin, const btVector3& aabbMax, int shapeType, void* userPtr,
+        int collisionFilterGroup, int collisionFilterMask, btDispatcher* dispatcher) override;
+    void destroyProxy(btBroadphaseProxy* proxy, btDispatcher* dispatcher) override;
+    void setAabb(btBroadphaseProxy* proxy, const btVector3& aabbMin, const btVector3& aabbMax, btDispatcher* dispatcher) override;
+    void getAabb(btBroadphaseProxy* proxy, btVector3& aabbMin, btVector3& aabbMax) const override;
+
+    void rayTest(const btVector3& rayFrom, const btVector3& rayTo, btBroadphaseRayCallback& rayCallback,
+        const btVector3& aabbMin = btVector3(0, 0, 0), const btVector3& aabbMax = btVector3(0, 0, 0)) override;
+    void aabbTest(const btVector3& aabbMin, const btVector3& aabbMax, btBroadphaseAabbCallback& callback) override;
+
+    void calculateOverlappingPairs(btDispatcher* dispatcher) override;
+
+    btOverlappingPairCache* getOverlappingPairCache() override { return pairCache; }
+    const btOverlappingPairCache* getOverlappingPairCache() const override { return pairCache; }
+
+    void getBroadphaseAabb(btVector3& aabbMin, btVector3& aabbMax) const override;
+    void printStats() override {}
+
+private:
+    struct GridProxy : public btBroadphaseProxy {
+        int index;      // позиция в плотном списке proxies
+        int cellMin[3];
+        int cellMax[3];
+
+        GridProxy(const btVector3& aabbMin, const btVector3& aabbMax, void* userPtr, int group, int mask)
+            : btBroadphaseProxy(aabbMin, aabbMax, userPtr, group, mask), index(-1) {}
+    };
+
+    void computeCellRange(GridProxy* proxy) const;
+    int cellIndex(int x, int y, int z) const { return (z * dims[1] + y) * dims[0] + x; }
+
+    btVector3 worldMin;
+    btVector3 worldMax;
+    btScalar cellSize;
+    btScalar invCellSize;
+    int dims[3];
+
+    btOverlappingPairCache* pairCache;
+    ObjectPool<GridProxy> proxyPool;
+    std::vector<GridProxy*> proxies;
+    std::vector<int> freeIds;
+    int nextId;
+
+    // Рабочие массивы раскладки по ячейкам, переиспользуются между шагами
+    std::vector<int> cellStart;
+    std::vector<GridProxy*> cellEntries;
+    std::vector<GridProxy*> largeProxies;
+};
\ No newline at end of file
@@ -0,0 +1,460 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "instances.h"
+#include "physics.h"
+#include "bullet_backend.h"
+#include "physics_thread.h"
+
+// Бенчмарк масштабирования: сцены из N тел одной смеси форм в трех фазах -
+// падение сразу после появления, успокоенная куча и встряска окна. Время
+// кадра каждой фазы раскладывается по стадиям шага мира и подготовки рендера.
+
+enum class BenchPhase {
+    FreeFall,
+    Settled,
+    Shaking
+};
+
+static const char* phaseName(BenchPhase phase) {
+    switch (phase) {
+        case BenchPhase::FreeFall: return "freefall";
+        case BenchPhase::Settled: return "settled";
+        case BenchPhase::Shaking: return "shaking";
+    }
+    return "unknown";
+}
+
+// Смесь форм сцены: один тип тел или все три по очереди
+struct ShapeMix {
+    const char* name;
+    int type; // -1 - куб, сфера и конус по очереди
+};
+
+static const ShapeMix SHAPE_MIXES[] = {
+    { "cube", 0 },
+    { "sphere", 1 },
+    { "cone", 2 },
+    { "mixed", -1 }
+};
+
+static const ShapeMix* findShapeMix(const std::string& name) {
+    for (const ShapeMix& mix : SHAPE_MIXES) {
+        if (name == mix.name) return &mix;
+    }
+    return nullptr;
+}
+
+// Скорость окна при встряске, пикселей за кадр, как ее считает SceneInput
+const float SHAKE_SPEED = 12.0f;
+
+struct BenchOptions {
+    std::vector<int> bodyCounts = { 1000, 5000, 20000, 100000 };
+    std::vector<std::string> mixes = { "cube", "sphere", "cone", "mixed" };
+    std::vector<int> threadCounts = { 1 };
+    int frames = 120;       // замеряемых кадров на фазу
+    int settleFrames = 300; // кадров без замеров между падением и успокоенной кучей
+    float dt = 1.0f / 60.0f;
+    // Постоянное число итераций решателя: под бюджетом времени адаптация
+    // срезала бы итерации у медленной сборки и прятала ее регрессию
+    int solverIterations = 10;
+    BroadphaseType broadphase = BroadphaseType::Dbvt;
+    std::string csvPath;
+    std::string jsonPath;
+    std::string baselinePath; // CSV прошлого прогона для сравнения
+    double threshold = 0.10;  // допустимый относительный рост времени стадии
+    double noiseMs = 0.05;    // рост меньше этого считается шумом
+};
+
+// Средние за кадр одной фазы одной сцены
+struct BenchRow {
+    int threads = 0;
+    int bodies = 0;
+    std::string mix;
+    std::string phase;
+    double activeBodies = 0.0;
+    double pairs = 0.0;
+    int iterations = 0;         // итераций решателя на шаг
+    float bodyScale = 1.0f;     // размер тел относительно единичного
+    double frameMs = 0.0;       // весь кадр: команды, шаг, снимок и экземпляры
+    double broadphaseMs = 0.0;  // AABB и поиск пар
+    double narrowphaseMs = 0.0;
+    double solverMs = 0.0;
+    double integrateMs = 0.0;   // вместе с CCD
+    double extractMs = 0.0;     // трансформы в состояния движения и в снимок
+    double drawMs = 0.0;        // подготовка экземпляров для отрисовки на CPU
+};
+
+// Стадии с временем; по ним пишутся файлы и сравнивается база
+struct BenchMetric {
+    const char* name;
+    const char* column; // короткий заголовок таблицы в консоли
+    double BenchRow::*value;
+};
+
+static const BenchMetric METRICS[] = {
+    { "frame_ms", "frame", &BenchRow::frameMs },
+    { "broadphase_ms", "broad", &BenchRow::broadphaseMs },
+    { "narrowphase_ms", "narrow", &BenchRow::narrowphaseMs },
+    { "solver_ms", "solver", &BenchRow::solverMs },
+    { "integrate_ms", "integrate", &BenchRow::integrateMs },
+    { "extract_ms", "extract", &BenchRow::extractMs },
+    { "draw_ms", "draw", &BenchRow::drawMs }
+};
+
+static void printUsage(const char* program) {
+    printf("Usage: %s [--bodies N,N,...] [--mix cube,sphere,cone,mixed] [--threads T,T,...]\n", program);
+    printf("       [--frames M] [--settle-frames S] [--dt seconds] [--iterations N] [--broadphase dbvt|sap|sap32|grid]\n");
+    printf("       [--csv FILE] [--json FILE] [--baseline FILE] [--threshold FRACTION] [--noise-ms MS]\n");
+}
+
+static bool parseIntList(const char* text, std::vector<int>& values) {
+    values.clear();
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        int value = atoi(item.c_str());
+        if (value < 0 || item.empty()) return false;
+        values.push_back(value);
+    }
+    return !values.empty();
+}
+
+static bool parseMixList(const char* text, std::vector<std::string>& mixes) {
+    mixes.clear();
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!findShapeMix(item)) return false;
+        mixes.push_back(item);
+    }
+    return !mixes.empty();
+}
+
+static bool parseOptions(int argc, char** argv, BenchOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (strcmp(arg, "--bodies") == 0 && hasValue) {
+            if (!parseIntList(argv[++i], options.bodyCounts)) return false;
+        } else if (strcmp(arg, "--mix") == 0 && hasValue) {
+            if (!parseMixList(argv[++i], options.mixes)) return false;
+        } else if (strcmp(arg, "--threads") == 0 && hasValue) {
+            if (!parseIntList(argv[++i], options.threadCounts)) return false;
+        } else if (strcmp(arg, "--frames") == 0 && hasValue) {
+            options.frames = atoi(argv[++i]);
+        } else if (strcmp(arg, "--settle-frames") == 0 && hasValue) {
+            options.settleFrames = atoi(argv[++i]);
+        } else if (strcmp(arg, "--dt") == 0 && hasValue) {
+            options.dt = static_cast<float>(atof(argv[++i]));
+        } else if (strcmp(arg, "--iterations") == 0 && hasValue) {
+            options.solverIterations = atoi(argv[++i]);
+        } else if (strcmp(arg, "--broadphase") == 0 && hasValue) {
+            if (!parseBroadphaseType(argv[++i], options.broadphase)) return false;
+        } else if (strcmp(arg, "--csv") == 0 && hasValue) {
+            options.csvPath = argv[++i];
+        } else if (strcmp(arg, "--json") == 0 && hasValue) {
+            options.jsonPath = argv[++i];
+        } else if (strcmp(arg, "--baseline") == 0 && hasValue) {
+            options.baselinePath = argv[++i];
+        } else if (strcmp(arg, "--threshold") == 0 && hasValue) {
+            options.threshold = atof(argv[++i]);
+        } else if (strcmp(arg, "--noise-ms") == 0 && hasValue) {
+            options.noiseMs = atof(argv[++i]);
+        } else {
+            return false;
+        }
+    }
+    return options.frames > 0 && options.settleFrames >= 0 && options.dt > 0.0f && options.solverIterations > 0
+        && options.threshold >= 0.0;
+}
+
+// Кадр как в приложении: команды и шаг в PhysicsThread, публикация снимка,
+// затем раскладка экземпляров, которую рендер загружает в буферы
+static BenchRow measurePhase(PhysicsWorld& world, PhysicsThread& physicsThread, const BenchOptions& options,
+    BenchPhase phase, InstanceData& instances) {
+    using Clock = std::chrono::steady_clock;
+    PhysicsSettings settings;
+    BenchRow row;
+    row.phase = phaseName(phase);
+
+    for (int frame = 0; frame < options.frames; ++frame) {
+        if (phase == BenchPhase::Shaking) {
+            // Окно ходит по кругу с периодом в секунду
+            float angle = frame * options.dt * 2.0f * static_cast<float>(SIMD_PI);
+            glm::vec2 velocity(std::cos(angle) * SHAKE_SPEED, std::sin(angle) * SHAKE_SPEED);
+            physicsThread.post([velocity, settings](PhysicsWorld& world, std::vector<PhysicsObject>& objects) {
+                world.applyForceToAll(objects.data(), objects.size(), velocity, settings);
+            });
+        }
+
+        Clock::time_point start = Clock::now();
+        physicsThread.stepSynchronous(options.dt);
+        const PhysicsSnapshot& snapshot = physicsThread.acquireSnapshot();
+        Clock::time_point drawStart = Clock::now();
+        buildInstances(snapshot, 1.0f, instances);
+        row.drawMs += millisecondsSince(drawStart);
+        row.frameMs += millisecondsSince(start);
+
+        const WorldTimings& timings = world.getTimings();
+        row.broadphaseMs += timings.aabbMs + timings.pairMs;
+        row.narrowphaseMs += timings.narrowphaseMs;
+        row.solverMs += timings.solveMs;
+        row.integrateMs += timings.integrateMs;
+        row.extractMs += timings.syncMs + snapshot.stats.publishMs;
+        row.activeBodies += snapshot.stats.activeBodies;
+        row.pairs += world.getBroadphaseStats().overlappingPairs;
+    }
+
+    row.activeBodies /= options.frames;
+    row.pairs /= options.frames;
+    row.iterations = world.getSolverStats().iterations;
+    for (const BenchMetric& metric : METRICS) {
+        row.*metric.value /= options.frames;
+    }
+    return row;
+}
+
+static void runScene(const BenchOptions& options, int threads, int bodies, const ShapeMix& mix, std::vector<BenchRow>& rows) {
+    PhysicsWorldConfig config;
+    config.numThreads = threads;
+    config.broadphase = options.broadphase;
+
+    BulletBackend backend(config);
+    PhysicsWorld& world = backend.getWorld();
+    // Мир ограничивает число потоков (0 - по числу ядер), и разные --threads
+    // могут дать один и тот же мир. Повтор строки с тем же ключом не пишем
+    const int worldThreads = world.getNumThreads();
+    bool measured = std::any_of(rows.begin(), rows.end(), [&](const BenchRow& row) {
+        return row.threads == worldThreads && row.bodies == bodies && row.mix == mix.name;
+    });
+    if (measured) {
+        printf("SKIPPED --threads %d: same world as the %d-thread run of %d/%s\n",
+            threads, worldThreads, bodies, mix.name);
+        return;
+    }
+
+    PhysicsThread physicsThread(backend);
+    PhysicsSettings settings;
+    settings.adaptiveSolver = false;
+    settings.maxSolverIterations = options.solverIterations;
+    physicsThread.setSettings(settings);
+    int type = mix.type;
+    physicsThread.post([bodies, type](PhysicsWorld& world, std::vector<PhysicsObject>& objects) {
+        // Решетка как в wcp_sim: успокоенная сцена из N тел - та же коробка,
+        // заполненная N телами меньшего размера. Число тел, пар и контактов
+        // растет с N, а высота кучи остается примерно той же
+        world.spawnLattice(type, bodies, objects);
+    });
+    // Кадр с созданием тел не замеряется
+    physicsThread.stepSynchronous(options.dt);
+
+    InstanceData instances;
+    const BenchPhase phases[] = { BenchPhase::FreeFall, BenchPhase::Settled, BenchPhase::Shaking };
+    for (BenchPhase phase : phases) {
+        if (phase == BenchPhase::Settled) {
+            for (int frame = 0; frame < options.settleFrames; ++frame) {
+                physicsThread.stepSynchronous(options.dt);
+            }
+        }
+        BenchRow row = measurePhase(world, physicsThread, options, phase, instances);
+        row.threads = worldThreads;
+        row.bodies = bodies;
+        row.bodyScale = PhysicsWorld::latticeScale(bodies);
+        row.mix = mix.name;
+        rows.push_back(row);
+
+        printf("%7d %7d %7s %9s %8.0f", row.threads, row.bodies, row.mix.c_str(), row.phase.c_str(), row.activeBodies);
+        for (const BenchMetric& metric : METRICS) {
+            printf(" %9.3f", row.*metric.value);
+        }
+        printf("\n");
+        fflush(stdout);
+    }
+}
+
+static std::string rowKey(int threads, int bodies, const std::string& mix, const std::string& phase) {
+    return std::to_string(threads) + "/" + std::to_string(bodies) + "/" + mix + "/" + phase;
+}
+
+static bool writeCsv(const std::string& path, const std::vector<BenchRow>& rows) {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        std::cerr << "Cannot open benchmark CSV: " << path << std::endl;
+        return false;
+    }
+    out << "threads,bodies,mix,phase,active_bodies,pairs,iterations,body_scale";
+    for (const BenchMetric& metric : METRICS) {
+        out << ',' << metric.name;
+    }
+    out << '\n';
+    for (const BenchRow& row : rows) {
+        out << row.threads << ',' << row.bodies << ',' << row.mix << ',' << row.phase << ','
+            << row.activeBodies << ',' << row.pairs << ',' << row.iterations << ',' << row.bodyScale;
+        for (const BenchMetric& metric : METRICS) {
+            out << ',' << row.*metric.value;
+        }
+        out << '\n';
+    }
+    return true;
+}
+
+static bool writeJson(const std::string& path, const BenchOptions& options, const std::vector<BenchRow>& rows) {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        std::cerr << "Cannot open benchmark JSON: " << path << std::endl;
+        return false;
+    }
+    out << "{\n  \"frames\": " << options.frames << ",\n  \"settle_frames\": " << options.settleFrames
+        << ",\n  \"dt\": " << options.dt << ",\n  \"solver_iterations\": " << options.solverIterations
+        << ",\n  \"broadphase\": \"" << broadphaseName(options.broadphase)
+        << "\",\n  \"results\": [";
+    for (size_t i = 0; i < rows.size(); ++i) {
+        const BenchRow& row = rows[i];
+        out << (i == 0 ? "\n" : ",\n")
+            << "    {\"threads\": " << row.threads << ", \"bodies\": " << row.bodies
+            << ", \"mix\": \"" << row.mix << "\", \"phase\": \"" << row.phase
+            << "\", \"active_bodies\": " << row.activeBodies << ", \"pairs\": " << row.pairs
+            << ", \"iterations\": " << row.iterations << ", \"body_scale\": " << row.bodyScale;
+        for (const BenchMetric& metric : METRICS) {
+            out << ", \"" << metric.name << "\": " << row.*metric.value;
+        }
+        out << "}";
+    }
+    out << "\n  ]\n}\n";
+    return true;
+}
+
+// Строки CSV прошлого прогона: ключ сцены и фазы -> время по имени стадии
+using Baseline = std::map<std::string, std::map<std::string, double>>;
+
+static bool readBaseline(const std::string& path, Baseline& baseline) {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        std::cerr << "Cannot open benchmark baseline: " << path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    std::vector<std::string> header;
+    if (std::getline(in, line)) {
+        std::stringstream stream(line);
+        std::string column;
+        while (std::getline(stream, column, ',')) {
+            header.push_back(column);
+        }
+    }
+    if (header.size() < 4 || header[0] != "threads" || header[1] != "bodies" || header[2] != "mix" || header[3] != "phase") {
+        std::cerr << "Not a benchmark CSV: " << path << std::endl;
+        return false;
+    }
+
+    while (std::getline(in, line)) {
+        std::vector<std::string> fields;
+        std::stringstream stream(line);
+        std::string field;
+        while (std::getline(stream, field, ',')) {
+            fields.push_back(field);
+        }
+        if (fields.size() != header.size()) continue;
+
+        std::map<std::string, double>& values =
+            baseline[rowKey(atoi(fields[0].c_str()), atoi(fields[1].c_str()), fields[2], fields[3])];
+        for (size_t i = 4; i < fields.size(); ++i) {
+            values[header[i]] = atof(fields[i].c_str());
+        }
+    }
+    return true;
+}
+
+// Стадии, ставшие медленнее базы больше чем на порог; возвращает их число
+static int compareBaseline(const BenchOptions& options, const std::vector<BenchRow>& rows, const Baseline& baseline) {
+    int regressions = 0;
+    int compared = 0;
+    for (const BenchRow& row : rows) {
+        auto entry = baseline.find(rowKey(row.threads, row.bodies, row.mix, row.phase));
+        if (entry == baseline.end()) continue;
+        // Время решателя с другим числом итераций не сравнимо с базой
+        auto iterations = entry->second.find("iterations");
+        if (iterations != entry->second.end() && static_cast<int>(iterations->second) != row.iterations) {
+            printf("SKIPPED %s: solver iterations %d in baseline, %d now\n",
+                rowKey(row.threads, row.bodies, row.mix, row.phase).c_str(),
+                static_cast<int>(iterations->second), row.iterations);
+            continue;
+        }
+        for (const BenchMetric& metric : METRICS) {
+            auto base = entry->second.find(metric.name);
+            if (base == entry->second.end()) continue;
+            ++compared;
+            double current = row.*metric.value;
+            if (current - base->second > options.noiseMs && current > base->second * (1.0 + options.threshold)) {
+                printf("REGRESSION %s %s: %.3f -> %.3f ms (%+.1f%%)\n",
+                    rowKey(row.threads, row.bodies, row.mix, row.phase).c_str(), metric.name,
+                    base->second, current, (current / base->second - 1.0) * 100.0);
+                ++regressions;
+            }
+        }
+    }
+    printf("baseline: %d values compared, %d regressions above %.0f%%\n", compared, regressions, options.threshold * 100.0);
+    return regressions;
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+#ifndef WCP_BULLET_MT
+    // Без WCP_BULLET_MT мир всегда однопоточный
+    if (std::any_of(options.threadCounts.begin(), options.threadCounts.end(), [](int threads) { return threads != 1; })) {
+        std::cerr << "Built without WCP_BULLET_MT: --threads is ignored, every scene runs with 1 thread" << std::endl;
+        options.threadCounts = { 1 };
+    }
+#endif
+
+    Baseline baseline;
+    if (!options.baselinePath.empty() && !readBaseline(options.baselinePath, baseline)) {
+        return 1;
+    }
+
+    printf("frames/phase: %d, settle frames: %d, solver iterations: %d, broadphase: %s\n",
+        options.frames, options.settleFrames, options.solverIterations, broadphaseName(options.broadphase));
+    printf("%7s %7s %7s %9s %8s", "threads", "bodies", "mix", "phase", "active");
+    for (const BenchMetric& metric : METRICS) {
+        printf(" %9s", metric.column);
+    }
+    printf("\n");
+
+    std::vector<BenchRow> rows;
+    for (int threads : options.threadCounts) {
+        for (int bodies : options.bodyCounts) {
+            for (const std::string& mixName : options.mixes) {
+                runScene(options, threads, bodies, *findShapeMix(mixName), rows);
+            }
+        }
+    }
+
+    if (!options.csvPath.empty() && !writeCsv(options.csvPath, rows)) {
+        return 1;
+    }
+    if (!options.jsonPath.empty() && !writeJson(options.jsonPath, options, rows)) {
+        return 1;
+    }
+    // Отдельный код выхода, чтобы CI отличал регрессию от ошибки запуска
+    if (!options.baselinePath.empty() && compareBaseline(options, rows, baseline) > 0) {
+        return 2;
+    }
+    return 0;
+}
\ No newline at end of file
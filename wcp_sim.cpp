@@ -0,0 +1,573 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "physics.h"
+#include "bullet_backend.h"
+#include "particle_world.h"
+#include "physics_backend.h"
+#include "physics_thread.h"
+#include "recording.h"
+#include "scene_input.h"
+#include "trace.h"
+
+// Консольный прогон физики без окна: N тел, M кадров, вывод производительности
+struct SimOptions {
+    int bodies = 1000;
+    int frames = 600;
+    int type = -1; // -1 - смесь всех типов
+    float dt = 1.0f / 60.0f;
+    int threads = 1;          // 0 - по числу ядер
+    bool threadSweep = false; // прогнать сцену на 1, 2, 4 и 8 потоках
+    BroadphaseType broadphase = BroadphaseType::Dbvt;
+    bool broadphaseSweep = false; // сравнить все broadphase на нескольких числах тел
+    bool fastNarrowphase = true;  // аналитические алгоритмы для стен и сфер
+    bool adaptiveCcd = true;      // CCD только для быстрых тел, иначе у всех
+    SolverType solver = SolverType::SequentialImpulse;
+    float solverBudgetMs = 0.0f;  // бюджет решателя; 0 - постоянное число итераций
+    float contactThreshold = -1.0f; // порог импульса событий контактов; < 0 - из настроек
+    int despawn = 0;              // удалить столько случайных тел по ручкам после прогона
+    int queries = 0;              // лучей и столько же сфер-запросов после каждого шага
+    bool particles = false;       // сферы-частицы ParticleWorld вместо тел Bullet
+    float particleRadius = 0.0f;  // 0 - радиус ParticleConfig по умолчанию
+    bool useBackend = false;      // прогон через PhysicsBackend вместо PhysicsWorld
+    BackendType backend = BackendType::Bullet;
+    bool backendSweep = false;    // одна и та же сцена на всех движках
+    std::string replayPath;   // воспроизвести запись ввода вместо решетки тел
+    std::string timingsPath;  // CSV с покадровыми замерами воспроизведения
+    std::string loadPath;     // начать с сохраненного снимка вместо решетки тел
+    std::string savePath;     // сохранить снимок сцены после прогона
+    std::string scenePath;    // начать со сцены, отображенной в память
+    std::string saveScenePath; // сохранить сцену для отображения в память
+    std::string tracePath;    // записать трассу Chrome trace event за весь прогон
+};
+
+static void printUsage(const char* program) {
+    printf("Usage: %s [--bodies N] [--frames M] [--type 0|1|2] [--dt seconds] [--threads T] [--thread-sweep]\n", program);
+    printf("       [--broadphase dbvt|sap|sap32|grid] [--broadphase-sweep] [--generic-narrowphase] [--always-ccd]\n");
+    printf("       [--solver si|nncg] [--solver-budget MS] [--contact-threshold IMPULSE] [--despawn N] [--queries N]\n");
+    printf("       [--particles] [--particle-radius R] [--backend bullet|particles|reference] [--backend-sweep]\n");
+    printf("       [--load SNAPSHOT] [--save SNAPSHOT] [--scene SCENE] [--save-scene SCENE] [--trace FILE]\n");
+    printf("       %s --replay FILE [--threads T] [--timings FILE]\n", program);
+}
+
+static bool parseOptions(int argc, char** argv, SimOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (strcmp(arg, "--bodies") == 0 && hasValue) {
+            options.bodies = atoi(argv[++i]);
+        } else if (strcmp(arg, "--frames") == 0 && hasValue) {
+            options.frames = atoi(argv[++i]);
+        } else if (strcmp(arg, "--type") == 0 && hasValue) {
+            options.type = atoi(argv[++i]);
+        } else if (strcmp(arg, "--dt") == 0 && hasValue) {
+            options.dt = static_cast<float>(atof(argv[++i]));
+        } else if (strcmp(arg, "--threads") == 0 && hasValue) {
+            options.threads = atoi(argv[++i]);
+        } else if (strcmp(arg, "--thread-sweep") == 0) {
+            options.threadSweep = true;
+        } else if (strcmp(arg, "--broadphase") == 0 && hasValue) {
+            if (!parseBroadphaseType(argv[++i], options.broadphase)) return false;
+        } else if (strcmp(arg, "--broadphase-sweep") == 0) {
+            options.broadphaseSweep = true;
+        } else if (strcmp(arg, "--generic-narrowphase") == 0) {
+            options.fastNarrowphase = false;
+        } else if (strcmp(arg, "--always-ccd") == 0) {
+            options.adaptiveCcd = false;
+        } else if (strcmp(arg, "--solver") == 0 && hasValue) {
+            if (!parseSolverType(argv[++i], options.solver)) return false;
+        } else if (strcmp(arg, "--solver-budget") == 0 && hasValue) {
+            options.solverBudgetMs = static_cast<float>(atof(argv[++i]));
+        } else if (strcmp(arg, "--contact-threshold") == 0 && hasValue) {
+            options.contactThreshold = static_cast<float>(atof(argv[++i]));
+        } else if (strcmp(arg, "--queries") == 0 && hasValue) {
+            options.queries = atoi(argv[++i]);
+        } else if (strcmp(arg, "--despawn") == 0 && hasValue) {
+            options.despawn = atoi(argv[++i]);
+        } else if (strcmp(arg, "--particles") == 0) {
+            options.particles = true;
+        } else if (strcmp(arg, "--particle-radius") == 0 && hasValue) {
+            options.particleRadius = static_cast<float>(atof(argv[++i]));
+        } else if (strcmp(arg, "--backend") == 0 && hasValue) {
+            if (!parseBackendType(argv[++i], options.backend)) return false;
+            options.useBackend = true;
+        } else if (strcmp(arg, "--backend-sweep") == 0) {
+            options.backendSweep = true;
+        } else if (strcmp(arg, "--replay") == 0 && hasValue) {
+            options.replayPath = argv[++i];
+        } else if (strcmp(arg, "--timings") == 0 && hasValue) {
+            options.timingsPath = argv[++i];
+        } else if (strcmp(arg, "--load") == 0 && hasValue) {
+            options.loadPath = argv[++i];
+        } else if (strcmp(arg, "--save") == 0 && hasValue) {
+            options.savePath = argv[++i];
+        } else if (strcmp(arg, "--scene") == 0 && hasValue) {
+            options.scenePath = argv[++i];
+        } else if (strcmp(arg, "--save-scene") == 0 && hasValue) {
+            options.saveScenePath = argv[++i];
+        } else if (strcmp(arg, "--trace") == 0 && hasValue) {
+            options.tracePath = argv[++i];
+        } else {
+            return false;
+        }
+    }
+    return options.bodies >= 0 && options.frames > 0 && options.dt > 0.0f && options.type <= 2 && options.threads >= 0
+        && options.despawn >= 0 && options.queries >= 0;
+}
+
+// Пакет запросов как у эффектов: вертикальные лучи через всю коробку и сферы
+// радиуса 1 в детерминированно случайных точках
+static void buildQueries(int count, std::vector<RayQuery>& rays, std::vector<SphereQuery>& spheres) {
+    uint32_t state = 54321u;
+    auto next = [&state]() {
+        state = state * 1664525u + 1013904223u;
+        return ((state >> 8) / 16777216.0f * 2.0f - 1.0f) * BOUNDARY_SIZE;
+    };
+    rays.resize(count);
+    spheres.resize(count);
+    for (int i = 0; i < count; ++i) {
+        btScalar x = next();
+        btScalar z = next();
+        rays[i].from = btVector3(x, BOUNDARY_SIZE, z);
+        rays[i].to = btVector3(x, -BOUNDARY_SIZE, z);
+        spheres[i].center = btVector3(next(), next(), next());
+        spheres[i].radius = 1.0f;
+    }
+}
+
+// Удаление случайных тел по ручкам после прогона: время на одно тело и
+// проверка, что ручка удаленного тела больше ничего не находит
+static void despawnBodies(PhysicsWorld& world, std::vector<PhysicsObject>& objects, int count) {
+    using Clock = std::chrono::steady_clock;
+    uint32_t state = 12345u;
+    BodyHandle lastRemoved;
+    int removed = 0;
+    Clock::time_point start = Clock::now();
+    for (; removed < count && !objects.empty(); ++removed) {
+        state = state * 1664525u + 1013904223u;
+        size_t index = (state >> 8) % objects.size();
+        lastRemoved = objects[index].handle;
+        world.removeBody(lastRemoved, objects);
+    }
+    double us = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    if (removed == 0) return;
+
+    bool staleRejected = !world.getBody(lastRemoved) && !world.removeBody(lastRemoved, objects);
+    printf("despawned %d bodies: %.3f us/body, stale handle %s\n", removed, us / removed,
+        staleRejected ? "rejected" : "NOT rejected");
+}
+
+struct SimResult {
+    int threads;
+    double seconds;
+    double pairMs = 0.0; // среднее время поиска пар за шаг
+    double pairs = 0.0;  // среднее число пар в кэше broadphase
+    double ccdArmed = 0.0; // среднее число тел с порогом CCD за шаг
+    double iterations = 0.0; // среднее число итераций решателя
+    double solveMs = 0.0;    // среднее время решателя за шаг
+    double contactBegins = 0.0; // средние числа событий контактов за шаг
+    double contactEnds = 0.0;
+    double contactEvents = 0.0;
+    double queryMs = 0.0;     // среднее время пакета запросов за кадр, не входит в seconds
+    double rayHits = 0.0;     // средние числа попаданий лучей и тел в сферах за кадр
+    double overlapHits = 0.0;
+};
+
+static SimResult runScene(const SimOptions& options, int threads) {
+    PhysicsWorldConfig config;
+    config.numThreads = threads;
+    config.broadphase = options.broadphase;
+    config.fastNarrowphase = options.fastNarrowphase;
+
+    PhysicsWorld world;
+    world.init(config);
+    world.createBoundaryWalls();
+
+    using Clock = std::chrono::steady_clock;
+    PhysicsSettings settings;
+    std::vector<PhysicsObject> objects;
+    if (!options.loadPath.empty()) {
+        Clock::time_point loadStart = Clock::now();
+        if (!world.loadSnapshot(options.loadPath, objects, settings)) {
+            world.cleanup();
+            return { world.getNumThreads(), 0.0 };
+        }
+        double loadMs = std::chrono::duration<double, std::milli>(Clock::now() - loadStart).count();
+        printf("loaded %zu bodies in %.2f ms\n", objects.size(), loadMs);
+    } else if (!options.scenePath.empty()) {
+        Clock::time_point loadStart = Clock::now();
+        MappedScene scene;
+        if (!scene.open(options.scenePath) || !world.loadSceneMap(scene, objects)) {
+            world.cleanup();
+            return { world.getNumThreads(), 0.0 };
+        }
+        double loadMs = std::chrono::duration<double, std::milli>(Clock::now() - loadStart).count();
+        printf("mapped %zu bodies in %.2f ms\n", objects.size(), loadMs);
+    } else {
+        world.spawnLattice(options.type, options.bodies, objects);
+    }
+    settings.adaptiveCcd = options.adaptiveCcd;
+    world.setCcdPolicy(settings.adaptiveCcd, settings.ccdMotionFraction);
+    settings.solverType = static_cast<int>(options.solver);
+    settings.adaptiveSolver = options.solverBudgetMs > 0.0f;
+    if (settings.adaptiveSolver) {
+        settings.solverBudgetMs = options.solverBudgetMs;
+    }
+    world.setSolverSettings(settings);
+    if (options.contactThreshold >= 0.0f) {
+        settings.contactImpulseThreshold = options.contactThreshold;
+    }
+    world.setContactEvents(settings.contactEvents, settings.contactImpulseThreshold);
+
+    double pairMs = 0.0;
+    double pairs = 0.0;
+    double ccdArmed = 0.0;
+    double iterations = 0.0;
+    double solveMs = 0.0;
+    double contactBegins = 0.0;
+    double contactEnds = 0.0;
+    double contactEvents = 0.0;
+    std::vector<ContactEvent> events;
+    std::vector<RayQuery> rays;
+    std::vector<RayQueryHit> rayHits;
+    std::vector<SphereQuery> spheres;
+    QueryResults overlaps;
+    buildQueries(options.queries, rays, spheres);
+    rayHits.resize(rays.size());
+    double querySeconds = 0.0;
+    double rayHitCount = 0.0;
+    double overlapHitCount = 0.0;
+    Clock::time_point start = Clock::now();
+    for (int frame = 0; frame < options.frames; ++frame) {
+        world.stepSimulation(options.dt);
+        if (options.queries > 0) {
+            Clock::time_point queryStart = Clock::now();
+            world.raycast(rays.data(), rays.size(), rayHits.data());
+            world.overlap(spheres.data(), spheres.size(), overlaps);
+            querySeconds += std::chrono::duration<double>(Clock::now() - queryStart).count();
+            for (const RayQueryHit& hit : rayHits) {
+                if (hit.handle.isValid()) ++rayHitCount;
+            }
+            overlapHitCount += overlaps.hits.size();
+        }
+        // События читаются пакетом после каждого шага, как это делал бы потребитель
+        contactEvents += world.readContactEvents(events);
+        ContactEventStats contactStats = world.getContactEventStats();
+        contactBegins += contactStats.begins;
+        contactEnds += contactStats.ends;
+        BroadphaseStats stats = world.getBroadphaseStats();
+        pairMs += stats.pairMs;
+        pairs += stats.overlappingPairs;
+        ccdArmed += world.getCcdArmedCount();
+        SolverStats solver = world.getSolverStats();
+        iterations += solver.iterations;
+        solveMs += solver.solveMs;
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count() - querySeconds;
+
+    if (options.despawn > 0) {
+        despawnBodies(world, objects, options.despawn);
+    }
+    if (!options.savePath.empty() && world.saveSnapshot(options.savePath, objects, settings)) {
+        printf("saved %zu bodies to %s\n", objects.size(), options.savePath.c_str());
+    }
+    if (!options.saveScenePath.empty() && world.saveSceneMap(options.saveScenePath, objects)) {
+        printf("saved %zu bodies to %s\n", objects.size(), options.saveScenePath.c_str());
+    }
+
+    world.removeObjects(objects, true);
+    SimResult result = { world.getNumThreads(), seconds, pairMs / options.frames, pairs / options.frames,
+        ccdArmed / options.frames, iterations / options.frames, solveMs / options.frames,
+        contactBegins / options.frames, contactEnds / options.frames, contactEvents / options.frames,
+        querySeconds * 1000.0 / options.frames, rayHitCount / options.frames, overlapHitCount / options.frames };
+    world.cleanup();
+    return result;
+}
+
+// Воспроизведение записи тем же путем, что и в окне, но без рендера
+static int runReplay(const SimOptions& options) {
+    InputReplay replay;
+    if (!replay.load(options.replayPath)) {
+        return 1;
+    }
+    FrameTimingLog timings;
+    if (!options.timingsPath.empty() && !timings.open(options.timingsPath)) {
+        return 1;
+    }
+
+    PhysicsWorldConfig config;
+    config.numThreads = options.threads;
+    config.fastNarrowphase = options.fastNarrowphase;
+
+    BulletBackend backend(config);
+    PhysicsWorld& world = backend.getWorld();
+
+    PhysicsSettings settings = replay.getInitialSettings();
+    PhysicsThread physicsThread(backend);
+    physicsThread.setSettings(settings);
+    SceneInput input(physicsThread);
+
+    using Clock = std::chrono::steady_clock;
+    const float stepTime = 1.0f / settings.tickRate;
+    int frame = 0;
+    for (double time = 0.0; !replay.finished(time); time = ++frame * static_cast<double>(stepTime)) {
+        replay.feed(time, input, settings);
+        input.flush(time, settings);
+
+        Clock::time_point start = Clock::now();
+        physicsThread.stepSynchronous(stepTime);
+        double physicsMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        timings.add(frame, physicsMs, 0.0);
+
+        input.setObjectCount(physicsThread.acquireSnapshot().bodies.size());
+    }
+    timings.close();
+
+    printf("replay: %s\n", options.replayPath.c_str());
+    printf("threads: %d\n", world.getNumThreads());
+    printf("frames: %d\n", timings.getFrameCount());
+    printf("ms/step: %.4f\n", timings.getAveragePhysicsMs());
+    return 0;
+}
+
+// Сцена только из сфер на ParticleWorld: --bodies частиц падают кучей на дно
+static int runParticles(const SimOptions& options) {
+    ParticleConfig config;
+    if (options.particleRadius > 0.0f) {
+        config.radius = options.particleRadius;
+    }
+    ParticleWorld world;
+    world.init(config);
+    size_t spawned = world.spawn(static_cast<size_t>(options.bodies));
+
+    PhysicsSettings settings;
+    double stepMs = 0.0;
+    double contacts = 0.0;
+    for (int frame = 0; frame < options.frames; ++frame) {
+        world.stepSimulation(options.dt, settings);
+        ParticleStats stats = world.getStats();
+        stepMs += stats.stepMs;
+        contacts += stats.contacts;
+    }
+
+    printf("particles: %zu, radius: %.3f\n", spawned, world.getRadius());
+    printf("steps/sec: %.2f\n", options.frames * 1000.0 / stepMs);
+    printf("ms/step: %.4f\n", stepMs / options.frames);
+    printf("contacts: %.0f\n", contacts / options.frames);
+    return 0;
+}
+
+struct BackendResult {
+    size_t bodies = 0; // наибольшее число тел за прогон
+    int steps = 0;
+    double stepMs = 0.0;  // среднее время шага
+    size_t memory = 0;    // наибольшая оценка памяти движка
+};
+
+// Сцена через общий интерфейс движка: запись ввода, если она задана, иначе
+// пакет --bodies тел. Без --type создаются сферы - их умеют все движки
+static bool runBackend(const SimOptions& options, BackendType type, BackendResult& result) {
+    PhysicsWorldConfig config;
+    config.numThreads = options.threads;
+    config.broadphase = options.broadphase;
+    config.fastNarrowphase = options.fastNarrowphase;
+    std::unique_ptr<PhysicsBackend> backend = createPhysicsBackend(type, config);
+
+    PhysicsSettings settings;
+    settings.adaptiveCcd = options.adaptiveCcd;
+    settings.solverType = static_cast<int>(options.solver);
+    settings.adaptiveSolver = options.solverBudgetMs > 0.0f;
+    if (settings.adaptiveSolver) {
+        settings.solverBudgetMs = options.solverBudgetMs;
+    }
+    if (options.contactThreshold >= 0.0f) {
+        settings.contactImpulseThreshold = options.contactThreshold;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    double totalMs = 0.0;
+    result = BackendResult();
+    auto timedStep = [&](float stepTime) {
+        Clock::time_point start = Clock::now();
+        backend->step(stepTime, settings);
+        totalMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        ++result.steps;
+        result.bodies = std::max(result.bodies, backend->getBodyCount());
+        result.memory = std::max(result.memory, backend->getMemoryUsage());
+    };
+
+    if (!options.replayPath.empty()) {
+        InputReplay replay;
+        if (!replay.load(options.replayPath)) {
+            return false;
+        }
+        settings = replay.getInitialSettings();
+        SceneInput input(*backend);
+        const float stepTime = 1.0f / settings.tickRate;
+        int frame = 0;
+        for (double time = 0.0; !replay.finished(time); time = ++frame * static_cast<double>(stepTime)) {
+            replay.feed(time, input, settings);
+            input.flush(time, settings);
+            timedStep(stepTime);
+            input.setObjectCount(backend->getBodyCount());
+        }
+    } else {
+        backend->spawnBatch(options.type >= 0 ? options.type : 1, static_cast<size_t>(options.bodies), settings);
+        for (int frame = 0; frame < options.frames; ++frame) {
+            timedStep(options.dt);
+        }
+    }
+
+    result.stepMs = result.steps > 0 ? totalMs / result.steps : 0.0;
+    return true;
+}
+
+// Выбранный движок или, с --backend-sweep, каждый на одной и той же сцене:
+// время шага и память на тело
+static int runBackends(const SimOptions& options) {
+    const BackendType types[] = { BackendType::Bullet, BackendType::Particles, BackendType::Reference };
+
+    printf("%10s %8s %8s %12s %12s\n", "backend", "bodies", "steps", "ms/step", "bytes/body");
+    for (BackendType type : types) {
+        if (!options.backendSweep && type != options.backend) continue;
+        BackendResult result;
+        if (!runBackend(options, type, result)) {
+            return 1;
+        }
+        printf("%10s %8zu %8d %12.4f %12.0f\n", backendName(type), result.bodies, result.steps, result.stepMs,
+            result.bodies > 0 ? static_cast<double>(result.memory) / result.bodies : 0.0);
+    }
+    return 0;
+}
+
+static void printResult(const SimOptions& options, const SimResult& result) {
+    printf("threads: %d\n", result.threads);
+    printf("steps/sec: %.2f\n", options.frames / result.seconds);
+    printf("ms/step: %.4f\n", result.seconds * 1000.0 / options.frames);
+    printf("broadphase: %s\n", broadphaseName(options.broadphase));
+    printf("narrowphase: %s\n", options.fastNarrowphase ? "fast" : "generic");
+    printf("pair ms/step: %.4f\n", result.pairMs);
+    printf("pairs: %.0f\n", result.pairs);
+    printf("ccd: %s, armed/step: %.1f\n", options.adaptiveCcd ? "adaptive" : "always", result.ccdArmed);
+    printf("solver: %s, iterations: %.1f, solve ms/step: %.4f\n", solverName(options.solver), result.iterations, result.solveMs);
+    printf("contact events/step: %.1f (begin %.1f, end %.1f)\n", result.contactEvents, result.contactBegins, result.contactEnds);
+    if (options.queries > 0) {
+        double stepMs = result.seconds * 1000.0 / options.frames;
+        printf("queries: %d rays + %d spheres, ms/frame: %.4f (%.1f%% of step), hits/frame: rays %.1f, bodies in spheres %.1f\n",
+            options.queries, options.queries, result.queryMs, stepMs > 0.0 ? result.queryMs / stepMs * 100.0 : 0.0,
+            result.rayHits, result.overlapHits);
+    }
+}
+
+// Все broadphase на одной и той же сцене при разном числе тел
+static int runBroadphaseSweep(const SimOptions& options) {
+    const BroadphaseType types[] = {
+        BroadphaseType::Dbvt, BroadphaseType::AxisSweep3, BroadphaseType::AxisSweep3_32, BroadphaseType::UniformGrid
+    };
+    const int bodyCounts[] = { 1000, 5000, 20000 };
+
+    printf("%8s %10s %12s %10s %12s\n", "bodies", "broadphase", "pair ms", "pairs", "ms/step");
+    for (int bodies : bodyCounts) {
+        for (BroadphaseType type : types) {
+            SimOptions run = options;
+            run.bodies = bodies;
+            run.broadphase = type;
+            SimResult result = runScene(run, options.threads);
+            if (result.seconds <= 0.0) {
+                return 1;
+            }
+            printf("%8d %10s %12.4f %10.0f %12.4f\n",
+                bodies, broadphaseName(type), result.pairMs, result.pairs,
+                result.seconds * 1000.0 / options.frames);
+        }
+    }
+    return 0;
+}
+
+static int runSim(const SimOptions& options) {
+    if (options.useBackend || options.backendSweep) {
+        if (!options.replayPath.empty()) {
+            printf("replay: %s\n", options.replayPath.c_str());
+        }
+        return runBackends(options);
+    }
+
+    if (!options.replayPath.empty()) {
+        return runReplay(options);
+    }
+
+    if (options.particles) {
+        printf("frames: %d\n", options.frames);
+        return runParticles(options);
+    }
+
+    if (options.broadphaseSweep) {
+        printf("frames: %d\n", options.frames);
+        return runBroadphaseSweep(options);
+    }
+
+    printf("bodies: %d\n", options.bodies);
+    printf("frames: %d\n", options.frames);
+
+    if (!options.threadSweep) {
+        SimResult result = runScene(options, options.threads);
+        if (result.seconds <= 0.0) {
+            return 1;
+        }
+        printResult(options, result);
+        return 0;
+    }
+
+    if (!PhysicsWorld::isMultithreadingAvailable()) {
+        printf("warning: built without WCP_BULLET_MULTITHREADED, all runs are single-threaded\n");
+    }
+
+    // Масштабирование относительно однопоточного мира
+    printf("%8s %12s %10s %8s\n", "threads", "steps/sec", "ms/step", "speedup");
+    double baseline = 0.0;
+    const int threadCounts[] = { 1, 2, 4, 8 };
+    for (int threads : threadCounts) {
+        SimResult result = runScene(options, threads);
+        if (result.seconds <= 0.0) {
+            return 1;
+        }
+        if (baseline == 0.0) {
+            baseline = result.seconds;
+        }
+        printf("%8d %12.2f %10.4f %7.2fx\n",
+            result.threads,
+            options.frames / result.seconds,
+            result.seconds * 1000.0 / options.frames,
+            baseline / result.seconds);
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    SimOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    Trace::setThreadName("main");
+    if (!options.tracePath.empty()) {
+        Trace::start();
+    }
+    int result = runSim(options);
+    if (!options.tracePath.empty()) {
+        Trace::stop();
+        if (!Trace::write(options.tracePath)) {
+            return 1;
+        }
+        printf("trace: %s\n", options.tracePath.c_str());
+    }
+    return result;
+}
\ No newline at end of file
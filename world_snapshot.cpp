@@ -0,0 +1,389 @@
+#include "physics.h"
+#include "recording.h"
+#include "world_snapshot.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+bool PhysicsWorld::saveSnapshot(const std::string& path, const std::vector<PhysicsObject>& objects, const PhysicsSettings& settings) const {
+    std::vector<SnapshotArchetype> archetypes;
+    std::vector<SnapshotBody> bodies;
+    bodies.reserve(objects.size());
+
+    for (const auto& obj : objects) {
+        if (!obj.rigidBody) continue;
+
+        int proxyType = 0;
+        btVector3 dimensions;
+        if (!shapeCache.describe(obj.shape, proxyType, dimensions)) {
+            std::cerr << "Snapshot: shape is not from the shape cache, body skipped" << std::endl;
+            continue;
+        }
+
+        // Архетипов единицы, линейный поиск дешевле любой таблицы
+        uint32_t archetype = 0;
+        while (archetype < archetypes.size()
+            && !(archetypes[archetype].proxyType == proxyType
+                && archetypes[archetype].dimensions[0] == dimensions.x()
+                && archetypes[archetype].dimensions[1] == dimensions.y()
+                && archetypes[archetype].dimensions[2] == dimensions.z())) {
+            ++archetype;
+        }
+        if (archetype == archetypes.size()) {
+            archetypes.push_back({ proxyType, { dimensions.x(), dimensions.y(), dimensions.z() } });
+        }
+
+        const btRigidBody* body = obj.rigidBody;
+        const btTransform& transform = body->getWorldTransform();
+        btQuaternion rotation = transform.getRotation();
+
+        SnapshotBody record;
+        record.archetype = archetype;
+        record.type = obj.type;
+        record.color[0] = obj.color.x;
+        record.color[1] = obj.color.y;
+        record.color[2] = obj.color.z;
+        record.mass = body->getMass();
+        record.friction = body->getFriction();
+        record.restitution = body->getRestitution();
+        record.rollingFriction = body->getRollingFriction();
+        record.spinningFriction = body->getSpinningFriction();
+        record.linearDamping = body->getLinearDamping();
+        record.angularDamping = body->getAngularDamping();
+        record.ccdMotionThreshold = body->getCcdMotionThreshold();
+        record.ccdSweptSphereRadius = body->getCcdSweptSphereRadius();
+        for (int k = 0; k < 3; ++k) {
+            record.position[k] = transform.getOrigin()[k];
+            record.linearVelocity[k] = body->getLinearVelocity()[k];
+            record.angularVelocity[k] = body->getAngularVelocity()[k];
+        }
+        record.rotation[0] = rotation.x();
+        record.rotation[1] = rotation.y();
+        record.rotation[2] = rotation.z();
+        record.rotation[3] = rotation.w();
+        record.activationState = body->getActivationState();
+        record.deactivationTime = body->getDeactivationTime();
+        bodies.push_back(record);
+    }
+
+    std::string settingsText = serializeSettings(settings);
+
+    SnapshotHeader header;
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.settingsSize = static_cast<uint32_t>(settingsText.size());
+    header.archetypeCount = static_cast<uint32_t>(archetypes.size());
+    header.bodyCount = static_cast<uint32_t>(bodies.size());
+    header.tickCount = tickCount;
+
+    std::ofstream out(path, std::ios::binary);
+    if (!out.is_open()) {
+        std::cerr << "Cannot open snapshot file: " << path << std::endl;
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(settingsText.data(), settingsText.size());
+    out.write(reinterpret_cast<const char*>(archetypes.data()), archetypes.size() * sizeof(SnapshotArchetype));
+    out.write(reinterpret_cast<const char*>(bodies.data()), bodies.size() * sizeof(SnapshotBody));
+    return out.good();
+}
+
+bool PhysicsWorld::loadSnapshot(const std::string& path, std::vector<PhysicsObject>& objects, PhysicsSettings& settings) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+        std::cerr << "Cannot open snapshot file: " << path << std::endl;
+        return false;
+    }
+
+    SnapshotHeader header;
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!in || std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 || header.version != SNAPSHOT_VERSION) {
+        std::cerr << "Unsupported snapshot format: " << path << std::endl;
+        return false;
+    }
+
+    // Размеры из заголовка сверяем с длиной файла до выделения памяти под них
+    in.seekg(0, std::ios::end);
+    uint64_t fileSize = static_cast<uint64_t>(in.tellg());
+    in.seekg(sizeof(header), std::ios::beg);
+    uint64_t expectedSize = sizeof(header) + static_cast<uint64_t>(header.settingsSize)
+        + static_cast<uint64_t>(header.archetypeCount) * sizeof(SnapshotArchetype)
+        + static_cast<uint64_t>(header.bodyCount) * sizeof(SnapshotBody);
+    if (!in || expectedSize > fileSize) {
+        std::cerr << "Truncated snapshot file: " << path << std::endl;
+        return false;
+    }
+
+    // Читаем файл целиком до изменения мира, чтобы битый файл не оставил сцену наполовину
+    std::string settingsText(header.settingsSize, '\0');
+    std::vector<SnapshotArchetype> archetypes(header.archetypeCount);
+    std::vector<SnapshotBody> bodies(header.bodyCount);
+    in.read(&settingsText[0], settingsText.size());
+    in.read(reinterpret_cast<char*>(archetypes.data()), archetypes.size() * sizeof(SnapshotArchetype));
+    in.read(reinterpret_cast<char*>(bodies.data()), bodies.size() * sizeof(SnapshotBody));
+    if (!in) {
+        std::cerr << "Truncated snapshot file: " << path << std::endl;
+        return false;
+    }
+    for (const auto& record : bodies) {
+        if (record.archetype >= archetypes.size() || record.type < 0 || record.type > 2) {
+            std::cerr << "Corrupted snapshot file: " << path << std::endl;
+            return false;
+        }
+    }
+
+    settings = PhysicsSettings();
+    parseSettings(settingsText, settings);
+    setSleeping(settings.sleepingEnabled, settings.sleepLinearThreshold, settings.sleepAngularThreshold);
+
+    removeObjects(objects, false);
+    objects.clear();
+    objects.reserve(bodies.size());
+    dynamicBodies.reserve(bodies.size());
+    tickCount = header.tickCount;
+
+    for (const auto& record : bodies) {
+        const SnapshotArchetype& archetype = archetypes[record.archetype];
+
+        PhysicsObject obj;
+        obj.type = record.type;
+        obj.color = glm::vec3(record.color[0], record.color[1], record.color[2]);
+        obj.shape = shapeCache.acquire(archetype.proxyType,
+            btVector3(archetype.dimensions[0], archetype.dimensions[1], archetype.dimensions[2]));
+        if (!obj.shape) continue;
+
+        btTransform transform;
+        transform.setOrigin(btVector3(record.position[0], record.position[1], record.position[2]));
+        transform.setRotation(btQuaternion(record.rotation[0], record.rotation[1], record.rotation[2], record.rotation[3]));
+
+        obj.motionState = createMotionState(transform);
+        btRigidBody::btRigidBodyConstructionInfo rbInfo(record.mass, obj.motionState, obj.shape,
+            shapeCache.getLocalInertia(obj.shape, record.mass));
+        rbInfo.m_friction = record.friction;
+        rbInfo.m_restitution = record.restitution;
+        rbInfo.m_rollingFriction = record.rollingFriction;
+        rbInfo.m_spinningFriction = record.spinningFriction;
+        rbInfo.m_linearDamping = record.linearDamping;
+        rbInfo.m_angularDamping = record.angularDamping;
+
+        obj.rigidBody = createRigidBody(rbInfo);
+        obj.rigidBody->setLinearVelocity(btVector3(record.linearVelocity[0], record.linearVelocity[1], record.linearVelocity[2]));
+        obj.rigidBody->setAngularVelocity(btVector3(record.angularVelocity[0], record.angularVelocity[1], record.angularVelocity[2]));
+        obj.rigidBody->setCcdMotionThreshold(record.ccdMotionThreshold);
+        obj.rigidBody->setCcdSweptSphereRadius(record.ccdSweptSphereRadius);
+        configureSleeping(obj.rigidBody);
+        addObject(obj, objects);
+
+        // Уснувшая куча остается спящей и не требует ни одного шага на успокоение
+        if (sleepingEnabled && record.activationState != DISABLE_DEACTIVATION) {
+            obj.rigidBody->forceActivationState(record.activationState);
+            obj.rigidBody->setDeactivationTime(record.deactivationTime);
+        }
+    }
+    return true;
+}
+
+static bool sameArchetype(const SceneMapArchetype& a, const SceneMapArchetype& b) {
+    return a.proxyType == b.proxyType
+        && a.dimensions[0] == b.dimensions[0] && a.dimensions[1] == b.dimensions[1] && a.dimensions[2] == b.dimensions[2]
+        && a.type == b.type && a.mass == b.mass
+        && a.friction == b.friction && a.restitution == b.restitution
+        && a.rollingFriction == b.rollingFriction && a.spinningFriction == b.spinningFriction
+        && a.linearDamping == b.linearDamping && a.angularDamping == b.angularDamping
+        && a.ccdMotionThreshold == b.ccdMotionThreshold && a.ccdSweptSphereRadius == b.ccdSweptSphereRadius;
+}
+
+// Дописывает нули до смещения массива и сам массив
+static void writeArray(std::ofstream& out, uint64_t offset, const void* data, size_t bytes) {
+    static const char zeros[SCENE_MAP_ALIGNMENT] = {};
+    uint64_t position = static_cast<uint64_t>(out.tellp());
+    if (offset > position) {
+        out.write(zeros, static_cast<std::streamsize>(offset - position));
+    }
+    out.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+}
+
+bool PhysicsWorld::saveSceneMap(const std::string& path, const std::vector<PhysicsObject>& objects) const {
+    // Архетип каждого тела: форма, тип, масса и материал
+    std::vector<SceneMapArchetype> archetypes;
+    std::vector<uint32_t> bodyArchetypes;
+    std::vector<const PhysicsObject*> bodies;
+    bodies.reserve(objects.size());
+    bodyArchetypes.reserve(objects.size());
+
+    for (const auto& obj : objects) {
+        if (!obj.rigidBody) continue;
+
+        int proxyType = 0;
+        btVector3 dimensions;
+        if (!shapeCache.describe(obj.shape, proxyType, dimensions)) {
+            std::cerr << "Scene map: shape is not from the shape cache, body skipped" << std::endl;
+            continue;
+        }
+
+        const btRigidBody* body = obj.rigidBody;
+        SceneMapArchetype archetype = {};
+        archetype.proxyType = proxyType;
+        archetype.dimensions[0] = dimensions.x();
+        archetype.dimensions[1] = dimensions.y();
+        archetype.dimensions[2] = dimensions.z();
+        archetype.type = obj.type;
+        archetype.mass = body->getMass();
+        archetype.friction = body->getFriction();
+        archetype.restitution = body->getRestitution();
+        archetype.rollingFriction = body->getRollingFriction();
+        archetype.spinningFriction = body->getSpinningFriction();
+        archetype.linearDamping = body->getLinearDamping();
+        archetype.angularDamping = body->getAngularDamping();
+        archetype.ccdMotionThreshold = body->getCcdMotionThreshold();
+        archetype.ccdSweptSphereRadius = body->getCcdSweptSphereRadius();
+
+        uint32_t index = 0;
+        while (index < archetypes.size() && !sameArchetype(archetypes[index], archetype)) {
+            ++index;
+        }
+        if (index == archetypes.size()) {
+            archetypes.push_back(archetype);
+        }
+        ++archetypes[index].bodyCount;
+        bodies.push_back(&obj);
+        bodyArchetypes.push_back(index);
+    }
+
+    // Сортировка подсчетом: тела одного архетипа ложатся подряд
+    uint32_t first = 0;
+    for (auto& archetype : archetypes) {
+        archetype.firstBody = first;
+        first += archetype.bodyCount;
+    }
+
+    const size_t count = bodies.size();
+    std::vector<float> positions(count * 3);
+    std::vector<float> rotations(count * 4);
+    std::vector<float> linearVelocities(count * 3);
+    std::vector<float> angularVelocities(count * 3);
+    std::vector<int32_t> activationStates(count);
+    std::vector<float> deactivationTimes(count);
+    std::vector<float> colors(count * 3);
+    std::vector<uint32_t> cursor(archetypes.size());
+    for (size_t a = 0; a < archetypes.size(); ++a) {
+        cursor[a] = archetypes[a].firstBody;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        const PhysicsObject& obj = *bodies[i];
+        const btRigidBody* body = obj.rigidBody;
+        const btTransform& transform = body->getWorldTransform();
+        btQuaternion rotation = transform.getRotation();
+        size_t k = cursor[bodyArchetypes[i]]++;
+
+        for (int c = 0; c < 3; ++c) {
+            positions[k * 3 + c] = transform.getOrigin()[c];
+            linearVelocities[k * 3 + c] = body->getLinearVelocity()[c];
+            angularVelocities[k * 3 + c] = body->getAngularVelocity()[c];
+        }
+        rotations[k * 4 + 0] = rotation.x();
+        rotations[k * 4 + 1] = rotation.y();
+        rotations[k * 4 + 2] = rotation.z();
+        rotations[k * 4 + 3] = rotation.w();
+        activationStates[k] = body->getActivationState();
+        deactivationTimes[k] = body->getDeactivationTime();
+        colors[k * 3 + 0] = obj.color.x;
+        colors[k * 3 + 1] = obj.color.y;
+        colors[k * 3 + 2] = obj.color.z;
+    }
+
+    SceneMapHeader header;
+    computeSceneMapLayout(static_cast<uint32_t>(count), static_cast<uint32_t>(archetypes.size()), header);
+
+    std::ofstream out(path, std::ios::binary);
+    if (!out.is_open()) {
+        std::cerr << "Cannot open scene file: " << path << std::endl;
+        return false;
+    }
+    writeArray(out, 0, &header, sizeof(header));
+    writeArray(out, header.archetypeOffset, archetypes.data(), archetypes.size() * sizeof(SceneMapArchetype));
+    writeArray(out, header.positionOffset, positions.data(), positions.size() * sizeof(float));
+    writeArray(out, header.rotationOffset, rotations.data(), rotations.size() * sizeof(float));
+    writeArray(out, header.linearVelocityOffset, linearVelocities.data(), linearVelocities.size() * sizeof(float));
+    writeArray(out, header.angularVelocityOffset, angularVelocities.data(), angularVelocities.size() * sizeof(float));
+    writeArray(out, header.activationStateOffset, activationStates.data(), activationStates.size() * sizeof(int32_t));
+    writeArray(out, header.deactivationTimeOffset, deactivationTimes.data(), deactivationTimes.size() * sizeof(float));
+    writeArray(out, header.colorOffset, colors.data(), colors.size() * sizeof(float));
+    return out.good();
+}
+
+bool PhysicsWorld::loadSceneMap(const MappedScene& scene, std::vector<PhysicsObject>& objects) {
+    if (!scene.isOpen()) return false;
+
+    removeObjects(objects, false);
+    objects.clear();
+
+    const uint32_t count = scene.getBodyCount();
+    objects.reserve(count);
+    dynamicBodies.reserve(dynamicBodies.size() + count);
+    bodyPool.reserve(bodyPool.size() + count);
+    motionStatePool.reserve(motionStatePool.size() + count);
+
+    const float* positions = scene.getPositions();
+    const float* rotations = scene.getRotations();
+    const float* linearVelocities = scene.getLinearVelocities();
+    const float* angularVelocities = scene.getAngularVelocities();
+    const float* colors = scene.getColors();
+    const int32_t* activationStates = scene.getActivationStates();
+    const float* deactivationTimes = scene.getDeactivationTimes();
+    const SceneMapArchetype* archetypes = scene.getArchetypes();
+
+    for (uint32_t a = 0; a < scene.getArchetypeCount(); ++a) {
+        const SceneMapArchetype& archetype = archetypes[a];
+        if (archetype.bodyCount == 0) continue;
+
+        // Форма и инерция берутся один раз на весь диапазон тел
+        btCollisionShape* shape = shapeCache.acquire(archetype.proxyType,
+            btVector3(archetype.dimensions[0], archetype.dimensions[1], archetype.dimensions[2]),
+            static_cast<int>(archetype.bodyCount));
+        if (!shape) continue;
+
+        btRigidBody::btRigidBodyConstructionInfo rbInfo(archetype.mass, nullptr, shape,
+            shapeCache.getLocalInertia(shape, archetype.mass));
+        rbInfo.m_friction = archetype.friction;
+        rbInfo.m_restitution = archetype.restitution;
+        rbInfo.m_rollingFriction = archetype.rollingFriction;
+        rbInfo.m_spinningFriction = archetype.spinningFriction;
+        rbInfo.m_linearDamping = archetype.linearDamping;
+        rbInfo.m_angularDamping = archetype.angularDamping;
+
+        const uint32_t end = archetype.firstBody + archetype.bodyCount;
+        for (uint32_t i = archetype.firstBody; i < end; ++i) {
+            const float* p = positions + i * 3;
+            const float* q = rotations + i * 4;
+            const float* v = linearVelocities + i * 3;
+            const float* w = angularVelocities + i * 3;
+            const float* c = colors + i * 3;
+
+            btTransform transform(btQuaternion(q[0], q[1], q[2], q[3]), btVector3(p[0], p[1], p[2]));
+
+            PhysicsObject obj;
+            obj.type = archetype.type;
+            obj.color = glm::vec3(c[0], c[1], c[2]);
+            obj.shape = shape;
+            obj.motionState = createMotionState(transform);
+            rbInfo.m_motionState = obj.motionState;
+
+            obj.rigidBody = createRigidBody(rbInfo);
+            obj.rigidBody->setLinearVelocity(btVector3(v[0], v[1], v[2]));
+            obj.rigidBody->setAngularVelocity(btVector3(w[0], w[1], w[2]));
+            obj.rigidBody->setCcdMotionThreshold(archetype.ccdMotionThreshold);
+            obj.rigidBody->setCcdSweptSphereRadius(archetype.ccdSweptSphereRadius);
+            configureSleeping(obj.rigidBody);
+            addObject(obj, objects);
+
+            // Как и в снимке: уснувшая куча загружается спящей
+            if (sleepingEnabled && activationStates[i] != DISABLE_DEACTIVATION) {
+                obj.rigidBody->forceActivationState(activationStates[i]);
+                obj.rigidBody->setDeactivationTime(deactivationTimes[i]);
+            }
+        }
+    }
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+
+// Двоичный формат снимка сцены (порядок байт машины, где файл записан):
+//   SnapshotHeader
+//   settingsSize байт настроек в текстовом виде serializeSettings
+//   archetypeCount x SnapshotArchetype
+//   bodyCount x SnapshotBody
+// Тела ссылаются на формы по индексу архетипа, поэтому общие формы
+// восстанавливаются через ShapeCache так же, как при обычном создании.
+const char SNAPSHOT_MAGIC[4] = { 'W', 'C', 'P', 'S' };
+const uint32_t SNAPSHOT_VERSION = 1;
+
+struct SnapshotHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t settingsSize;
+    uint32_t archetypeCount;
+    uint32_t bodyCount;
+    uint32_t tickCount;
+};
+
+struct SnapshotArchetype {
+    int32_t proxyType;
+    float dimensions[3];
+};
+
+struct SnapshotBody {
+    uint32_t archetype;
+    int32_t type;
+    float color[3];
+    float mass;
+    float friction;
+    float restitution;
+    float rollingFriction;
+    float spinningFriction;
+    float linearDamping;
+    float angularDamping;
+    float ccdMotionThreshold;
+    float ccdSweptSphereRadius;
+    float position[3];
+    float rotation[4]; // кватернион x, y, z, w
+    float linearVelocity[3];
+    float angularVelocity[3];
+    int32_t activationState;
+    float deactivationTime;
+};
\ No newline at end of file